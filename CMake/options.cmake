@@ -458,6 +458,12 @@ mark_as_advanced(FLTK_USE_POLL)
 
 if(FLTK_USE_POLL)
   check_symbol_exists(poll   "poll.h"   USE_POLL)
+  if(USE_POLL)
+    # ppoll() is a GNU extension (Linux), used for sub-millisecond timeouts
+    set(CMAKE_REQUIRED_DEFINITIONS -D_GNU_SOURCE)
+    check_symbol_exists(ppoll  "poll.h"   HAVE_PPOLL)
+    unset(CMAKE_REQUIRED_DEFINITIONS)
+  endif(USE_POLL)
 endif(FLTK_USE_POLL)
 
 #######################################################################
@@ -531,6 +537,23 @@ else(FLTK_OPTION_PEN_SUPPORT)  # option disabled by user
   set(FLTK_HAVE_PEN_SUPPORT 0)
 endif(FLTK_OPTION_PEN_SUPPORT)
 
+#######################################################################
+# Event loop instrumentation (Fl_Event_Stats)
+#
+# CMake variables:
+#  - FLTK_OPTION_EVENT_STATS: user option (cache; default OFF)
+#  - FLTK_HAVE_EVENT_STATS  : final result, used to set config variable
+#                             in fl_config.h
+
+option(FLTK_OPTION_EVENT_STATS "instrument the event loop (Fl_Event_Stats)" OFF)
+mark_as_advanced(FLTK_OPTION_EVENT_STATS)
+
+if(FLTK_OPTION_EVENT_STATS)
+  set(FLTK_HAVE_EVENT_STATS 1)
+else()
+  set(FLTK_HAVE_EVENT_STATS 0)
+endif()
+
 #######################################################################
 if(DOXYGEN_FOUND)
   option(FLTK_BUILD_HTML_DOCS "build html docs" ON)
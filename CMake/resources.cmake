@@ -133,6 +133,7 @@ fl_find_header(HAVE_STDIO_H stdio.h)
 fl_find_header(HAVE_STRINGS_H strings.h)
 fl_find_header(HAVE_SYS_SELECT_H sys/select.h)
 fl_find_header(HAVE_SYS_STDTYPES_H sys/stdtypes.h)
+fl_find_header(HAVE_SYS_EVENTFD_H sys/eventfd.h)
 
 fl_find_header(HAVE_X11_XREGION_H "X11/Xlib.h;X11/Xregion.h")
 
@@ -0,0 +1,89 @@
+//
+//      Fl_Virtual_Browser with a very large number of rows.
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+#include <stdio.h>
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Virtual_Browser.H>
+#include <FL/Fl_Button.H>
+#include <FL/Fl_Box.H>
+
+// The browser doesn't store any rows: the text is made up when a row is drawn
+//
+static const char *row_text(Fl_Virtual_Browser *, int index, void *) {
+  static char buf[80];
+  snprintf(buf, sizeof(buf), "Row %d, square: %lld", index, (long long)index * index);
+  return buf;
+}
+
+static Fl_Virtual_Browser *browser = 0;
+static Fl_Box *status = 0;
+
+static void update_status() {
+  static char buf[120];
+  snprintf(buf, sizeof(buf), "%d rows, %d selected, current row: %d",
+           browser->size(), browser->nselected(), browser->value());
+  status->label(buf);
+}
+
+// Changes the number of rows, e.g. after a new query
+//    Selected rows beyond the new size are deselected.
+//
+static void size_cb(Fl_Widget *, void *data) {
+  browser->size((int)(fl_intptr_t)data);
+  update_status();
+}
+
+// Selects 10 million rows at once
+//
+static void select_cb(Fl_Widget *, void *) {
+  browser->select_range(1000, 10000999);
+  update_status();
+}
+
+static void jump_cb(Fl_Widget *, void *) {
+  browser->display(browser->size() / 2);
+}
+
+static void browser_cb(Fl_Widget *, void *) {
+  update_status();
+}
+
+int main(int argc, char *argv[]) {
+  Fl_Double_Window *win = new Fl_Double_Window(520, 400, "Virtual Browser");
+  browser = new Fl_Virtual_Browser(10, 10, 500, 310);
+  browser->type(FL_MULTI_BROWSER);
+  browser->text_callback(row_text);
+  browser->callback(browser_cb);
+  browser->size(100000000);                     // 100 million rows
+  status = new Fl_Box(10, 325, 500, 25);
+  status->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  Fl_Button *b;
+  b = new Fl_Button(10, 360, 90, 30, "100M rows");
+  b->callback(size_cb, (void *)(fl_intptr_t)100000000);
+  b = new Fl_Button(110, 360, 90, 30, "1000 rows");
+  b->callback(size_cb, (void *)(fl_intptr_t)1000);
+  b = new Fl_Button(210, 360, 90, 30, "No rows");
+  b->callback(size_cb, (void *)(fl_intptr_t)0);
+  b = new Fl_Button(310, 360, 90, 30, "Select 10M");
+  b->callback(select_cb);
+  b = new Fl_Button(410, 360, 100, 30, "Go to middle");
+  b->callback(jump_cb);
+  win->end();
+  win->resizable(browser);
+  update_status();
+  win->show(argc, argv);
+  return Fl::run();
+}
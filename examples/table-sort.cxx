@@ -33,7 +33,6 @@
 #include <ctype.h>
 #include <string>
 #include <vector>
-#include <algorithm>            // STL sort
 
 #define MARGIN 20
 
@@ -66,25 +65,24 @@ public:
     std::vector<std::string> cols;
 };
 
-// Sort class to handle sorting column using std::sort
+// Compares a column of two rows for Fl_Table_Row::sort_rows()
 class SortColumn {
-    int _col, _reverse;
 public:
-    SortColumn(int col, int reverse) {
-        _col = col;
-        _reverse = reverse;
-    }
-    bool operator()(const Row &a, const Row &b) {
-        const char *ap = ( _col < (int)a.cols.size() ) ? a.cols[_col].c_str() : "",
-                   *bp = ( _col < (int)b.cols.size() ) ? b.cols[_col].c_str() : "";
+    const std::vector<Row> *rows;
+    int col;
+    static int compare(int ra, int rb, void *data) {
+        SortColumn *s = (SortColumn*)data;
+        const Row &a = (*s->rows)[ra], &b = (*s->rows)[rb];
+        const char *ap = ( s->col < (int)a.cols.size() ) ? a.cols[s->col].c_str() : "",
+                   *bp = ( s->col < (int)b.cols.size() ) ? b.cols[s->col].c_str() : "";
         if ( isdigit(*ap) && isdigit(*bp) ) {           // cheezy detection of numeric data
             // Numeric sort
             int av=0; sscanf(ap, "%d", &av);
             int bv=0; sscanf(bp, "%d", &bv);
-            return( _reverse ? av < bv : bv < av );
+            return( av < bv ? -1 : av > bv );
         } else {
             // Alphabetic sort
-            return( _reverse ? strcmp(ap, bp) > 0 : strcmp(ap, bp) < 0 );
+            return( strcmp(ap, bp) );
         }
     }
 };
@@ -120,9 +118,14 @@ public:
 };
 
 // Sort a column up or down
+//     Only the order of the rows in the table changes, rowdata_ is not moved.
+//     draw_cell() uses row_index() to find the data of a row.
+//
 void MyTable::sort_column(int col, int reverse) {
-    std::sort(rowdata_.begin(), rowdata_.end(), SortColumn(col, reverse));
-    redraw();
+    SortColumn sc;
+    sc.rows = &rowdata_;
+    sc.col = col;
+    sort_rows(SortColumn::compare, &sc, reverse);
 }
 
 // Draw sort arrow
@@ -152,8 +155,9 @@ void MyTable::draw_sort_arrow(int X,int Y,int W,int H) {
 // Handle drawing all cells in table
 void MyTable::draw_cell(TableContext context, int R, int C, int X, int Y, int W, int H) {
     const char *s = "";
-    if ( R < (int)rowdata_.size() && C < (int)rowdata_[R].cols.size() )
-        s = rowdata_[R].cols[C].c_str();
+    int D = ( context == CONTEXT_CELL ) ? row_index(R) : R;    // data shown in row R
+    if ( D < (int)rowdata_.size() && C < (int)rowdata_[D].cols.size() )
+        s = rowdata_[D].cols[C].c_str();
     switch ( context ) {
         case CONTEXT_COL_HEADER:
             fl_push_clip(X,Y,W,H); {
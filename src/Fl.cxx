@@ -24,6 +24,8 @@
 #include "Fl_Window_Driver.H"
 #include "Fl_System_Driver.H"
 #include "Fl_Timeout.h"
+#include "Fl_Event_Stats_Scope.H"
+#include "Fl_Layout_Queue.H"
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/fl_draw.H>
@@ -555,6 +557,7 @@ void Fl::Private::run_checks()
     while (next_check) {
       Check* checkp = next_check;
       next_check = checkp->next;
+      FL_EVENT_STATS_SCOPE(CHECK, checkp->cb);
       (checkp->cb)(checkp->arg);
     }
     next_check = first_check;
@@ -891,8 +894,13 @@ void Fl::redraw() {
   from the main thread. If a child thread needs to trigger a redraw event,
   it should instead call Fl::awake() to get the main thread to process the
   event queue.
+
+  Before any window is drawn the pending layouts of Fl_Flex and Fl_Grid
+  widgets are calculated, outer widgets first.
 */
 void Fl::flush() {
+  FL_EVENT_STATS_SCOPE(FLUSH, 0);
+  Fl_Layout_Queue::run();
   if (damage()) {
     damage_ = 0;
     for (Fl_X* i = Fl_X::first; i; i = i->next) {
@@ -900,6 +908,7 @@ void Fl::flush() {
       if (Fl_Window_Driver::driver(wi)->wait_for_expose_value) {damage_ = 1; continue;}
       if (!wi->visible_r()) continue;
       if (wi->damage()) {
+        FL_EVENT_STATS_WINDOW_SCOPE(wi);
         Fl_Window_Driver::driver(wi)->flush();
         wi->clear_damage();
       }
@@ -1441,6 +1450,7 @@ Fl_Event_Dispatch Fl::event_dispatch()
  */
 int Fl::handle(int e, Fl_Window* window)
 {
+  FL_EVENT_STATS_SCOPE(HANDLE, 0);
   if (e_dispatch) {
     return e_dispatch(e, window);
   } else {
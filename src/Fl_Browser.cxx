@@ -18,8 +18,14 @@
 #include <FL/Fl_Browser.H>
 #include <FL/fl_draw.H>
 #include "flstring.h"
+#include "Fl_Browser_Index.H"
+#include "Fl_Browser_Store.H"
+#include "Fl_Filter_Index.H"
+#include <stddef.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
+#include <vector>
 
 #include <FL/Fl_Hold_Browser.H>
 #include <FL/Fl_Multi_Browser.H>
@@ -30,21 +36,54 @@
 // so that the number of items in the browser and size of those items
 // is unlimited. The only problem is that the old browser used an
 // index number to identify a line, and it is slow to convert from/to
-// a pointer. I use a cache of the last match to try to speed this up.
+// a pointer. An additional index (Fl_Browser_Index) stores the lines
+// and their heights in chunks, so this takes O(log n).
 
 // Also added the ability to "hide" a line. This sets its height to
 // zero, so the Fl_Browser_ cannot pick it.
 
+// The lines are allocated by an Fl_Browser_Store, which packs them into
+// large blocks. Parsing the format characters of a line to measure it is
+// slow, so the line caches its width and height. The cached values belong
+// to a generation of the store, which changes when the browser settings
+// they depend on change (see bline_measure()).
+
 struct FL_BLINE {       // data is in a linked list of these
   FL_BLINE* prev;
   FL_BLINE* next;
+  Fl_Browser_Index::Chunk* chunk; // chunk of the index containing this line
   void* data;
   Fl_Image* icon;
-  short length;         // allocated size of txt[] (excl. null terminator); current string may be shorter
+  int width;            // cached item_width(), or -1
+  short height;         // cached item_height(), or -1
+  unsigned short generation; // store generation of width and height, 0 if none
+  int length;           // allocated size of txt[] (excl. null terminator); current string may be shorter
   char flags;           // selected, displayed
   char txt[1];          // start of allocated array
 };
 
+// Size of a line with room for l characters of text
+static size_t bline_size(int l) {
+  return offsetof(FL_BLINE, txt) + l + 1;
+}
+
+// Allocates a line for newtext, using all the space the store provides
+static FL_BLINE* new_bline(Fl_Browser_Store* store, const char* newtext) {
+  int l = (int) strlen(newtext);
+  size_t size = Fl_Browser_Store::round(bline_size(l));
+  FL_BLINE* t = (FL_BLINE*)store->alloc(size);
+  t->length = (int)(size - bline_size(0));
+  t->generation = 0;
+  t->flags = 0;
+  strcpy(t->txt, newtext);
+  return t;
+}
+
+// Returns a line to the store
+static void free_bline(Fl_Browser_Store* store, FL_BLINE* t) {
+  store->release(t, bline_size(t->length));
+}
+
 /** Get writable reference to FL_BLINE data. */
 void*& Fl_Browser::bline_data(FL_BLINE* b) const {
   return b->data;
@@ -65,8 +104,10 @@ char Fl_Browser::bline_flags(const FL_BLINE* b) const {
   return b->flags;
 }
 
-/** Get writable reference to FL_BLINE text. */
+/** Get writable reference to FL_BLINE text.
+    The cached size of the line is discarded, since the text may change. */
 char* Fl_Browser::bline_txt(FL_BLINE* b) const {
+  b->generation = 0;
   return b->txt;
 }
 
@@ -75,8 +116,10 @@ const char* Fl_Browser::bline_txt(const FL_BLINE* b) const {
   return b->txt;
 }
 
-/** Get writable reference to FL_BLINE icon. */
+/** Get writable reference to FL_BLINE icon.
+    The cached size of the line is discarded, since the icon may change. */
 Fl_Image*& Fl_Browser::bline_icon(FL_BLINE* b) const {
+  b->generation = 0;
   return b->icon;
 }
 
@@ -87,7 +130,45 @@ const Fl_Image* Fl_Browser::bline_icon(const FL_BLINE* b) const {
 
 /** Get FL_BLINE allocated text buffer size (excl. null terminator). */
 short Fl_Browser::bline_length(const FL_BLINE* b) const {
-  return b->length;
+  return (short)b->length;
+}
+
+// Discards the cached width and height of a line if they were measured
+// with other browser settings
+void Fl_Browser::bline_measure(FL_BLINE* b) const {
+  unsigned short g = store_->generation(textfont(), textsize(), format_char_,
+                                        column_char_, column_widths_);
+  if (b->generation != g) {
+    b->generation = g;
+    b->width = -1;
+    b->height = -1;
+  }
+}
+
+// Height of a line in the index: hidden lines don't use any space
+int Fl_Browser::bline_height(FL_BLINE* b) const {
+  if (b->flags & (BLINE_NOTDISPLAYED|BLINE_FILTERED)) return 0;
+  return item_height(b) + linespacing();
+}
+
+// Skips the format characters at the start of a column, like item_draw()
+static const char* skip_format(const char* str, char format_char) {
+  if (!format_char) return str;
+  while (*str == format_char && *++str && *str != format_char) {
+    switch (*str++) {
+      case 'B':
+      case 'C': while (isdigit(*str & 255)) str++; break;
+      case 'F':
+      case 'S': { char* e; strtol(str, &e, 10); str = e; } break;
+      case '.': return str;
+    }
+  }
+  return str;
+}
+
+// Called by Fl_Browser_Index when a line is stored in a chunk
+static void set_chunk(void* item, Fl_Browser_Index::Chunk* chunk) {
+  ((FL_BLINE*)item)->chunk = chunk;
 }
 
 
@@ -167,13 +248,10 @@ const char *Fl_Browser::item_text(void *item) const {
 /**
   Returns the item for specified \p line.
 
-  Note: This call is slow. It's fine for e.g. responding to user
-  clicks, but slow if called often, such as in a tight sorting loop.
-  Finding an item 'by line' involves a linear lookup on the internal
-  linked list. The performance hit can be significant if the browser's
-  contents is large, and the method is called often (e.g. during a sort).
-  If you're writing a subclass, use the protected methods item_first(),
-  item_next(), etc. to access the internal linked list more efficiently.
+  Note: Finding an item 'by line' uses an index of the lines and takes
+  O(log n) time. If you're writing a subclass and need to walk through
+  all items, the protected methods item_first(), item_next(), etc. that
+  access the internal linked list are still more efficient.
 
   \param[in] line The line number of the item to return. (1 based)
   \retval item that was found.
@@ -181,20 +259,7 @@ const char *Fl_Browser::item_text(void *item) const {
   \see item_at(), find_line(), lineno()
 */
 FL_BLINE* Fl_Browser::find_line(int line) const {
-  int n; FL_BLINE* l;
-  if (line == cacheline) return cache;
-  if (cacheline && line > (cacheline/2) && line < ((cacheline+lines)/2)) {
-    n = cacheline; l = cache;
-  } else if (line <= (lines/2)) {
-    n = 1; l = first;
-  } else {
-    n = lines; l = last;
-  }
-  for (; n < line && l; n++) l = l->next;
-  for (; n > line && l; n--) l = l->prev;
-  ((Fl_Browser*)this)->cacheline = line;
-  ((Fl_Browser*)this)->cache = l;
-  return l;
+  return (FL_BLINE*)index_->item(line-1);
 }
 
 /**
@@ -207,28 +272,9 @@ FL_BLINE* Fl_Browser::find_line(int line) const {
 int Fl_Browser::lineno(void *item) const {
   FL_BLINE* l = (FL_BLINE*)item;
   if (!l) return 0;
-  if (l == cache) return cacheline;
   if (l == first) return 1;
   if (l == last) return lines;
-  if (!cache) {
-    ((Fl_Browser*)this)->cache = first;
-    ((Fl_Browser*)this)->cacheline = 1;
-  }
-  // assume it is near cache, search both directions:
-  FL_BLINE* b = cache->prev;
-  int bnum = cacheline-1;
-  FL_BLINE* f = cache->next;
-  int fnum = cacheline+1;
-  int n = 0;
-  for (;;) {
-    if (b == l) {n = bnum; break;}
-    if (f == l) {n = fnum; break;}
-    if (b) {b = b->prev; bnum--;}
-    if (f) {f = f->next; fnum++;}
-  }
-  ((Fl_Browser*)this)->cache = l;
-  ((Fl_Browser*)this)->cacheline = n;
-  return n;
+  return index_->index(l, l->chunk) + 1;
 }
 
 /**
@@ -242,11 +288,10 @@ int Fl_Browser::lineno(void *item) const {
 FL_BLINE* Fl_Browser::_remove(int line) {
   FL_BLINE* ttt = find_line(line);
   deleting(ttt);
+  if (filter_) filter_->invalidate();
 
-  cacheline = line-1;
-  cache = ttt->prev;
+  index_->remove(line-1);
   lines--;
-  full_height_ -= item_height(ttt) + linespacing();
   if (ttt->prev) ttt->prev->next = ttt->next;
   else first = ttt->next;
   if (ttt->next) ttt->next->prev = ttt->prev;
@@ -264,7 +309,7 @@ FL_BLINE* Fl_Browser::_remove(int line) {
 */
 void Fl_Browser::remove(int line) {
   if (line < 1 || line > lines) return;
-  free(_remove(line));
+  free_bline(store_, _remove(line));
 }
 
 /**
@@ -299,10 +344,9 @@ void Fl_Browser::insert(int line, FL_BLINE* item) {
     item->prev->next = item;
     n->prev = item;
   }
-  cacheline = line;
-  cache = item;
+  index_->insert(line-1, item, bline_height(item));
   lines++;
-  full_height_ += item_height(item) + linespacing();
+  if (filter_) filter_->invalidate();
   redraw_line(item);
 }
 
@@ -321,11 +365,7 @@ void Fl_Browser::insert(int line, FL_BLINE* item) {
 */
 void Fl_Browser::insert(int line, const char* newtext, void* d) {
   if (!newtext) newtext = "";           // STR #3269
-  int l = (int) strlen(newtext);
-  FL_BLINE* t = (FL_BLINE*)malloc(sizeof(FL_BLINE)+l);
-  t->length = (short)l;
-  t->flags = 0;
-  strcpy(t->txt, newtext);
+  FL_BLINE* t = new_bline(store_, newtext);
   t->data = d;
   t->icon = 0;
   insert(line, t);
@@ -359,21 +399,24 @@ void Fl_Browser::text(int line, const char* newtext) {
   if (!newtext) newtext = "";           // STR #3269
   int l = (int) strlen(newtext);
   if (l > t->length) {
-    FL_BLINE* n = (FL_BLINE*)malloc(sizeof(FL_BLINE)+l);
+    FL_BLINE* n = new_bline(store_, newtext);
     replacing(t, n);
-    cache = n;
+    index_->replace(line-1, n);
     n->data = t->data;
     n->icon = t->icon;
-    n->length = (short)l;
     n->flags = t->flags;
     n->prev = t->prev;
     if (n->prev) n->prev->next = n; else first = n;
     n->next = t->next;
     if (n->next) n->next->prev = n; else last = n;
-    free(t);
+    free_bline(store_, t);
     t = n;
+  } else {
+    strcpy(t->txt, newtext);
+    t->generation = 0;
   }
-  strcpy(t->txt, newtext);
+  if (filter_) filter_->invalidate();
+  index_->height(line-1, bline_height(t)); // format characters may change the height
   redraw_line(t);
 }
 
@@ -398,7 +441,9 @@ void Fl_Browser::data(int line, void* d) {
 */
 int Fl_Browser::item_height(void *item) const {
   FL_BLINE* l = (FL_BLINE*)item;
-  if (l->flags & BLINE_NOTDISPLAYED) return 0;
+  if (l->flags & (BLINE_NOTDISPLAYED|BLINE_FILTERED)) return 0;
+  bline_measure(l);
+  if (l->height >= 0) return l->height;
 
   int hmax = 2; // use 2 to insure we don't return a zero!
 
@@ -445,6 +490,7 @@ int Fl_Browser::item_height(void *item) const {
   if (l->icon && (l->icon->h()+2)>hmax) {
     hmax = l->icon->h() + 2;    // leave 2px above/below
   }
+  l->height = (short)hmax;
   return hmax; // previous version returned hmax+2!
 }
 
@@ -458,6 +504,8 @@ int Fl_Browser::item_height(void *item) const {
 */
 int Fl_Browser::item_width(void *item) const {
   FL_BLINE* l=(FL_BLINE*)item;
+  bline_measure(l);
+  if (l->width >= 0) return l->width;
   char* str = l->txt;
   const int* i = column_widths();
   int ww = 0;
@@ -504,7 +552,8 @@ int Fl_Browser::item_width(void *item) const {
   if (ww==0 && l->icon) ww = l->icon->w();
 
   fl_font(font, tsize);
-  return ww + int(fl_width(str)) + 6;
+  l->width = ww + int(fl_width(str)) + 6;
+  return l->width;
 }
 
 /**
@@ -516,7 +565,30 @@ int Fl_Browser::item_width(void *item) const {
        incr_height(), full_height()
 */
 int Fl_Browser::full_height() const {
-  return full_height_;
+  return index_->total_height();
+}
+
+/**
+  Returns the item at vertical position \p ypos using the line index.
+  \param[in] ypos vertical position in the list (0 = top of first line)
+  \param[out] item_ypos vertical position of the returned item
+  \returns The item, or NULL if the browser is empty.
+*/
+void* Fl_Browser::item_at_ypos(int ypos, int &item_ypos) const {
+  int i = index_->find(ypos, item_ypos);
+  return i < 0 ? 0 : index_->item(i);
+}
+
+/**
+  Returns the vertical position of \p item in the list.
+  \param[in] item The item whose position is returned
+  \returns The position of the top of \p item, or -1 if not known.
+*/
+int Fl_Browser::item_ypos(void *item) const {
+  if (!item) return -1;
+  FL_BLINE *l = (FL_BLINE*)item;
+  int i = index_->index(l, l->chunk);
+  return i < 0 ? -1 : index_->ypos(i);
 }
 
 /**
@@ -638,11 +710,22 @@ Fl_Browser::Fl_Browser(int X, int Y, int W, int H, const char *L)
 : Fl_Browser_(X, Y, W, H, L) {
   column_widths_ = no_columns;
   lines = 0;
-  full_height_ = 0;
-  cacheline = 0;
   format_char_ = '@';
   column_char_ = '\t';
-  first = last = cache = 0;
+  first = last = 0;
+  index_ = new Fl_Browser_Index(set_chunk);
+  store_ = new Fl_Browser_Store;
+  filter_ = 0;
+}
+
+/**
+  The destructor deletes all list items and destroys the browser.
+*/
+Fl_Browser::~Fl_Browser() {
+  clear();
+  delete index_;
+  delete store_;
+  delete filter_;
 }
 
 /**
@@ -654,13 +737,8 @@ Fl_Browser::Fl_Browser(int X, int Y, int W, int H, const char *L)
 void Fl_Browser::lineposition(int line, Fl_Line_Position pos) {
   if (line<1) line = 1;
   if (line>lines) line = lines;
-  int p = 0;
-
-  FL_BLINE* l;
-  for (l=first; l && line>1; l = l->next) {
-    line--; p += item_height(l) + linespacing();
-  }
-  if (l && (pos == BOTTOM)) p += item_height(l) + linespacing();
+  int p = index_->ypos(line-1);
+  if (lines && (pos == BOTTOM)) p += index_->height(line-1);
 
   int final = p, X, Y, W, H;
   bbox(X, Y, W, H);
@@ -705,11 +783,29 @@ void Fl_Browser::textsize(Fl_Fontsize newSize) {
     return; // avoid recalculation
   Fl_Browser_::textsize(newSize);
   new_list();
-  full_height_ = 0;
+  update_heights();
+}
+
+/**
+  Recalculates the heights of all lines.
+
+  Subclasses must call this when they change a setting that item_height()
+  depends on, because the heights of all lines are stored in an index that
+  is only updated when lines are changed. This takes O(n).
+*/
+void Fl_Browser::update_heights() {
   if (lines == 0) return;
-  for (FL_BLINE* itm=(FL_BLINE *)item_first(); itm; itm=(FL_BLINE *)item_next(itm)) {
-    full_height_ += item_height(itm) + linespacing();
+  FL_BLINE** items = (FL_BLINE**)malloc(lines * sizeof(FL_BLINE*));
+  int* heights = (int*)malloc(lines * sizeof(int));
+  int n = 0;
+  for (FL_BLINE* l = first; l; l = l->next) {
+    items[n] = l;
+    heights[n++] = bline_height(l);
   }
+  index_->clear();
+  index_->append((void* const*)items, heights, n);
+  free(items);
+  free(heights);
 }
 
 /**
@@ -717,12 +813,9 @@ void Fl_Browser::textsize(Fl_Fontsize newSize) {
   \see add(), insert(), remove(), swap(int,int), clear()
 */
 void Fl_Browser::clear() {
-  for (FL_BLINE* l = first; l;) {
-    FL_BLINE* n = l->next;
-    free(l);
-    l = n;
-  }
-  full_height_ = 0;
+  store_->clear();
+  index_->clear();
+  if (filter_) filter_->invalidate();
   first = 0;
   last = 0;
   lines = 0;
@@ -746,6 +839,42 @@ void Fl_Browser::add(const char* newtext, void* d) {
   //Fl_Browser_::display(last);
 }
 
+/**
+  Adds \p n new lines to the end of the browser.
+
+  This is the same as calling add(const char*, void*) \p n times but
+  faster for many lines, since the line index is extended in one step
+  and redraw() is called only once.
+
+  \param[in] newtexts Array of \p n label texts, NULL entries make blank lines
+  \param[in] n Number of lines to add
+  \param[in] d Optional array of \p n user data() pointers (may be NULL)
+  \see add(), insert(), load()
+*/
+void Fl_Browser::add_lines(const char* const* newtexts, int n, void* const* d) {
+  if (n <= 0) return;
+  FL_BLINE** items = (FL_BLINE**)malloc(n * sizeof(FL_BLINE*));
+  int* heights = (int*)malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) {
+    FL_BLINE* t = new_bline(store_, newtexts[i] ? newtexts[i] : "");
+    t->data = d ? d[i] : 0;
+    t->icon = 0;
+    t->next = 0;
+    t->prev = last;
+    if (last) last->next = t;
+    else first = t;
+    last = t;
+    items[i] = t;
+    heights[i] = bline_height(t);
+  }
+  index_->append((void* const*)items, heights, n);
+  lines += n;
+  if (filter_) filter_->invalidate();
+  free(items);
+  free(heights);
+  redraw();
+}
+
 /**
   Returns the label text for the specified \p line.
   Return value can be NULL if \p line is out of range or unset.
@@ -807,7 +936,7 @@ void Fl_Browser::show(int line) {
   FL_BLINE* t = find_line(line);
   if (t->flags & BLINE_NOTDISPLAYED) {
     t->flags &= ~BLINE_NOTDISPLAYED;
-    full_height_ += item_height(t) + linespacing();
+    index_->height(line-1, bline_height(t));
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -824,8 +953,8 @@ void Fl_Browser::show(int line) {
 void Fl_Browser::hide(int line) {
   FL_BLINE* t = find_line(line);
   if (!(t->flags & BLINE_NOTDISPLAYED)) {
-    full_height_ -= item_height(t) + linespacing();
     t->flags |= BLINE_NOTDISPLAYED;
+    index_->height(line-1, 0);
     if (Fl_Browser_::displayed(t)) redraw();
   }
 }
@@ -849,7 +978,62 @@ void Fl_Browser::display(int line, int val) {
 */
 int Fl_Browser::visible(int line) const {
   if (line < 1 || line > lines) return 0;
-  return !(find_line(line)->flags & BLINE_NOTDISPLAYED);
+  return !(find_line(line)->flags & (BLINE_NOTDISPLAYED|BLINE_FILTERED));
+}
+
+/**
+  Shows only the lines that contain \p text and hides all others.
+
+  Lines hidden by the filter are independent of hide(int): show(int) does
+  not show them, and lines hidden with hide(int) stay hidden when they
+  match. The format characters at the start of a line are not searched.
+  Selected lines stay selected when they are hidden.
+
+  The browser keeps an index of the texts of all lines, so calling filter()
+  for each character the user types is fast: when \p text grows, only the
+  lines that matched before are searched, and the previous results are
+  reused when it shrinks again. Only lines whose state changed are updated.
+  Lines added or changed later are shown until filter() is called again.
+
+  The list is scrolled to the top if any line was shown or hidden.
+
+  \param[in] text The text to search for, NULL or "" shows all lines
+  \param[in] caseinsensitive Non-zero to ignore the case of letters
+  \returns The number of lines that contain \p text, including lines
+            hidden with hide(int)
+  \see hide(int), visible(int)
+*/
+int Fl_Browser::filter(const char* text, int caseinsensitive) {
+  if (!filter_ || !filter_->valid() ||
+      filter_->caseinsensitive() != (caseinsensitive != 0)) {
+    delete filter_;
+    filter_ = new Fl_Filter_Index(caseinsensitive != 0);
+    for (FL_BLINE* l = first; l; l = l->next)
+      filter_->add(l, skip_format(l->txt, format_char()));
+  }
+  std::vector<int> changed;
+  int count = filter_->match(text, changed);
+  int n = 0;
+  for (size_t k = 0; k < changed.size(); k++) {
+    FL_BLINE* l = (FL_BLINE*)filter_->item(changed[k]);
+    char flags = filter_->matched(changed[k]) ? (l->flags & ~BLINE_FILTERED)
+                                              : (l->flags | BLINE_FILTERED);
+    if (flags == l->flags) continue;
+    l->flags = flags;
+    changed[n++] = changed[k];
+  }
+  if (n == 0) return count;
+  if (n > lines / 64) {
+    update_heights();
+  } else {
+    for (int k = 0; k < n; k++) {
+      FL_BLINE* l = (FL_BLINE*)filter_->item(changed[k]);
+      index_->height(index_->index(l, l->chunk), bline_height(l));
+    }
+  }
+  vposition(0);
+  redraw();
+  return count;
 }
 
 /**
@@ -901,9 +1085,8 @@ void Fl_Browser::swap(FL_BLINE *a, FL_BLINE *b) {
      if ( bprev ) bprev->next = a; else first = a;
      a->next = bnext;
   }
-  // Disable cache -- we played around with positions
-  cacheline = 0;
-  cache = 0;
+  // swap the lines in the index
+  index_->swap(index_->index(a, a->chunk), index_->index(b, b->chunk));
 }
 
 /**
@@ -919,6 +1102,93 @@ void Fl_Browser::swap(int a, int b) {
   swap(ai,bi);
 }
 
+/**
+  Puts all lines in the order given by \p items at once, by relinking
+  them and rebuilding the line index.
+  \param[in] items All \p n lines in their new order
+  \param[in] n The number of lines
+*/
+void Fl_Browser::item_reorder(void **items, int n) {
+  if (n != lines) { Fl_Browser_::item_reorder(items, n); return; }
+  FL_BLINE** l = (FL_BLINE**)items;
+  int* heights = (int*)malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) {
+    l[i]->prev = i > 0 ? l[i-1] : 0;
+    l[i]->next = i < n-1 ? l[i+1] : 0;
+    heights[i] = bline_height(l[i]);
+  }
+  first = n ? l[0] : 0;
+  last = n ? l[n-1] : 0;
+  index_->clear();
+  index_->append(items, heights, n);
+  free(heights);
+}
+
+/**
+  Sort the lines by the text of one column.
+
+  The text of a column is the part of the line between two column_char()
+  separators, without the format characters at its start. Lines with
+  fewer columns sort as if the column was empty. Lines with equal
+  column texts keep their order. The selection stays with the lines.
+
+  \param[in] flags FL_SORT_ASCENDING or FL_SORT_DESCENDING, plus
+                   FL_SORT_CASEINSENSITIVE or FL_SORT_NUMERIC, see Fl_Browser_::sort(int)
+  \param[in] column The column to sort by (0 based)
+  \see sort(int), sort(Fl_Browser_Compare*, void*, int)
+*/
+void Fl_Browser::sort(int flags, int column) {
+  if (lines < 2) return;
+  void** items = (void**)malloc(lines * sizeof(void*));
+  const char** keys = (const char**)malloc(lines * sizeof(char*));
+  int* lengths = (int*)malloc(lines * sizeof(int));
+  int n = 0;
+  for (FL_BLINE* l = first; l; l = l->next, n++) {
+    const char* str = l->txt;
+    for (int c = 0; c < column && str; c++) {
+      str = strchr(str, column_char());
+      if (str) str++;
+    }
+    if (!str) str = "";
+    str = skip_format(str, format_char());
+    const char* e = strchr(str, column_char());
+    items[n] = l;
+    keys[n] = str;
+    lengths[n] = e ? (int)(e - str) : (int)strlen(str);
+  }
+  sort_items(items, keys, lengths, n, flags);
+  free(items);
+  free(keys);
+  free(lengths);
+}
+
+/**
+  Sort the lines with a comparison function.
+
+  \p compare is called with the text and data() of two lines and must
+  return a negative value, zero or a positive value if the first line
+  sorts before, together with or after the second one. Lines that compare
+  equal keep their order. The selection stays with the lines.
+
+  \param[in] compare The comparison function
+  \param[in] arg The last argument of \p compare
+  \param[in] flags FL_SORT_ASCENDING or FL_SORT_DESCENDING
+  \see sort(int), sort(int, int)
+*/
+void Fl_Browser::sort(Fl_Browser_Compare* compare, void* arg, int flags) {
+  if (lines < 2 || !compare) return;
+  FL_BLINE** items = (FL_BLINE**)malloc(lines * sizeof(FL_BLINE*));
+  int n = 0;
+  for (FL_BLINE* l = first; l; l = l->next) items[n++] = l;
+  bool desc = (flags & FL_SORT_DESCENDING) != 0;
+  std::stable_sort(items, items + n, [&](const FL_BLINE* a, const FL_BLINE* b) {
+    int c = compare(a->txt, a->data, b->txt, b->data, arg);
+    return desc ? c > 0 : c < 0;
+  });
+  reorder((void**)items, n);
+  free(items);
+}
+
 /**
   Set the image icon for \p line to the value \p icon.
   Caller is responsible for keeping the icon allocated.
@@ -935,14 +1205,16 @@ void Fl_Browser::icon(int line, Fl_Image* icon) {
 
   int old_h = bl->icon ? bl->icon->h()+2 : 0;   // init with *old* icon height
   bl->icon = 0;                                 // remove icon, if any
+  bl->generation = 0;                           // and its cached size
   int th = item_height(bl);                     // height of text only
   int new_h = icon ? icon->h()+2 : 0;           // init with *new* icon height
   if (th > old_h) old_h = th;
   if (th > new_h) new_h = th;
   int dh = new_h - old_h;
-  full_height_ += dh;                           // do this *always*
 
   bl->icon = icon;                              // set new icon
+  bl->generation = 0;
+  index_->height(line-1, bline_height(bl));     // do this *always*
   if (dh>0) {
     redraw();                                   // icon larger than item? must redraw widget
   } else {
@@ -17,11 +17,16 @@
 #define DISPLAY_SEARCH_BOTH_WAYS_AT_ONCE
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <FL/Fl.H>
 #include <FL/Fl_Widget.H>
 #include <FL/Fl_Browser_.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_utf8.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 
 
 // This is the base class for browsers.  To be useful it must be
@@ -125,7 +130,7 @@ void Fl_Browser_::resize(int X, int Y, int W, int H) {
 void Fl_Browser_::redraw_line(void* item) {
   if (!redraw1 || redraw1 == item) {redraw1 = item; damage(FL_DAMAGE_EXPOSE);}
   else if (!redraw2 || redraw2 == item) {redraw2 = item; damage(FL_DAMAGE_EXPOSE);}
-  else damage(FL_DAMAGE_SCROLL);
+  else redraw_lines();
 }
 
 // Figure out top() based on position():
@@ -135,8 +140,11 @@ void Fl_Browser_::update_top() {
     void* l;
     int ly;
     int yy = position_;
-    // start from either head or current position, whichever is closer:
-    if (!top_ || yy <= (real_position_/2)) {
+    // start from either head or current position, whichever is closer,
+    // or from the item found directly by the subclass:
+    if ((l = item_at_ypos(yy, ly)) != 0) {
+      // found
+    } else if (!top_ || yy <= (real_position_/2)) {
       l = item_first();
       ly = 0;
     } else {
@@ -196,7 +204,11 @@ void Fl_Browser_::vposition(int pos) {
   if (pos < 0) pos = 0;
   if (pos == position_) return;
   position_ = pos;
-  if (pos != real_position_) redraw_lines();
+  if (pos != real_position_) {
+    char s = scrolled_ || !(damage() & (FL_DAMAGE_SCROLL|FL_DAMAGE_ALL));
+    redraw_lines();
+    scrolled_ = s; // draw() can scroll the pixels of the lines
+  }
 }
 
 /**
@@ -211,7 +223,11 @@ void Fl_Browser_::hposition(int pos) {
   if (pos < 0) pos = 0;
   if (pos == hposition_) return;
   hposition_ = pos;
-  if (pos != real_hposition_) redraw_lines();
+  if (pos != real_hposition_) {
+    char s = scrolled_ || !(damage() & (FL_DAMAGE_SCROLL|FL_DAMAGE_ALL));
+    redraw_lines();
+    scrolled_ = s;
+  }
 }
 
 // Tell whether item is currently displayed:
@@ -252,6 +268,23 @@ void Fl_Browser_::display(void* item) {
   Y = Yp = -offset_;
   int h1;
 
+  // Direct case - the subclass knows the position of the item:
+  int iy = item_ypos(item);
+  if (iy >= 0) {
+    h1 = item_quick_height(item) + linespacing();
+    Y = iy - real_position_;
+    if (Y < 0) { // above top of browser
+      if ((Y + h1) >= 0) vposition(iy); // scroll up a bit
+      else vposition(iy-(H-h1)/2); // center it
+    } else if (Y <= H) { // it is visible or right at bottom
+      Y = Y+h1-H; // find where bottom edge is
+      if (Y > 0) vposition(real_position_+Y); // scroll down a bit
+    } else {
+      vposition(iy-(H-h1)/2); // center it
+    }
+    return;
+  }
+
   // 2nd special case - want to display item already displayed at top of browser?
   if (l == item) { vposition(real_position_+Y); return; } // scroll up a bit
 
@@ -332,6 +365,7 @@ void Fl_Browser_::draw() {
   int full_height_ = full_height();
   int X, Y, W, H; bbox(X, Y, W, H);
   int dont_repeat = 0;
+  int drawn_hposition = real_hposition_;
 J1:
   if (damage() & FL_DAMAGE_ALL) { // redraw the box if full redraw
     Fl_Boxtype b = box() ? box() : FL_DOWN_BOX;
@@ -350,6 +384,7 @@ J1:
     top_ = item_first(); real_position_ = offset_ = 0;
     if (scrollbar.visible()) {
       scrollbar.clear_visible();
+      scrolled_ = 0;
       clear_damage((uchar)(damage()|FL_DAMAGE_SCROLL));
     }
   }
@@ -365,6 +400,7 @@ J1:
     real_hposition_ = 0;
     if (hscrollbar.visible()) {
       hscrollbar.clear_visible();
+      scrolled_ = 0;
       clear_damage((uchar)(damage()|FL_DAMAGE_SCROLL));
     }
   }
@@ -383,6 +419,7 @@ J1:
     top_ = item_first(); real_position_ = offset_ = 0;
     if (scrollbar.visible()) {
       scrollbar.clear_visible();
+      scrolled_ = 0;
       clear_damage((uchar)(damage()|FL_DAMAGE_SCROLL));
     }
   }
@@ -390,6 +427,16 @@ J1:
   bbox(X, Y, W, H);
 
   fl_push_clip(X, Y, W, H);
+  // if only the scroll position changed, move the pixels of the lines
+  // in the window and draw the lines that became visible:
+  float scale = Fl_Surface_Device::surface()->driver()->scale();
+  if (scrolled_ && !drawsquare && scale == int(scale) &&
+      Fl_Surface_Device::surface() == Fl_Display_Device::display_device() &&
+      (damage() & (FL_DAMAGE_SCROLL|FL_DAMAGE_ALL)) == FL_DAMAGE_SCROLL) {
+    fl_scroll(X, Y, W, H, drawn_hposition-hposition_, drawn_position_-real_position_,
+              draw_area_, this);
+    clear_damage((uchar)(damage() & ~FL_DAMAGE_SCROLL));
+  }
   // for each line, draw it if full redraw or scrolled.  Erase background
   // if not a full redraw or if it is selected:
   void* l = top();
@@ -397,23 +444,8 @@ J1:
   for (; l && yy < H; l = item_next(l)) {
     int hh = item_height(l) + linespacing();
     if (hh <= 0) continue;
-    if ((damage()&(FL_DAMAGE_SCROLL|FL_DAMAGE_ALL)) || l == redraw1 || l == redraw2) {
-      if (item_selected(l)) {
-        fl_color(active_r() ? selection_color() : fl_inactive(selection_color()));
-        fl_rectf(X, yy+Y, W, hh);
-      } else if (!(damage()&FL_DAMAGE_ALL)) {
-        fl_push_clip(X, yy+Y, W, hh);
-        draw_box(box() ? box() : FL_DOWN_BOX, x(), y(), w(), h(), color());
-        fl_pop_clip();
-      }
-      item_draw(l, X-hposition_, yy+Y, W+hposition_, hh);
-      if (l == selection_ && Fl::focus() == this) {
-        draw_box(FL_BORDER_FRAME, X, yy+Y, W, hh, color());
-        draw_focus(FL_NO_BOX, X, yy+Y, W+1, hh+1);
-      }
-      int ww = item_width(l);
-      if (ww > max_width) {max_width = ww; max_width_item = l;}
-    }
+    if ((damage()&(FL_DAMAGE_SCROLL|FL_DAMAGE_ALL)) || l == redraw1 || l == redraw2)
+      draw_line_(l, X, yy+Y, W, hh, !(damage()&FL_DAMAGE_ALL));
     yy += hh;
   }
   // erase the area below last line:
@@ -475,6 +507,49 @@ J1:
   }
 
   real_hposition_ = hposition_;
+  drawn_position_ = real_position_;
+  scrolled_ = 0;
+  fl_pop_clip();
+}
+
+// Draws one line, erases the background first if erase is set or the
+// line is selected:
+void Fl_Browser_::draw_line_(void *l, int X, int Y, int W, int hh, int erase) {
+  if (item_selected(l)) {
+    fl_color(active_r() ? selection_color() : fl_inactive(selection_color()));
+    fl_rectf(X, Y, W, hh);
+  } else if (erase) {
+    fl_push_clip(X, Y, W, hh);
+    draw_box(box() ? box() : FL_DOWN_BOX, x(), y(), w(), h(), color());
+    fl_pop_clip();
+  }
+  item_draw(l, X-hposition_, Y, W+hposition_, hh);
+  if (l == selection_ && Fl::focus() == this) {
+    draw_box(FL_BORDER_FRAME, X, Y, W, hh, color());
+    draw_focus(FL_NO_BOX, X, Y, W+1, hh+1);
+  }
+  int ww = item_width(l);
+  if (ww > max_width) {max_width = ww; max_width_item = l;}
+}
+
+// Draws the lines that intersect an area, the callback of fl_scroll()
+// in draw():
+void Fl_Browser_::draw_area_(void *v, int AX, int AY, int AW, int AH) {
+  Fl_Browser_ *b = (Fl_Browser_*)v;
+  int X, Y, W, H; b->bbox(X, Y, W, H);
+  fl_push_clip(AX, AY, AW, AH);
+  int yy = -b->offset_;
+  for (void *l = b->top(); l && yy < H && Y+yy < AY+AH; l = b->item_next(l)) {
+    int hh = b->item_height(l) + b->linespacing();
+    if (hh <= 0) continue;
+    if (Y+yy+hh > AY) b->draw_line_(l, X, Y+yy, W, hh, 1);
+    yy += hh;
+  }
+  if (yy < H) { // below the last line
+    fl_push_clip(X, Y+yy, W, H-yy);
+    b->draw_box(b->box() ? b->box() : FL_DOWN_BOX, b->x(), b->y(), b->w(), b->h(), b->color());
+    fl_pop_clip();
+  }
   fl_pop_clip();
 }
 
@@ -490,6 +565,7 @@ void Fl_Browser_::new_list() {
   top_ = 0;
   position_ = real_position_ = 0;
   hposition_ = real_hposition_ = 0;
+  drawn_position_ = 0;
   selection_ = 0;
   offset_ = 0;
   max_width = 0;
@@ -648,7 +724,12 @@ int Fl_Browser_::select(void* item, int val, int docallbacks) {
 */
 int Fl_Browser_::deselect(int docallbacks) {
   if (type() == FL_MULTI_BROWSER) {
-    int change = 0;
+    int change = docallbacks ? -1 : item_deselect_all(0);
+    if (change >= 0) {
+      if (change) redraw_lines();
+      return change;
+    }
+    change = 0;
     for (void* p = item_first(); p; p = item_next(p))
       change |= select(p, 0, docallbacks);
     return change;
@@ -677,9 +758,15 @@ int Fl_Browser_::select_only(void* item, int docallbacks) {
   int change = 0;
   Fl_Widget_Tracker wp(this);
   if (type() == FL_MULTI_BROWSER) {
-    for (void* p = item_first(); p; p = item_next(p)) {
-      if (p != item) change |= select(p, 0, docallbacks);
-      if (wp.deleted()) return change;
+    int all = docallbacks ? -1 : item_deselect_all(item);
+    if (all >= 0) {
+      if (all) redraw_lines();
+      change = all;
+    } else {
+      for (void* p = item_first(); p; p = item_next(p)) {
+        if (p != item) change |= select(p, 0, docallbacks);
+        if (wp.deleted()) return change;
+      }
     }
   }
   change |= select(item, 1, docallbacks);
@@ -984,8 +1071,9 @@ Fl_Browser_::Fl_Browser_(int X, int Y, int W, int H, const char* L)
 {
   box(FL_NO_BOX);
   align(FL_ALIGN_BOTTOM);
-  position_ = real_position_ = 0;
+  position_ = real_position_ = drawn_position_ = 0;
   hposition_ = real_hposition_ = 0;
+  scrolled_ = 0;
   offset_ = 0;
   top_ = 0;
   when(FL_WHEN_RELEASE_ALWAYS);
@@ -1006,54 +1094,136 @@ Fl_Browser_::Fl_Browser_(int X, int Y, int W, int H, const char* L)
   end();
 }
 
+/**
+  This method should be used to put all items in a new order at once,
+  for instance after sorting them.
+  It calls item_reorder() and recalculates the item at the top of the
+  list, which keeps the scrolling position. Unlike swapping(), the
+  selection() stays with its item.
+  \param[in] items All \p n items of the list in their new order
+  \param[in] n The number of items
+*/
+void Fl_Browser_::reorder(void **items, int n) {
+  item_reorder(items, n);
+  top_ = 0;
+  offset_ = 0;
+  real_position_ = 0;
+  redraw_lines();
+}
+
+/**
+  This optional method may be provided by the subclass to put all items
+  in the order given by \p items in one step, for instance by relinking
+  its list. Use reorder() to call it.
+
+  The default implementation moves each item to its new position with
+  item_swap(), which uses at most \p n - 1 swaps.
+  \param[in] items All \p n items of the list in their new order
+  \param[in] n The number of items
+*/
+void Fl_Browser_::item_reorder(void **items, int n) {
+  std::vector<void *> cur;
+  std::unordered_map<void *, int> pos;
+  for (void *l = item_first(); l; l = item_next(l)) {
+    pos[l] = (int)cur.size();
+    cur.push_back(l);
+  }
+  for (int k = 0; k < n && k < (int)cur.size(); k++) {
+    void *a = cur[k], *b = items[k];
+    if (a == b) continue;
+    int j = pos[b];
+    item_swap(a, b);
+    cur[k] = b; pos[b] = k;
+    cur[j] = a; pos[a] = j;
+  }
+}
+
+// Compares two texts that are not null terminated
+static int compare_text(const char *a, int la, const char *b, int lb, bool caseinsensitive) {
+  if (!caseinsensitive) {
+    int c = memcmp(a, b, la < lb ? la : lb);
+    return c ? c : la - lb;
+  }
+  const char *ea = a + la, *eb = b + lb;
+  while (a < ea && b < eb) {
+    int l1, l2;
+    unsigned u1 = fl_utf8decode(a, ea, &l1);
+    unsigned u2 = fl_utf8decode(b, eb, &l2);
+    int c = fl_tolower(u1) - fl_tolower(u2);
+    if (c) return c;
+    a += l1;
+    b += l2;
+  }
+  return (a < ea) - (b < eb);
+}
+
+// Returns the number at the start of a text that is not null terminated
+static double text_value(const char *t, int l) {
+  char buf[64];
+  if (l > (int)sizeof(buf) - 1) l = (int)sizeof(buf) - 1;
+  memcpy(buf, t, l);
+  buf[l] = 0;
+  return strtod(buf, 0);
+}
+
+/**
+  Puts the \p n \p items in the order of their \p keys and calls reorder().
+  This is a stable sort: items with equal keys keep their order.
+  \param[in] items All \p n items of the list, in their current order
+  \param[in] keys The text to sort each item by, need not be null terminated
+  \param[in] lengths The length of each key in bytes
+  \param[in] n The number of items
+  \param[in] flags The same as for sort(int)
+*/
+void Fl_Browser_::sort_items(void **items, const char *const *keys,
+                             const int *lengths, int n, int flags) {
+  bool desc = (flags & FL_SORT_DESCENDING) != 0;
+  bool caseinsensitive = (flags & FL_SORT_CASEINSENSITIVE) != 0;
+  std::vector<double> values;
+  if (flags & FL_SORT_NUMERIC) {
+    values.resize(n);
+    for (int i = 0; i < n; i++) values[i] = text_value(keys[i], lengths[i]);
+  }
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    int c;
+    if (!values.empty())
+      c = values[a] < values[b] ? -1 : values[a] > values[b];
+    else
+      c = compare_text(keys[a], lengths[a], keys[b], lengths[b], caseinsensitive);
+    return desc ? c > 0 : c < 0;
+  });
+  std::vector<void *> sorted(n);
+  for (int i = 0; i < n; i++) sorted[i] = items[order[i]];
+  reorder(sorted.data(), n);
+}
+
 /**
   Sort the items in the browser based on \p flags.
-  item_swap(void*, void*) and item_text(void*) must be implemented for this call.
+  item_text(void*) and item_swap(void*, void*) or item_reorder() must be
+  implemented for this call. Items with equal texts keep their order.
   \param[in] flags FL_SORT_ASCENDING -- sort in ascending order\n
                    FL_SORT_DESCENDING -- sort in descending order\n
-                  FL_SORT_CASEINSENSITIVE -- add this to sort case-insensitively\n
+                   FL_SORT_CASEINSENSITIVE -- add this to sort case-insensitively\n
+                   FL_SORT_NUMERIC -- add this to sort by the number at the
+                   start of the text, text without a number counts as 0\n
                    Values other than the above will cause undefined behavior\n
                    Other flags may appear in the future.
 */
 void Fl_Browser_::sort(int flags) {
-  //
-  // Simple bubble sort - pure lazyness on my side.
-  //
-  int i, j, n = -1, desc = ((flags&FL_SORT_DESCENDING)==FL_SORT_DESCENDING);
-  bool caseinsensitive = (flags&FL_SORT_CASEINSENSITIVE);
-  void *a =item_first(), *b, *c;
-  if (!a) return;
-  while (a) {
-    a = item_next(a);
-    n++;
-  }
-  for (i=n; i>0; i--) {
-    char swapped = 0;
-    a = item_first();
-    b = item_next(a);
-    for (j=0; j<i; j++) {
-      const char *ta = item_text(a);
-      const char *tb = item_text(b);
-      c = item_next(b);
-      if (desc) {
-        if ( (caseinsensitive && fl_utf_strcasecmp(ta, tb) < 0) ||
-            (!caseinsensitive && strcmp(ta, tb) < 0) ) {
-          item_swap(a, b);
-          swapped = 1;
-        }
-      } else {
-        if ( (caseinsensitive && fl_utf_strcasecmp(ta, tb) > 0) ||
-            (!caseinsensitive && strcmp(ta, tb) > 0) ) {
-          item_swap(a, b);
-          swapped = 1;
-        }
-      }
-      if (!c) break;
-      b = c; a = item_prev(b);
-    }
-    if (!swapped)
-      break;
+  std::vector<void *> items;
+  std::vector<const char *> keys;
+  std::vector<int> lengths;
+  for (void *l = item_first(); l; l = item_next(l)) {
+    const char *t = item_text(l);
+    if (!t) t = "";
+    items.push_back(l);
+    keys.push_back(t);
+    lengths.push_back((int)strlen(t));
   }
+  if (items.size() < 2) return;
+  sort_items(items.data(), keys.data(), lengths.data(), (int)items.size(), flags);
 }
 
 // Default versions of some of the virtual functions:
@@ -0,0 +1,347 @@
+//
+// Line index for Fl_Browser for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Browser_Index.H"
+
+#include <stddef.h>
+
+Fl_Browser_Index::Fl_Browser_Index(Set_Chunk set_chunk)
+  : tree_valid_(true), size_(0), height_(0), set_chunk_(set_chunk) {
+  count_tree_.push_back(0);
+  height_tree_.push_back(0);
+}
+
+Fl_Browser_Index::~Fl_Browser_Index() {
+  clear();
+}
+
+// Removes all items (the items themselves are not deleted)
+void Fl_Browser_Index::clear() {
+  for (size_t i = 0; i < chunks_.size(); i++)
+    delete chunks_[i];
+  chunks_.clear();
+  count_tree_.assign(1, 0);
+  height_tree_.assign(1, 0);
+  tree_valid_ = true;
+  size_ = 0;
+  height_ = 0;
+}
+
+// Rebuilds both Fenwick trees in O(number of chunks)
+void Fl_Browser_Index::build_trees() const {
+  int n = (int)chunks_.size();
+  count_tree_.assign(n + 1, 0);
+  height_tree_.assign(n + 1, 0);
+  for (int i = 1; i <= n; i++) {
+    count_tree_[i] += (int)chunks_[i - 1]->items.size();
+    height_tree_[i] += chunks_[i - 1]->height;
+    int j = i + (i & -i);
+    if (j <= n) {
+      count_tree_[j] += count_tree_[i];
+      height_tree_[j] += height_tree_[i];
+    }
+  }
+  tree_valid_ = true;
+}
+
+// Adds item count and height differences of chunk c to the trees
+void Fl_Browser_Index::tree_add(int c, int dcount, int dheight) {
+  if (!tree_valid_) return; // rebuilt before next use
+  int n = (int)chunks_.size();
+  for (int i = c + 1; i <= n; i += (i & -i)) {
+    count_tree_[i] += dcount;
+    height_tree_[i] += dheight;
+  }
+}
+
+// Updates the chunk positions starting at chunk 'from', invalidates the trees
+void Fl_Browser_Index::renumber(int from) {
+  for (int i = from; i < (int)chunks_.size(); i++)
+    chunks_[i]->pos = i;
+  tree_valid_ = false;
+}
+
+// Returns the chunk containing item 'index' and its offset in this chunk.
+// 'index' must be in range.
+int Fl_Browser_Index::locate(int index, int &offset) const {
+  if (!tree_valid_) build_trees();
+  int n = (int)chunks_.size();
+  int step = 1;
+  while (step * 2 <= n) step *= 2;
+  int pos = 0;
+  for (; step > 0; step /= 2) {
+    if (pos + step <= n && count_tree_[pos + step] <= index) {
+      pos += step;
+      index -= count_tree_[pos];
+    }
+  }
+  offset = index;
+  return pos;
+}
+
+// Returns the sum of the heights of all chunks before chunk c
+int Fl_Browser_Index::prefix_height(int c) const {
+  if (!tree_valid_) build_trees();
+  int h = 0;
+  for (int i = c; i > 0; i -= (i & -i))
+    h += height_tree_[i];
+  return h;
+}
+
+// Moves the upper half of chunk c to a new chunk
+void Fl_Browser_Index::split(int c) {
+  Chunk *a = chunks_[c];
+  Chunk *b = new Chunk;
+  int half = (int)a->items.size() / 2;
+  b->items.assign(a->items.begin() + half, a->items.end());
+  b->heights.assign(a->heights.begin() + half, a->heights.end());
+  a->items.resize(half);
+  a->heights.resize(half);
+  b->height = 0;
+  for (size_t i = 0; i < b->items.size(); i++) {
+    b->height += b->heights[i];
+    set_chunk_(b->items[i], b);
+  }
+  a->height -= b->height;
+  chunks_.insert(chunks_.begin() + c + 1, b);
+  renumber(c + 1);
+}
+
+// Merges a small chunk c with one of its neighbors if possible
+void Fl_Browser_Index::merge(int c) {
+  int n = (int)chunks_.size();
+  int size = (int)chunks_[c]->items.size();
+  int other;
+  if (c + 1 < n && size + (int)chunks_[c + 1]->items.size() <= MAX_CHUNK)
+    other = c + 1;
+  else if (c > 0 && size + (int)chunks_[c - 1]->items.size() <= MAX_CHUNK)
+    other = c - 1;
+  else
+    return;
+  Chunk *a = chunks_[c < other ? c : other];
+  Chunk *b = chunks_[c < other ? other : c];
+  for (size_t i = 0; i < b->items.size(); i++)
+    set_chunk_(b->items[i], a);
+  a->items.insert(a->items.end(), b->items.begin(), b->items.end());
+  a->heights.insert(a->heights.end(), b->heights.begin(), b->heights.end());
+  a->height += b->height;
+  chunks_.erase(chunks_.begin() + b->pos);
+  int from = b->pos;
+  delete b;
+  renumber(from);
+}
+
+// Returns the item at position 'index' or NULL if out of range
+void *Fl_Browser_Index::item(int index) const {
+  if (index < 0 || index >= size_) return 0;
+  int offset;
+  int c = locate(index, offset);
+  return chunks_[c]->items[offset];
+}
+
+// Returns the position of 'item' stored in 'chunk' or -1 if not found
+int Fl_Browser_Index::index(void *item, const Chunk *chunk) const {
+  if (!chunk) return -1;
+  int offset = -1;
+  for (size_t i = 0; i < chunk->items.size(); i++) {
+    if (chunk->items[i] == item) {
+      offset = (int)i;
+      break;
+    }
+  }
+  if (offset < 0) return -1;
+  if (!tree_valid_) build_trees();
+  for (int i = chunk->pos; i > 0; i -= (i & -i))
+    offset += count_tree_[i];
+  return offset;
+}
+
+// Returns the sum of the heights of all items before 'index'
+int Fl_Browser_Index::ypos(int index) const {
+  if (index <= 0) return 0;
+  if (index >= size_) return height_;
+  int offset;
+  int c = locate(index, offset);
+  int y = prefix_height(c);
+  const Chunk *chunk = chunks_[c];
+  for (int i = 0; i < offset; i++)
+    y += chunk->heights[i];
+  return y;
+}
+
+// Returns the position of the item that contains the y coordinate 'ypos'
+// and sets 'item_y' to its top position. Items with height 0 are skipped.
+// If 'ypos' is below the last item, the last item is returned.
+// Returns -1 if the index is empty.
+int Fl_Browser_Index::find(int ypos, int &item_y) const {
+  if (size_ == 0) return -1;
+  if (ypos >= height_) {
+    item_y = height_ - height(size_ - 1);
+    return size_ - 1;
+  }
+  if (ypos < 0) ypos = 0;
+  if (!tree_valid_) build_trees();
+  int n = (int)chunks_.size();
+  int step = 1;
+  while (step * 2 <= n) step *= 2;
+  int pos = 0, index = 0, rest = ypos;
+  for (; step > 0; step /= 2) {
+    if (pos + step <= n && height_tree_[pos + step] <= rest) {
+      pos += step;
+      rest -= height_tree_[pos];
+      index += count_tree_[pos];
+    }
+  }
+  const Chunk *chunk = chunks_[pos];
+  int i = 0;
+  while (i < (int)chunk->items.size() - 1 && chunk->heights[i] <= rest) {
+    rest -= chunk->heights[i];
+    i++;
+  }
+  item_y = ypos - rest;
+  return index + i;
+}
+
+// Inserts 'item' before position 'index', appends it if 'index' >= size()
+void Fl_Browser_Index::insert(int index, void *item, int h) {
+  if (chunks_.empty()) {
+    Chunk *chunk = new Chunk;
+    chunk->height = 0;
+    chunk->pos = 0;
+    chunks_.push_back(chunk);
+    tree_valid_ = false;
+  }
+  if (index < 0) index = 0;
+  int c, offset;
+  if (index >= size_) {
+    c = (int)chunks_.size() - 1;
+    offset = (int)chunks_[c]->items.size();
+  } else {
+    c = locate(index, offset);
+  }
+  Chunk *chunk = chunks_[c];
+  chunk->items.insert(chunk->items.begin() + offset, item);
+  chunk->heights.insert(chunk->heights.begin() + offset, h);
+  chunk->height += h;
+  set_chunk_(item, chunk);
+  size_++;
+  height_ += h;
+  tree_add(c, 1, h);
+  if ((int)chunk->items.size() > MAX_CHUNK) split(c);
+}
+
+// Appends 'n' items with their heights
+void Fl_Browser_Index::append(void *const *items, const int *heights, int n) {
+  int i = 0;
+  while (i < n) {
+    if (chunks_.empty() || (int)chunks_.back()->items.size() >= MAX_CHUNK) {
+      Chunk *chunk = new Chunk;
+      chunk->height = 0;
+      chunk->pos = (int)chunks_.size();
+      chunks_.push_back(chunk);
+      tree_valid_ = false;
+    }
+    Chunk *chunk = chunks_.back();
+    int c = (int)chunks_.size() - 1;
+    int dh = 0, start = i;
+    for (; i < n && (int)chunk->items.size() < MAX_CHUNK; i++) {
+      chunk->items.push_back(items[i]);
+      chunk->heights.push_back(heights[i]);
+      set_chunk_(items[i], chunk);
+      dh += heights[i];
+    }
+    chunk->height += dh;
+    size_ += i - start;
+    height_ += dh;
+    tree_add(c, i - start, dh);
+  }
+}
+
+// Removes the item at 'index' (must be in range) and returns it
+void *Fl_Browser_Index::remove(int index) {
+  int offset;
+  int c = locate(index, offset);
+  Chunk *chunk = chunks_[c];
+  void *item = chunk->items[offset];
+  int h = chunk->heights[offset];
+  chunk->items.erase(chunk->items.begin() + offset);
+  chunk->heights.erase(chunk->heights.begin() + offset);
+  chunk->height -= h;
+  size_--;
+  height_ -= h;
+  tree_add(c, -1, -h);
+  if (chunk->items.empty()) {
+    chunks_.erase(chunks_.begin() + c);
+    delete chunk;
+    renumber(c);
+  } else if ((int)chunk->items.size() < MIN_CHUNK) {
+    merge(c);
+  }
+  return item;
+}
+
+// Replaces the item at 'index' (must be in range), keeps its height
+void Fl_Browser_Index::replace(int index, void *item) {
+  int offset;
+  int c = locate(index, offset);
+  chunks_[c]->items[offset] = item;
+  set_chunk_(item, chunks_[c]);
+}
+
+// Swaps the items (and their heights) at positions 'a' and 'b'
+void Fl_Browser_Index::swap(int a, int b) {
+  if (a == b) return;
+  int oa, ob;
+  int ca = locate(a, oa);
+  int cb = locate(b, ob);
+  Chunk *chunk_a = chunks_[ca];
+  Chunk *chunk_b = chunks_[cb];
+  void *item = chunk_a->items[oa];
+  chunk_a->items[oa] = chunk_b->items[ob];
+  chunk_b->items[ob] = item;
+  int h = chunk_a->heights[oa];
+  chunk_a->heights[oa] = chunk_b->heights[ob];
+  chunk_b->heights[ob] = h;
+  if (ca != cb) {
+    int dh = chunk_a->heights[oa] - h;
+    chunk_a->height += dh;
+    chunk_b->height -= dh;
+    tree_add(ca, 0, dh);
+    tree_add(cb, 0, -dh);
+    set_chunk_(chunk_a->items[oa], chunk_a);
+    set_chunk_(chunk_b->items[ob], chunk_b);
+  }
+}
+
+// Returns the height of the item at 'index' (must be in range)
+int Fl_Browser_Index::height(int index) const {
+  int offset;
+  int c = locate(index, offset);
+  return chunks_[c]->heights[offset];
+}
+
+// Sets the height of the item at 'index' (must be in range)
+void Fl_Browser_Index::height(int index, int h) {
+  int offset;
+  int c = locate(index, offset);
+  Chunk *chunk = chunks_[c];
+  int dh = h - chunk->heights[offset];
+  if (!dh) return;
+  chunk->heights[offset] = h;
+  chunk->height += dh;
+  height_ += dh;
+  tree_add(c, 0, dh);
+}
@@ -0,0 +1,119 @@
+//
+// Line storage for Fl_Browser for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Browser_Store.H"
+
+#include <stdlib.h>
+#include <string.h>
+
+Fl_Browser_Store::Fl_Browser_Store()
+  : next_(0), left_(0), large_(0), generation_(1), font_(-1), size_(-1),
+    format_char_(0), column_char_(0), column_widths_(0), column_sum_(0) {
+  memset(free_, 0, sizeof(free_));
+}
+
+Fl_Browser_Store::~Fl_Browser_Store() {
+  clear();
+}
+
+// Returns the size actually used for a line of the given size
+size_t Fl_Browser_Store::round(size_t size) {
+  return (size + GRANULE - 1) & ~(size_t)(GRANULE - 1);
+}
+
+// Returns memory for a line of 'size' bytes, aligned for pointers
+void *Fl_Browser_Store::alloc(size_t size) {
+  size = round(size);
+  if (size > MAX_SMALL) {
+    Large *l = (Large *)malloc(offsetof(Large, align) + size);
+    l->prev = 0;
+    l->next = large_;
+    if (large_) large_->prev = l;
+    large_ = l;
+    return &l->align;
+  }
+  void *p = free_[size / GRANULE];
+  if (p) {
+    free_[size / GRANULE] = *(void **)p;
+    return p;
+  }
+  if (left_ < size) {
+    // the rest of the current block goes to the free lists:
+    if (left_ >= GRANULE) release(next_, left_ & ~(size_t)(GRANULE - 1));
+    next_ = (char *)malloc(BLOCK_SIZE);
+    blocks_.push_back(next_);
+    left_ = BLOCK_SIZE;
+  }
+  p = next_;
+  next_ += size;
+  left_ -= size;
+  return p;
+}
+
+// Releases a line that was allocated with alloc(size)
+void Fl_Browser_Store::release(void *p, size_t size) {
+  size = round(size);
+  if (size > MAX_SMALL) {
+    Large *l = (Large *)((char *)p - offsetof(Large, align));
+    if (l->prev) l->prev->next = l->next; else large_ = l->next;
+    if (l->next) l->next->prev = l->prev;
+    free(l);
+    return;
+  }
+  *(void **)p = free_[size / GRANULE];
+  free_[size / GRANULE] = p;
+}
+
+// Releases all lines
+void Fl_Browser_Store::clear() {
+  for (size_t i = 0; i < blocks_.size(); i++)
+    free(blocks_[i]);
+  blocks_.clear();
+  while (large_) {
+    Large *l = large_;
+    large_ = l->next;
+    free(l);
+  }
+  memset(free_, 0, sizeof(free_));
+  next_ = 0;
+  left_ = 0;
+}
+
+/*
+  Returns the generation of the measurements cached in the lines for the
+  given browser settings. Generation 0 is never returned, so lines can
+  use it to mark their cached values as invalid.
+*/
+unsigned short Fl_Browser_Store::generation(Fl_Font font, Fl_Fontsize size,
+                                            char format_char, char column_char,
+                                            const int *column_widths) {
+  // the contents of the column widths array may change at any time:
+  unsigned sum = 0;
+  for (const int *w = column_widths; *w; w++)
+    sum = sum * 31 + (unsigned)*w;
+  if (font != font_ || size != size_ || format_char != format_char_ ||
+      column_char != column_char_ || column_widths != column_widths_ ||
+      sum != column_sum_) {
+    font_ = font;
+    size_ = size;
+    format_char_ = format_char;
+    column_char_ = column_char;
+    column_widths_ = column_widths;
+    column_sum_ = sum;
+    if (!++generation_) generation_ = 1;
+  }
+  return generation_;
+}
@@ -19,6 +19,8 @@
 #include <FL/Fl_Chart.H>
 #include <FL/fl_draw.H>
 #include "flstring.h"
+#include "Fl_Update_Queue.H"
+#include "Fl_Chart_Stream.H"
 #include <stdlib.h>
 
 // this function is in fl_boxtype.cxx:
@@ -278,6 +280,74 @@ void Fl_Chart::draw_piechart(int x, int y, int w, int h, int numb, FL_CHART_ENTR
   }
 }
 
+/*
+  Draws the values of the stream mode.
+
+  If there are more values than pixel columns, each column is drawn as a
+  vertical line covering the range of its values (min/max decimation),
+  so that drawing takes O(w) time for any number of values.
+*/
+void Fl_Chart::draw_stream(int x, int y, int w, int h) {
+  int n = stream_->count();
+  double incr;
+  if (max == min)
+    incr = h;
+  else
+    incr = h / (max - min);
+  int zeroh = (int)rint(y + h + min * incr);
+  double bwidth = w / double(autosize() ? n : maxnumb);
+  int t = type();
+  bool line = (t != FL_BAR_CHART && t != FL_FILL_CHART && t != FL_SPIKE_CHART);
+  fl_color((Fl_Color)stream_col_);
+  if (n > 0 && (min != 0.0 || max != 0.0)) {
+    if (bwidth >= 1.0) {
+      // not more values than pixel columns: draw each value
+      int xp = 0, yp = 0;
+      for (int i = 0; i < n; i++) {
+        int xi = x + (int)rint((i + .5) * bwidth);
+        int yi = zeroh - (int)rint(stream_->value(i) * incr);
+        if (line) {
+          if (i) fl_line(xp, yp, xi, yi);
+        } else if (t == FL_SPIKE_CHART) {
+          fl_line(xi, zeroh, xi, yi);
+        } else {
+          int x0 = x + (int)rint(i * bwidth);
+          int x1 = x + (int)rint((i + 1) * bwidth);
+          if (yi < zeroh)
+            fl_rectf(x0, yi, x1 - x0, zeroh - yi + 1);
+          else
+            fl_rectf(x0, zeroh, x1 - x0, yi - zeroh + 1);
+        }
+        xp = xi;
+        yp = yi;
+      }
+    } else {
+      // one vertical line per pixel column
+      for (int c = 0; c < w; c++) {
+        int i0 = (int)ceil(c / bwidth - .5);
+        int i1 = (int)ceil((c + 1) / bwidth - .5);
+        if (i1 > n) i1 = n;
+        float vmin, vmax;
+        if (!stream_->range(i0, i1, vmin, vmax))
+          continue;
+        int ytop = zeroh - (int)rint(vmax * incr);
+        int ybot = zeroh - (int)rint(vmin * incr);
+        int yc = zeroh;                   // bars start at the base line
+        if (line && i0 > 0)               // lines start at the previous value
+          yc = zeroh - (int)rint(stream_->value(i0 - 1) * incr);
+        if (line && i0 == 0)
+          yc = ytop;
+        if (yc < ytop) ytop = yc;
+        if (yc > ybot) ybot = yc;
+        fl_yxline(x + c, ytop, ybot);
+      }
+    }
+  }
+  // Draw base line
+  fl_color(textcolor());
+  fl_line(x, zeroh, x + w, zeroh);
+}
+
 /**
   Draws the Fl_Chart widget.
 */
@@ -293,7 +363,14 @@ void Fl_Chart::draw() {
 
   ww--; hh--; // adjust for line thickness
 
-  if (min >= max) {
+  if (min >= max && stream_) {
+    float vmin, vmax;
+    min = max = 0.0;
+    if (stream_->range(0, stream_->count(), vmin, vmax)) {
+      if (vmin < min) min = vmin;
+      if (vmax > max) max = vmax;
+    }
+  } else if (min >= max) {
     min = max = 0.0;
     for (int i = 0; i < numb; i++) {
       if (entries[i].val < min)
@@ -305,6 +382,13 @@ void Fl_Chart::draw() {
 
   fl_font(textfont(), textsize());
 
+  if (stream_) {
+    draw_stream(xx, yy, ww, hh);
+    draw_label();
+    fl_pop_clip();
+    return;
+  }
+
   switch (type()) {
     case FL_BAR_CHART:
       ww++; // makes the bars fill box correctly
@@ -350,14 +434,20 @@ Fl_Chart::Fl_Chart(int X, int Y, int W, int H, const char *L)
   textfont_ = FL_HELVETICA;
   textsize_ = 10;
   textcolor_ = FL_FOREGROUND_COLOR;
-  entries = (FL_CHART_ENTRY *)calloc(sizeof(FL_CHART_ENTRY), FL_CHART_MAX + 1);
+  buffer_ = (FL_CHART_ENTRY *)calloc(sizeof(FL_CHART_ENTRY), FL_CHART_MAX + 1);
+  entries = buffer_;
+  update_queue_ = 0;
+  stream_ = 0;
+  stream_col_ = 0;
 }
 
 /**
   Destroys the Fl_Chart widget and all of its data.
 */
 Fl_Chart::~Fl_Chart() {
-  free(entries);
+  Fl_Update_Queue::destroy(update_queue_);
+  delete stream_;
+  free(buffer_);
 }
 
 /**
@@ -365,10 +455,34 @@ Fl_Chart::~Fl_Chart() {
 */
 void Fl_Chart::clear() {
   numb = 0;
+  entries = buffer_;
+  if (stream_)
+    stream_->clear();
   min = max = 0;
   redraw();
 }
 
+/*
+  Makes sure that there is room for one more entry after the used entries.
+
+  add() drops the first entry of a full chart by advancing 'entries'. The
+  used entries are moved back to the start of the buffer only if at least
+  as many unused entries are before them, so this is O(1) amortized.
+*/
+void Fl_Chart::make_room() {
+  int offset = (int)(entries - buffer_);
+  if (offset + numb < sizenumb)
+    return;
+  if (offset > 0 && offset >= numb) {
+    memmove(buffer_, entries, sizeof(FL_CHART_ENTRY) * numb);
+    entries = buffer_;
+    return;
+  }
+  sizenumb += sizenumb / 2 > FL_CHART_MAX ? sizenumb / 2 : FL_CHART_MAX;
+  buffer_ = (FL_CHART_ENTRY *)realloc(buffer_, sizeof(FL_CHART_ENTRY) * (sizenumb + 1));
+  entries = buffer_ + offset;
+}
+
 /**
   Adds the data value \p val with optional label \p str and color \p col
   to the chart.
@@ -378,16 +492,20 @@ void Fl_Chart::clear() {
   \param[in] col optional data color
 */
 void Fl_Chart::add(double val, const char *str, unsigned col) {
-  // Allocate more entries if required
-  if (numb >= sizenumb) {
-    sizenumb += FL_CHART_MAX;
-    entries = (FL_CHART_ENTRY *)realloc(entries, sizeof(FL_CHART_ENTRY) * (sizenumb + 1));
+  if (stream_) {
+    stream_->add(float(val));
+    stream_col_ = col;
+    numb = stream_->count();
+    redraw();
+    return;
   }
-  // Shift entries as needed
+  // Drop the first entry as needed
   if (numb >= maxnumb && maxnumb > 0) {
-    memmove(entries, entries + 1, sizeof(FL_CHART_ENTRY) * (numb - 1));
+    entries++;
     numb--;
   }
+  // Allocate more entries if required
+  make_room();
   entries[numb].val = float(val);
   entries[numb].col = col;
   if (str) {
@@ -411,13 +529,10 @@ void Fl_Chart::add(double val, const char *str, unsigned col) {
 */
 void Fl_Chart::insert(int ind, double val, const char *str, unsigned col) {
   int i;
-  if (ind < 1 || ind > numb + 1)
+  if (ind < 1 || ind > numb + 1 || stream_)
     return;
   // Allocate more entries if required
-  if (numb >= sizenumb) {
-    sizenumb += FL_CHART_MAX;
-    entries = (FL_CHART_ENTRY *)realloc(entries, sizeof(FL_CHART_ENTRY) * (sizenumb + 1));
-  }
+  make_room();
   // Shift entries as needed
   for (i = numb; i >= ind; i--)
     entries[i] = entries[i - 1];
@@ -447,6 +562,11 @@ void Fl_Chart::insert(int ind, double val, const char *str, unsigned col) {
 void Fl_Chart::replace(int ind, double val, const char *str, unsigned col) {
   if (ind < 1 || ind > numb)
     return;
+  if (stream_) {
+    stream_->value(ind - 1, float(val));
+    redraw();
+    return;
+  }
   entries[ind - 1].val = float(val);
   entries[ind - 1].col = col;
   if (str) {
@@ -457,6 +577,88 @@ void Fl_Chart::replace(int ind, double val, const char *str, unsigned col) {
   redraw();
 }
 
+// Applies values posted by other threads, called by the main thread
+static void apply_posted_cb(void *target, const Fl_Update_Queue::Op *ops, int n) {
+  Fl_Chart *chart = (Fl_Chart *)target;
+  for (int i = 0; i < n; i++) {
+    const Fl_Update_Queue::Op &op = ops[i];
+    switch (op.code) {
+      case Fl_Update_Queue::CLEAR:
+        chart->clear();
+        break;
+      case Fl_Update_Queue::ADD:
+        chart->add(op.d, op.str, op.u);
+        break;
+      case Fl_Update_Queue::INSERT:
+        chart->insert(op.i1, op.d, op.str, op.u);
+        break;
+      case Fl_Update_Queue::REPLACE:
+        chart->replace(op.i1, op.d, op.str, op.u);
+        break;
+    }
+  }
+}
+
+/**
+  Removes all values from the chart, can be called from any thread.
+  \see post_add()
+*/
+void Fl_Chart::post_clear() {
+  Fl_Update_Queue::post(update_queue_, this, apply_posted_cb, Fl_Update_Queue::CLEAR);
+}
+
+/**
+  Adds a data value to the chart, can be called from any thread.
+
+  The post_xxx() methods of Fl_Chart can be called by other threads
+  \b without holding the global FLTK lock (Fl::lock()). The values are
+  staged in a queue of this chart and applied in order by the main
+  thread before the next Fl::flush(). All values that arrived in the
+  meantime are drawn with a single redraw.
+
+  As for all multithreaded FLTK programs the main thread must have called
+  Fl::lock() once to enable thread support.
+
+  \param[in] val data value
+  \param[in] str optional data label
+  \param[in] col optional data color
+  \see add()
+*/
+void Fl_Chart::post_add(double val, const char *str, unsigned col) {
+  Fl_Update_Queue::post(update_queue_, this, apply_posted_cb, Fl_Update_Queue::ADD, 0, 0, val, col, str);
+}
+
+/**
+  Inserts a data value at position \p ind, can be called from any thread.
+  \see post_add(), insert()
+*/
+void Fl_Chart::post_insert(int ind, double val, const char *str, unsigned col) {
+  Fl_Update_Queue::post(update_queue_, this, apply_posted_cb, Fl_Update_Queue::INSERT, ind, 0, val, col, str);
+}
+
+/**
+  Replaces the data value at position \p ind, can be called from any thread.
+  \see post_add(), replace()
+*/
+void Fl_Chart::post_replace(int ind, double val, const char *str, unsigned col) {
+  Fl_Update_Queue::post(update_queue_, this, apply_posted_cb, Fl_Update_Queue::REPLACE, ind, 0, val, col, str);
+}
+
+/**
+  Returns the number of posted values that have not yet been taken over
+  by the main thread. Can be called from any thread.
+*/
+int Fl_Chart::posted() const {
+  return Fl_Update_Queue::pending(update_queue_);
+}
+
+/**
+  Applies all posted values immediately. Must be called by the main thread.
+*/
+void Fl_Chart::apply_posted() {
+  Fl_Update_Queue::flush(update_queue_);
+}
+
 /**
   Sets the lower and upper bounds of the chart values.
 
@@ -474,19 +676,78 @@ void Fl_Chart::bounds(double a, double b) {
   If you do not call this method then the chart will be allowed to grow
   to any size depending on available memory.
 
+  In stream mode this is the same as stream_mode(m), except that \p m = 0
+  is ignored.
+
   \param[in] m maximum number of data values allowed.
 */
 void Fl_Chart::maxsize(int m) {
-  int i;
   // Fill in the new number
-  if (m < 0)
+  if (m < 0 || (stream_ && m == 0))
     return;
+  if (stream_) {
+    stream_mode(m);
+    return;
+  }
   maxnumb = m;
-  // Shift entries if required
+  // Drop entries if required
   if (numb > maxnumb) {
-    for (i = 0; i < maxnumb; i++)
-      entries[i] = entries[i + numb - maxnumb];
+    entries += numb - maxnumb;
     numb = maxnumb;
     redraw();
   }
 }
+
+/**
+  Switches the chart to stream mode, or back to normal mode.
+
+  Stream mode is intended for charts with many values that are added
+  continuously, e.g. a strip chart of live measurements. The chart stores
+  the last \p capacity values in a ring buffer: add() takes constant time,
+  and the oldest value is dropped when the buffer is full. Only the values
+  are stored (as float), the labels are ignored and all values are drawn
+  with the color given to the last add(). insert() is ignored.
+
+  Drawing takes time proportional to the width of the chart and not to the
+  number of values: if there are more values than pixel columns, each
+  column shows the range between the smallest and the largest of its
+  values. The minimum and maximum of blocks of values are kept up to date
+  when values are added, so that the ranges are found quickly at any zoom
+  level.
+
+  FL_BAR_CHART, FL_FILL_CHART and FL_SPIKE_CHART charts fill the area
+  between the base line and the values, all other types are drawn as a
+  line chart.
+
+  The values of the chart are kept when the mode is switched (at most the
+  last \p capacity values). maxsize() is set to \p capacity.
+
+  \param[in] capacity number of values in stream mode, 0 for normal mode
+  \see stream_mode() const, add()
+*/
+void Fl_Chart::stream_mode(int capacity) {
+  if (capacity < 0)
+    return;
+  Fl_Chart_Stream *old = stream_;
+  int i;
+  stream_ = 0;
+  if (capacity > 0) {
+    stream_ = new Fl_Chart_Stream(capacity);
+    int n = old ? old->count() : numb;
+    for (i = n > capacity ? n - capacity : 0; i < n; i++)
+      stream_->add(old ? old->value(i) : entries[i].val);
+    if (!old && numb > 0)
+      stream_col_ = entries[numb - 1].col;
+    numb = stream_->count();
+    entries = buffer_;
+  } else if (old) {
+    numb = 0;
+    entries = buffer_;
+    maxnumb = 0;
+    for (i = 0; i < old->count(); i++)
+      add(old->value(i), 0, stream_col_);
+  }
+  delete old;
+  maxnumb = capacity;
+  redraw();
+}
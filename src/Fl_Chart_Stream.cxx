@@ -0,0 +1,117 @@
+//
+// Value storage of the stream mode of Fl_Chart for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Chart_Stream.H"
+
+Fl_Chart_Stream::Fl_Chart_Stream(int capacity)
+  : capacity_(capacity > 0 ? capacity : 1), count_(0), total_(0) {
+  values_.assign(capacity_, 0.0f);
+  // levels with at least 4 blocks, the ring of each level holds all blocks
+  // that overlap the stored values
+  for (long long s = BLOCK; s <= capacity_ / 4; s *= BLOCK) {
+    Level level;
+    level.size = s;
+    level.min.assign((size_t)(capacity_ / s + 2), 0.0f);
+    level.max.assign((size_t)(capacity_ / s + 2), 0.0f);
+    levels_.push_back(level);
+  }
+}
+
+// Removes all values
+void Fl_Chart_Stream::clear() {
+  count_ = 0;
+  total_ = 0;
+}
+
+// Adds a value, drops the oldest value if the buffer is full
+void Fl_Chart_Stream::add(float v) {
+  long long a = total_;
+  values_[(size_t)(a % capacity_)] = v;
+  for (size_t k = 0; k < levels_.size(); k++) {
+    Level &level = levels_[k];
+    size_t slot = (size_t)((a / level.size) % (long long)level.min.size());
+    if (a % level.size == 0) {          // first value of a new block
+      level.min[slot] = level.max[slot] = v;
+    } else {
+      if (v < level.min[slot]) level.min[slot] = v;
+      if (v > level.max[slot]) level.max[slot] = v;
+    }
+  }
+  total_++;
+  if (count_ < capacity_) count_++;
+}
+
+// Recalculates the block of level k that contains the value with number a
+void Fl_Chart_Stream::update_block(int k, long long a) {
+  Level &level = levels_[k];
+  long long begin = a - a % level.size;
+  long long end = begin + level.size < total_ ? begin + level.size : total_;
+  if (begin < total_ - count_) return;  // partly dropped, never used by range()
+  float mn = raw(begin), mx = mn;
+  if (k == 0) {
+    for (long long i = begin + 1; i < end; i++) {
+      float v = raw(i);
+      if (v < mn) mn = v;
+      if (v > mx) mx = v;
+    }
+  } else {
+    const Level &lower = levels_[k - 1];
+    for (long long i = begin; i < end; i += lower.size) {
+      size_t slot = (size_t)((i / lower.size) % (long long)lower.min.size());
+      if (lower.min[slot] < mn) mn = lower.min[slot];
+      if (lower.max[slot] > mx) mx = lower.max[slot];
+    }
+  }
+  size_t slot = (size_t)((a / level.size) % (long long)level.min.size());
+  level.min[slot] = mn;
+  level.max[slot] = mx;
+}
+
+// Changes value i (0 is the oldest value)
+void Fl_Chart_Stream::value(int i, float v) {
+  long long a = total_ - count_ + i;
+  values_[(size_t)(a % capacity_)] = v;
+  for (size_t k = 0; k < levels_.size(); k++)
+    update_block((int)k, a);
+}
+
+// Finds the minimum and maximum of the values first to last-1.
+// Returns false if the range is empty.
+bool Fl_Chart_Stream::range(int first, int last, float &min, float &max) const {
+  long long a = total_ - count_ + first;
+  long long b = total_ - count_ + last;
+  if (a >= b) return false;
+  min = max = raw(a);
+  while (a < b) {
+    int k = (int)levels_.size() - 1;
+    for (; k >= 0; k--) {               // the largest block that starts at a and fits
+      long long s = levels_[k].size;
+      if (a % s == 0 && a + s <= b) break;
+    }
+    if (k >= 0) {
+      const Level &level = levels_[k];
+      size_t slot = (size_t)((a / level.size) % (long long)level.min.size());
+      if (level.min[slot] < min) min = level.min[slot];
+      if (level.max[slot] > max) max = level.max[slot];
+      a += level.size;
+    } else {
+      float v = raw(a++);
+      if (v < min) min = v;
+      if (v > max) max = v;
+    }
+  }
+  return true;
+}
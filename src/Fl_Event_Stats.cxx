@@ -0,0 +1,475 @@
+//
+// Event loop statistics for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+  \file Fl_Event_Stats.cxx
+*/
+
+#include <FL/Fl_Event_Stats.H>
+#include <FL/Fl.H>
+#include <FL/Fl_Window.H>
+
+#include <math.h>
+#include <vector>
+
+// static class variables and local data
+
+bool Fl_Event_Stats::enabled_ = false;
+
+namespace {
+
+struct Window_Entry {
+  const Fl_Window *win;
+  Fl_Event_Stats::Histogram *hist;
+};
+
+struct Trace_Event {
+  int phase;              // Fl_Event_Stats::Phase or -1 for window drawing
+  const void *address;    // callback address or window
+  long long start;        // microseconds since origin
+  long long duration;     // microseconds
+};
+
+const int SLOW_RING_SIZE = 64;
+
+Fl_Event_Stats::Histogram phase_hist[Fl_Event_Stats::PHASE_COUNT];
+std::vector<Window_Entry> window_hist;
+
+Fl_Event_Stats::Slow_Callback slow_ring[SLOW_RING_SIZE];
+int slow_count = 0;     // number of valid entries in slow_ring
+int slow_next = 0;      // next slot to be written
+double slow_threshold = 0.05;
+Fl_Event_Stats::Slow_Callback_Handler slow_handler = 0;
+void *slow_handler_data = 0;
+
+std::vector<Trace_Event> trace_ring;
+int trace_next = 0;
+bool trace_wrapped = false;
+
+Fl_Timestamp origin;
+bool origin_set = false;
+
+const char *phase_names[Fl_Event_Stats::PHASE_COUNT] = {
+  "wait", "fd_callback", "timeout", "check", "idle", "awake",
+  "handle", "widget_callback", "flush", "widget_deletion"
+};
+
+long long usec_between(const Fl_Timestamp &a, const Fl_Timestamp &b) {
+  return (long long)(a.sec - b.sec) * 1000000 + (a.usec - b.usec);
+}
+
+void set_origin() {
+  origin = Fl::now();
+  origin_set = true;
+}
+
+void add_trace_event(int phase, const void *address, const Fl_Timestamp &start, long long duration) {
+  if (trace_ring.empty()) return;
+  Trace_Event &ev = trace_ring[trace_next];
+  ev.phase = phase;
+  ev.address = address;
+  ev.start = usec_between(start, origin);
+  ev.duration = duration;
+  if (++trace_next >= (int)trace_ring.size()) {
+    trace_next = 0;
+    trace_wrapped = true;
+  }
+}
+
+long long duration_since(const Fl_Timestamp &start, Fl_Timestamp &now) {
+  now = Fl::now();
+  long long d = usec_between(now, start);
+  return d < 0 ? 0 : d;
+}
+
+// write a string as a JSON string literal
+void write_json_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; s && *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+    else if (c < 0x20) fprintf(f, "\\u%04x", c);
+    else fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+void write_histogram(FILE *f, const Fl_Event_Stats::Histogram &h) {
+  fprintf(f, "{\"count\": %lu, \"min\": %lld, \"max\": %lld, \"mean\": %.1f, "
+          "\"total\": %.0f, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"p999\": %lld}",
+          h.count(), h.min(), h.max(), h.mean(), h.total(),
+          h.percentile(50.0), h.percentile(90.0),
+          h.percentile(99.0), h.percentile(99.9));
+}
+
+} // anonymous namespace
+
+
+// ---- Fl_Event_Stats::Histogram ----
+
+/**
+  Removes all recorded values.
+*/
+void Fl_Event_Stats::Histogram::clear() {
+  for (int i = 0; i < BUCKETS; i++)
+    counts_[i] = 0;
+  count_ = 0;
+  min_ = max_ = 0;
+  sum_ = 0.0;
+}
+
+// Returns the bucket index for the given value.
+int Fl_Event_Stats::Histogram::bucket_(long long usec) {
+  if (usec < 16) return usec < 0 ? 0 : (int)usec;
+  int e = 4;                          // index of the most significant bit
+  while (e < 62 && (usec >> (e + 1)) != 0) e++;
+  int sub = (int)(usec >> (e - 3)) - 8; // 0 ... 7
+  int b = 16 + (e - 4) * 8 + sub;
+  return b < BUCKETS ? b : BUCKETS - 1;
+}
+
+// Returns the highest value that is counted in bucket \p b.
+long long Fl_Event_Stats::Histogram::bucket_value_(int b) {
+  if (b < 16) return b;
+  int e = (b - 16) / 8 + 4;
+  int sub = (b - 16) % 8;
+  return ((long long)(sub + 9) << (e - 3)) - 1;
+}
+
+/**
+  Records one value.
+  \param[in] usec   duration in microseconds
+*/
+void Fl_Event_Stats::Histogram::record(long long usec) {
+  if (usec < 0) usec = 0;
+  counts_[bucket_(usec)]++;
+  if (!count_ || usec < min_) min_ = usec;
+  if (usec > max_) max_ = usec;
+  count_++;
+  sum_ += usec;
+}
+
+/**
+  Returns the value below which the given percentage of all values fall.
+
+  The returned value is the upper limit of the bucket that contains the
+  requested percentile, limited to the range min() ... max().
+
+  \param[in] p  percentage (0.0 ... 100.0), e.g. 99.0 for the 99th percentile
+  \return the percentile in microseconds, 0 if no values were recorded
+*/
+long long Fl_Event_Stats::Histogram::percentile(double p) const {
+  if (!count_) return 0;
+  if (p < 0.0) p = 0.0;
+  if (p > 100.0) p = 100.0;
+  double target = ceil(p / 100.0 * count_);
+  if (target < 1.0) target = 1.0;
+  double seen = 0.0;
+  for (int b = 0; b < BUCKETS; b++) {
+    seen += counts_[b];
+    if (seen >= target) {
+      long long v = b < BUCKETS - 1 ? bucket_value_(b) : max_;  // last bucket: open ended
+      if (v > max_) v = max_;
+      if (v < min_) v = min_;
+      return v;
+    }
+  }
+  return max_;
+}
+
+
+// ---- Fl_Event_Stats ----
+
+/**
+  Returns whether the event loop instrumentation was compiled into FLTK.
+  \see CMake option FLTK_OPTION_EVENT_STATS
+*/
+bool Fl_Event_Stats::available() {
+  return FLTK_HAVE_EVENT_STATS ? true : false;
+}
+
+/**
+  Starts or stops recording.
+
+  Recorded data is kept when recording is stopped, use reset() to clear it.
+  This does nothing if the instrumentation is not available().
+*/
+void Fl_Event_Stats::enable(bool on) {
+  if (!available()) return;
+  if (on && !origin_set) set_origin();
+  enabled_ = on;
+}
+
+/**
+  Returns whether recording is enabled.
+*/
+bool Fl_Event_Stats::enabled() {
+  return enabled_;
+}
+
+/**
+  Clears all recorded data.
+
+  Times reported in Slow_Callback::when and in the trace are relative
+  to the last call of reset() or the first call of enable(true).
+*/
+void Fl_Event_Stats::reset() {
+  for (int i = 0; i < PHASE_COUNT; i++)
+    phase_hist[i].clear();
+  for (size_t i = 0; i < window_hist.size(); i++)
+    delete window_hist[i].hist;
+  window_hist.clear();
+  slow_count = slow_next = 0;
+  trace_next = 0;
+  trace_wrapped = false;
+  set_origin();
+}
+
+/**
+  Returns a short name of the given phase, e.g. "flush".
+*/
+const char *Fl_Event_Stats::phase_name(Phase p) {
+  if (p < 0 || p >= PHASE_COUNT) return "unknown";
+  return phase_names[p];
+}
+
+/**
+  Returns the histogram of durations of the given phase.
+*/
+const Fl_Event_Stats::Histogram &Fl_Event_Stats::histogram(Phase p) {
+  if (p < 0 || p >= PHASE_COUNT) p = WAIT;
+  return phase_hist[p];
+}
+
+/**
+  Returns the number of windows with recorded drawing times.
+  \see window(int), window_histogram()
+*/
+int Fl_Event_Stats::windows() {
+  return (int)window_hist.size();
+}
+
+/**
+  Returns the i-th window with recorded drawing times.
+
+  Windows are removed from the statistics when they are deleted.
+
+  \param[in] i  index 0 ... windows() - 1
+  \return the window or NULL if \p i is out of range
+*/
+const Fl_Window *Fl_Event_Stats::window(int i) {
+  if (i < 0 || i >= (int)window_hist.size()) return 0;
+  return window_hist[i].win;
+}
+
+/**
+  Returns the histogram of drawing times of a window.
+  \return the histogram or NULL if no drawing time was recorded for \p win
+*/
+const Fl_Event_Stats::Histogram *Fl_Event_Stats::window_histogram(const Fl_Window *win) {
+  for (size_t i = 0; i < window_hist.size(); i++) {
+    if (window_hist[i].win == win) return window_hist[i].hist;
+  }
+  return 0;
+}
+
+/**
+  Sets the minimal duration of a callback to be reported as slow.
+
+  The default is 0.05 seconds (50 ms). Use 0 to disable slow callback
+  detection.
+
+  \param[in] seconds  threshold in seconds
+*/
+void Fl_Event_Stats::slow_callback_threshold(double seconds) {
+  slow_threshold = seconds;
+}
+
+/**
+  Returns the minimal duration of a callback to be reported as slow.
+*/
+double Fl_Event_Stats::slow_callback_threshold() {
+  return slow_threshold;
+}
+
+/**
+  Returns the number of stored slow callbacks.
+
+  Only the last 64 slow callbacks are stored.
+*/
+int Fl_Event_Stats::slow_callbacks() {
+  return slow_count;
+}
+
+/**
+  Returns a stored slow callback.
+  \param[in] i  index 0 (oldest) ... slow_callbacks() - 1 (newest)
+  \return the slow callback or NULL if \p i is out of range
+*/
+const Fl_Event_Stats::Slow_Callback *Fl_Event_Stats::slow_callback(int i) {
+  if (i < 0 || i >= slow_count) return 0;
+  int first = (slow_count < SLOW_RING_SIZE) ? 0 : slow_next;
+  return &slow_ring[(first + i) % SLOW_RING_SIZE];
+}
+
+/**
+  Sets a function that is called whenever a slow callback is detected.
+
+  The handler is called by the event loop right after the slow callback
+  returned. Use NULL to remove the handler.
+*/
+void Fl_Event_Stats::slow_callback_handler(Slow_Callback_Handler h, void *data) {
+  slow_handler = h;
+  slow_handler_data = data;
+}
+
+/**
+  Enables recording of a trace of individual event loop phases.
+
+  The trace is stored in a ring buffer of \p max_events entries so only
+  the most recent events are kept. It can be written in the Chrome trace
+  event format with write_trace().
+
+  \param[in] max_events  size of the ring buffer, 0 disables tracing
+*/
+void Fl_Event_Stats::trace(int max_events) {
+  if (max_events < 0) max_events = 0;
+  trace_ring.clear();
+  trace_ring.resize(max_events);
+  trace_next = 0;
+  trace_wrapped = false;
+}
+
+/**
+  Returns the size of the trace ring buffer, 0 if tracing is disabled.
+*/
+int Fl_Event_Stats::trace() {
+  return (int)trace_ring.size();
+}
+
+/**
+  Writes all statistics as a JSON object.
+
+  The object has the members "phases" (one histogram summary per phase),
+  "windows" (drawing time summary per window) and "slow_callbacks".
+  All durations are in microseconds.
+
+  \param[in] f  output file
+  \return 0 on success, -1 on write error
+*/
+int Fl_Event_Stats::write_json(FILE *f) {
+  if (!f) return -1;
+  fprintf(f, "{\n  \"available\": %s,\n  \"phases\": {\n", available() ? "true" : "false");
+  for (int i = 0; i < PHASE_COUNT; i++) {
+    fprintf(f, "    \"%s\": ", phase_names[i]);
+    write_histogram(f, phase_hist[i]);
+    fprintf(f, "%s\n", i < PHASE_COUNT - 1 ? "," : "");
+  }
+  fprintf(f, "  },\n  \"windows\": [\n");
+  for (size_t i = 0; i < window_hist.size(); i++) {
+    fprintf(f, "    {\"window\": \"%p\", \"label\": ", (const void *)window_hist[i].win);
+    write_json_string(f, window_hist[i].win->label());
+    fprintf(f, ", \"draw\": ");
+    write_histogram(f, *window_hist[i].hist);
+    fprintf(f, "}%s\n", i + 1 < window_hist.size() ? "," : "");
+  }
+  fprintf(f, "  ],\n  \"slow_callbacks\": [\n");
+  for (int i = 0; i < slow_count; i++) {
+    const Slow_Callback *s = slow_callback(i);
+    fprintf(f, "    {\"phase\": \"%s\", \"address\": \"%p\", \"usec\": %lld, \"when\": %.6f}%s\n",
+            phase_name(s->phase), s->address, s->usec, s->when,
+            i < slow_count - 1 ? "," : "");
+  }
+  fprintf(f, "  ]\n}\n");
+  return ferror(f) ? -1 : 0;
+}
+
+/**
+  Writes the recorded trace in the Chrome trace event format.
+
+  The output can be loaded into chrome://tracing, Perfetto and other tools.
+  Nothing useful is written unless tracing was enabled with trace(int).
+
+  \param[in] f  output file
+  \return 0 on success, -1 on write error
+*/
+int Fl_Event_Stats::write_trace(FILE *f) {
+  if (!f) return -1;
+  fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  int n = trace_wrapped ? (int)trace_ring.size() : trace_next;
+  int first = trace_wrapped ? trace_next : 0;
+  for (int i = 0; i < n; i++) {
+    const Trace_Event &ev = trace_ring[(first + i) % trace_ring.size()];
+    const char *name = ev.phase < 0 ? "draw" : phase_names[ev.phase];
+    fprintf(f, "  {\"name\": \"%s\", \"cat\": \"fltk\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+            "\"ts\": %lld, \"dur\": %lld, \"args\": {\"%s\": \"%p\"}}%s\n",
+            name, ev.start, ev.duration, ev.phase < 0 ? "window" : "address",
+            ev.address, i < n - 1 ? "," : "");
+  }
+  fprintf(f, "]}\n");
+  return ferror(f) ? -1 : 0;
+}
+
+/*
+  Internal: records the duration of a phase that started at \p start.
+  \p address is the address of the called function or NULL.
+*/
+void Fl_Event_Stats::record_(Phase p, const Fl_Timestamp &start, const void *address) {
+  Fl_Timestamp now;
+  long long d = duration_since(start, now);
+  phase_hist[p].record(d);
+  add_trace_event(p, address, start, d);
+  if (address && slow_threshold > 0.0 && d >= slow_threshold * 1e6) {
+    Slow_Callback &s = slow_ring[slow_next];
+    s.phase = p;
+    s.address = address;
+    s.usec = d;
+    s.when = usec_between(now, origin) / 1e6;
+    slow_next = (slow_next + 1) % SLOW_RING_SIZE;
+    if (slow_count < SLOW_RING_SIZE) slow_count++;
+    if (slow_handler) slow_handler(s, slow_handler_data);
+  }
+}
+
+/*
+  Internal: records the drawing time of a window.
+*/
+void Fl_Event_Stats::record_window_(const Fl_Window *win, const Fl_Timestamp &start) {
+  Fl_Timestamp now;
+  long long d = duration_since(start, now);
+  Histogram *h = (Histogram *)window_histogram(win);
+  if (!h) {
+    Window_Entry e;
+    e.win = win;
+    e.hist = h = new Histogram;
+    window_hist.push_back(e);
+  }
+  h->record(d);
+  add_trace_event(-1, win, start, d);
+}
+
+/*
+  Internal: removes a window from the statistics, called when it is deleted.
+*/
+void Fl_Event_Stats::forget_window_(const Fl_Window *win) {
+  for (size_t i = 0; i < window_hist.size(); i++) {
+    if (window_hist[i].win == win) {
+      delete window_hist[i].hist;
+      window_hist.erase(window_hist.begin() + i);
+      return;
+    }
+  }
+}
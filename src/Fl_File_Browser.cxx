@@ -16,12 +16,13 @@
 //
 // Contents:
 //
-//   Fl_File_Browser::full_height()     - Return the height of the list.
 //   Fl_File_Browser::item_height()     - Return the height of a list item.
 //   Fl_File_Browser::item_width()      - Return the width of a list item.
 //   Fl_File_Browser::item_draw()       - Draw a list item.
 //   Fl_File_Browser::Fl_File_Browser() - Create a Fl_File_Browser widget.
 //   Fl_File_Browser::load()            - Load a directory into the browser.
+//   Fl_File_Browser::load_async()      - Load a directory in the background.
+//   Fl_File_Browser::cancel_load()     - Stop loading a directory.
 //   Fl_File_Browser::filter()          - Set the filename filter.
 //
 
@@ -36,27 +37,213 @@
 #include <FL/filename.H>
 #include <FL/fl_string_functions.h>
 #include <FL/Fl_Image.H>        // icon
+#include <FL/Fl_Task_Pool.H>
+#include <FL/fl_utf8.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
 #include "flstring.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
+// Flag of lines whose icon has not been looked up yet (see item_draw())
+static const char BLINE_ICON_PENDING = 4;
+
+// Number of entries that load_async() adds to the browser at once
+static const size_t LOAD_BATCH = 2000;
+
+
 //
-// 'Fl_File_Browser::full_height()' - Return the height of the list.
+// Directory listings...
 //
 
-int                                     // O - Height in pixels
-Fl_File_Browser::full_height() const
-{
-  int   i,                              // Looping var
-        th;                             // Total height of list.
+/*
+  A directory listing as returned by fl_filename_list(): the sorted names
+  of the entries, directories have a trailing '/'.
+
+  The last listing is kept and used again by load() and load_async() for
+  the same directory and sort function as long as the modification time
+  of the directory doesn't change. This makes reloading a directory, e.g.
+  after changing the filter of Fl_File_Chooser, cheap. The listing is
+  only used again if it was started at least two seconds after the last
+  modification of the directory, because the modification time has a
+  resolution of one second.
+
+  Listings are shared with load_async() calls that still add their
+  entries to a browser.
+*/
+struct Fl_File_Listing {
+  std::string directory;
+  Fl_File_Sort_F *sort;
+  time_t mtime;                         // modification time of the directory
+  time_t time;                          // time when the listing was started
+  std::vector<std::string> names;
+};
+
+typedef std::shared_ptr<const Fl_File_Listing> Fl_File_Listing_Ptr;
+
+static Fl_File_Listing_Ptr last_listing; // accessed by the main thread only
+
+// Returns the last listing if it is still valid for 'directory'
+static Fl_File_Listing_Ptr cached_listing(const char *directory, Fl_File_Sort_F *sort) {
+  struct stat st;
+  if (!last_listing || last_listing->sort != sort ||
+      last_listing->directory != directory ||
+      fl_stat(directory, &st) != 0 ||
+      st.st_mtime != last_listing->mtime ||
+      last_listing->time < last_listing->mtime + 2)
+    return Fl_File_Listing_Ptr();
+  return last_listing;
+}
+
+// Returns a new listing of 'directory' without names, must be called by the
+// main thread: fl_stat() isn't thread-safe on all platforms (Windows).
+static Fl_File_Listing *new_listing(const char *directory, Fl_File_Sort_F *sort) {
+  Fl_File_Listing *listing = new Fl_File_Listing;
+  struct stat st;
+  listing->directory = directory;
+  listing->sort = sort;
+  listing->time = time(0);
+  listing->mtime = fl_stat(directory, &st) == 0 ? st.st_mtime : listing->time;
+  return listing;
+}
+
+// Reads the names of a new listing. This may be called by a worker thread.
+// The listing has no names on errors.
+static void read_listing(Fl_File_Listing *listing, char *emsg, int emsg_sz) {
+  char filename[4096];
+  dirent **files;
+  int n = Fl::system_driver()->file_browser_load_directory(listing->directory.c_str(),
+                                                           filename, sizeof(filename),
+                                                           &files, listing->sort,
+                                                           emsg, emsg_sz);
+  if (n <= 0) return;
+  listing->names.reserve(n);
+  for (int i = 0; i < n; i++) {
+    listing->names.push_back(files[i]->d_name);
+    free(files[i]);
+  }
+  free(files);
+}
+
+// Returns the icon of a file in 'directory'
+static Fl_File_Icon *find_icon(const char *directory, const char *name) {
+  char filename[4096];
+  fl_snprintf(filename, sizeof(filename), "%s/%s", directory ? directory : "", name);
+  size_t len = strlen(name);
+  if (len && name[len - 1] == '/')      // no need to stat() directories
+    return Fl_File_Icon::find(filename, Fl_File_Icon::DIRECTORY);
+  return Fl_File_Icon::find(filename);
+}
+
+
+//
+// Fl_File_Browser_Loader: state of load_async()...
+//
 
+/*
+  A worker thread reads the directory, then the main thread adds the
+  entries to the browser in batches of LOAD_BATCH entries from a timeout,
+  so that the user interface stays responsive for large directories.
 
-  for (i = 0, th = 0; i < size(); i ++)
-    th += item_height(find_line(i)) + linespacing();
+  'browser' is set to NULL by cancel_load() while the worker thread reads
+  the directory. The completion handler done() deletes the loader then.
+  While the entries are added, cancel_load() deletes the loader itself.
+*/
+class Fl_File_Browser_Loader {
+public:
+  Fl_File_Browser *browser;
+  std::unique_ptr<Fl_File_Listing> result; // names read by the worker thread
+  char emsg[1024];
+  Fl_File_Listing_Ptr listing;          // the entries being added
+  size_t next;                          // index of the next entry to add
+  int num_dirs;                         // number of directories added
+  bool filling;                         // adding the entries
+
+  Fl_File_Browser_Loader(Fl_File_Browser *fb, const char *d, Fl_File_Sort_F *s)
+    : browser(fb), result(new_listing(d, s)), next(0), num_dirs(0), filling(false) {
+    emsg[0] = '\0';
+  }
 
-  return (th);
+  static void add(Fl_File_Browser *fb, const Fl_File_Listing &l,
+                  size_t first, size_t last, int &num_dirs);
+  static void read(void *data);
+  static void done(void *data);
+  static void fill(void *data);
+  static void finish(Fl_File_Browser_Loader *loader);
+};
+
+// Adds the entries first to last-1 of a listing: directories after the
+// directories added before, files (if shown) at the end
+void Fl_File_Browser_Loader::add(Fl_File_Browser *fb, const Fl_File_Listing &l,
+                                 size_t first, size_t last, int &num_dirs) {
+  std::vector<const char *> files;
+  for (size_t i = first; i < last; i++) {
+    const std::string &name = l.names[i];
+    if (name == "./") continue;
+    // fl_filename_list() appends a '/' to directories, no need to stat() them
+    if (!name.empty() && name[name.size() - 1] == '/') {
+      fb->insert(++num_dirs, name.c_str());
+      fb->bline_flags(fb->find_line(num_dirs)) |= BLINE_ICON_PENDING;
+    } else if (fb->filetype_ == Fl_File_Browser::FILES &&
+               fl_filename_match(name.c_str(), fb->pattern_)) {
+      files.push_back(name.c_str());
+    }
+  }
+  if (files.empty()) return;
+  fb->add_lines(&files[0], (int)files.size());
+  FL_BLINE *line = (FL_BLINE *)fb->item_last();
+  for (size_t i = 0; i < files.size(); i++, line = (FL_BLINE *)fb->item_prev(line))
+    fb->bline_flags(line) |= BLINE_ICON_PENDING;
 }
 
+// Reads the directory, runs in a worker thread
+void Fl_File_Browser_Loader::read(void *data) {
+  Fl_File_Browser_Loader *loader = (Fl_File_Browser_Loader *)data;
+  read_listing(loader->result.get(), loader->emsg, sizeof(loader->emsg));
+}
+
+// Completion handler of read(), runs in the main thread
+void Fl_File_Browser_Loader::done(void *data) {
+  Fl_File_Browser_Loader *loader = (Fl_File_Browser_Loader *)data;
+  if (!loader->browser) {               // cancelled
+    delete loader;
+    return;
+  }
+  if (loader->result->names.empty()) {
+    loader->browser->errmsg(loader->emsg);
+    finish(loader);
+    return;
+  }
+  loader->listing.reset(loader->result.release());
+  last_listing = loader->listing;
+  loader->filling = true;
+  fill(loader);
+}
+
+// Adds the next batch of entries to the browser
+void Fl_File_Browser_Loader::fill(void *data) {
+  Fl_File_Browser_Loader *loader = (Fl_File_Browser_Loader *)data;
+  size_t count = loader->listing->names.size();
+  size_t last = loader->next + LOAD_BATCH < count ? loader->next + LOAD_BATCH : count;
+  add(loader->browser, *loader->listing, loader->next, last, loader->num_dirs);
+  loader->next = last;
+  if (last < count)
+    Fl::add_timeout(0.0, fill, loader);
+  else
+    finish(loader);
+}
+
+// Deletes the loader and calls the load callback of the browser
+void Fl_File_Browser_Loader::finish(Fl_File_Browser_Loader *loader) {
+  Fl_File_Browser *fb = loader->browser;
+  fb->loader_ = 0;
+  delete loader;
+  if (fb->load_cb_) fb->load_cb_(fb, fb->load_data_);
+}
 
 //
 // 'Fl_File_Browser::item_height()' - Return the height of a list item.
@@ -71,6 +258,11 @@ Fl_File_Browser::item_height(void *p) const     // I - List item data
   int           textheight;             // Height of text
 
 
+  // Hidden lines don't use any space...
+  line = (FL_BLINE*)p;
+  if (line && (bline_flags((const FL_BLINE*)line) & (BLINE_NOTDISPLAYED | BLINE_FILTERED)))
+    return 0;
+
   // Figure out the standard text height...
   fl_font(textfont(), textsize());
   textheight = fl_height();
@@ -79,7 +271,6 @@ Fl_File_Browser::item_height(void *p) const     // I - List item data
   height = textheight;
 
   // Scan for newlines...
-  line = (FL_BLINE*)p;
   const char* line_txt = bline_txt(line);
 
   if (line != NULL)
@@ -229,6 +420,13 @@ Fl_File_Browser::item_draw(void *p,     // I - List item data
   // Draw the list item text...
   line = (FL_BLINE*)p;
   const char* line_txt = bline_txt(line);
+
+  // Look up the icon when the line is drawn for the first time...
+  if ((bline_flags(line) & BLINE_ICON_PENDING) && Fl_File_Icon::first() != NULL) {
+    bline_flags(line) &= ~BLINE_ICON_PENDING;
+    bline_data(line) = find_icon(directory_, line_txt);
+  }
+
   const char line_flags = bline_flags(line);
   const void* line_data = bline_data(line);
 
@@ -347,16 +545,41 @@ Fl_File_Browser::Fl_File_Browser(int        X,  // I - Upper-lefthand X coordina
 {
   // Initialize the filter pattern, current directory, and icon size...
   pattern_   = "*";
-  directory_ = "";
+  directory_ = NULL;
   iconsize_  = (uchar)(3 * textsize() / 2);
   filetype_  = FILES;
   errmsg_    = NULL;
+  loader_    = NULL;
+  load_cb_   = NULL;
+  load_data_ = NULL;
 }
 
 
 // DTOR
 Fl_File_Browser::~Fl_File_Browser() {
+  cancel_load();
   errmsg(NULL);       // free()s prev errmsg, if any
+  set_directory_(NULL);
+}
+
+
+// Sets the directory of the browser to a copy of 'd', which can be NULL
+void Fl_File_Browser::set_directory_(const char *d) {
+  if (directory_) free((void *)directory_);
+  directory_ = d ? fl_strdup(d) : NULL;
+}
+
+
+/**
+  Sets the default text size of the lines and the icon size.
+  The icon size is set to 3/2 of the text size.
+*/
+void Fl_File_Browser::textsize(Fl_Fontsize s) {
+  iconsize_ = (uchar)(3 * s / 2);
+  if (s != textsize())
+    Fl_Browser::textsize(s);    // updates the heights
+  else
+    update_heights();
 }
 
 
@@ -374,6 +597,7 @@ void Fl_File_Browser::errmsg(const char* emsg) {
 /**
   Loads the specified directory into the browser. If icons have been
   loaded then the correct icon is associated with each file in the list.
+  The icons are looked up when the lines are drawn for the first time.
 
   If directory is "", all mount points (unix) or drive letters (Windows)
   are listed.
@@ -381,26 +605,32 @@ void Fl_File_Browser::errmsg(const char* emsg) {
   The sort argument specifies a sort function to be used with
   fl_filename_list().
 
+  The listing of the last directory that was loaded is kept, and loading
+  the same directory again with the same sort function uses it as long as
+  the modification time of the directory doesn't change.
+
   Return value is the number of filename entries, or 0 if none.
   On error, 0 is returned, and errmsg() has OS error string if non-NULL.
+
+  \see load_async()
 */
 int                                             // O - Number of files loaded
 Fl_File_Browser::load(const char     *directory,// I - Directory to load
                       Fl_File_Sort_F *sort)     // I - Sort function to use
 {
-  int           i;                              // Looping var
   int           num_files;                      // Number of files in directory
   int           num_dirs;                       // Number of directories in list
   char          filename[4096];                 // Current file
   Fl_File_Icon  *icon;                          // Icon to use
 
+  cancel_load();
   errmsg(NULL); // clear errors first
 
 //  printf("Fl_File_Browser::load(\"%s\")\n", directory);
 
   clear();
 
-  directory_ = directory;
+  set_directory_(directory);
 
   if (!directory) {
     errmsg("NULL directory specified");
@@ -416,46 +646,106 @@ Fl_File_Browser::load(const char     *directory,// I - Directory to load
       icon = Fl_File_Icon::find("any", Fl_File_Icon::DIRECTORY);
     num_files = Fl::system_driver()->file_browser_load_filesystem(this, filename, (int)sizeof(filename), icon);
   } else {
-    dirent **files;        // Files in in directory
-    char emsg[1024] = "";
-
-    // Build the file list, check for errors
-    num_files = Fl::system_driver()->file_browser_load_directory(directory_,
-                                                                 filename, sizeof(filename),
-                                                                 &files, sort,
-                                                                 emsg, sizeof(emsg));
-    // printf("Fl_File_Browser::load(dir='%s',filename='%s'): failed, emsg='%s'\n", directory_, filename, emsg);
-
-    if (num_files <= 0) {
-      errmsg(emsg);
-      return 0;
-    }
+    Fl_File_Listing_Ptr listing = cached_listing(directory_, sort);
 
-    for (i = 0, num_dirs = 0; i < num_files; i ++) {
-      if (strcmp(files[i]->d_name, "./")) {
-        fl_snprintf(filename, sizeof(filename), "%s/%s", directory_, files[i]->d_name);
-
-        icon = Fl_File_Icon::find(filename);
-        if ((icon && icon->type() == Fl_File_Icon::DIRECTORY) ||
-            Fl::system_driver()->filename_isdir_quick(filename)) {
-          num_dirs ++;
-          insert(num_dirs, files[i]->d_name, icon);
-        } else if (filetype_ == FILES &&
-                   fl_filename_match(files[i]->d_name, pattern_)) {
-          add(files[i]->d_name, icon);
-        }
-      }
+    if (!listing) {
+      char emsg[1024] = "";
 
-      free(files[i]);
+      // Build the file list, check for errors
+      Fl_File_Listing *l = new_listing(directory_, sort);
+      listing.reset(l);
+      read_listing(l, emsg, sizeof(emsg));
+      // printf("Fl_File_Browser::load(dir='%s'): failed, emsg='%s'\n", directory_, emsg);
+
+      if (listing->names.empty()) {
+        errmsg(emsg);
+        return 0;
+      }
+      last_listing = listing;
     }
 
-    free(files);
+    num_dirs  = 0;
+    num_files = (int)listing->names.size();
+    Fl_File_Browser_Loader::add(this, *listing, 0, listing->names.size(), num_dirs);
   }
 
   return (num_files);
 }
 
 
+/**
+  Loads the specified directory into the browser in the background.
+
+  Other than load() this method returns immediately. A worker thread reads
+  the directory (see Fl_Task_Pool), and when it is done the entries are
+  added to the browser in batches, so that the user interface stays
+  responsive even for very large or slow (network) directories. loading()
+  returns non-zero until all entries were added, then the load_callback()
+  is called.
+
+  The listing of the mount points or drive letters (\p directory "") and
+  a listing that can be used again (see load()) are loaded immediately, and
+  the load_callback() is called before this method returns.
+
+  Calling load(), load_async() or cancel_load() cancels a previous call of
+  load_async(). If the browser is changed otherwise (e.g. by clear()) while
+  entries are added, the result is undefined.
+
+  \param[in] directory  directory to load
+  \param[in] sort       sort function used with fl_filename_list()
+  \return 1 if the directory is loaded, 0 on errors (see errmsg())
+
+  \see load(), loading(), cancel_load(), load_callback()
+*/
+int
+Fl_File_Browser::load_async(const char     *directory,
+                            Fl_File_Sort_F *sort)
+{
+  cancel_load();
+
+  if (!directory || !directory[0] || cached_listing(directory, sort)) {
+    // nothing to wait for
+    int num_files = load(directory, sort);
+    if (load_cb_) load_cb_(this, load_data_);
+    return num_files > 0;
+  }
+
+  errmsg(NULL);
+  clear();
+  set_directory_(directory);
+
+  Fl_File_Browser_Loader *loader = new Fl_File_Browser_Loader(this, directory_, sort);
+  loader_ = loader;
+  if (!Fl::run_async(Fl_File_Browser_Loader::read, loader, Fl_File_Browser_Loader::done)) {
+    // the queue is full
+    loader_ = NULL;
+    delete loader;
+    int num_files = load(directory, sort);
+    if (load_cb_) load_cb_(this, load_data_);
+    return num_files > 0;
+  }
+  return 1;
+}
+
+
+/**
+  Stops loading a directory with load_async(). The entries that were
+  already added stay in the browser, the load_callback() is not called.
+*/
+void
+Fl_File_Browser::cancel_load()
+{
+  if (!loader_) return;
+  if (loader_->filling) {
+    Fl::remove_timeout(Fl_File_Browser_Loader::fill, loader_);
+    delete loader_;
+  } else {
+    loader_->browser = NULL;    // deleted when the directory was read
+  }
+  loader_ = NULL;
+}
+
+
 //
 // 'Fl_File_Browser::filter()' - Set the filename filter.
 //
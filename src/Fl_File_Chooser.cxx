@@ -312,6 +312,8 @@ Fl_File_Chooser::Fl_File_Chooser(const char *pathname, const char *pattern, int
   callback_ = 0;
   data_ = 0;
   directory_[0] = 0;
+  select_name_[0] = 0;
+  fileList->load_callback(fileListLoadCB, this);
   window->size_range(window->w(), window->h());
   type(type_val);
   filter(pattern);
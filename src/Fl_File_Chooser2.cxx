@@ -323,6 +323,7 @@
 //   Fl_File_Chooser::newdir()            - Make a new directory.
 //   Fl_File_Chooser::value()             - Return a selected filename.
 //   Fl_File_Chooser::rescan()            - Rescan the current directory.
+//   Fl_File_Chooser::fileListLoadCB()    - Handle the end of loading the file list.
 //   Fl_File_Chooser::favoritesButtonCB() - Handle favorites selections.
 //   Fl_File_Chooser::fileListCB()        - Handle clicks (and double-clicks)
 //                                          in the Fl_File_Browser.
@@ -1091,18 +1092,52 @@ Fl_File_Chooser::rescan()
   else
     okButton->deactivate();
 
-  // Build the file list...
-  if ( fileList->load(directory_, sort) <= 0 ) {
-    if ( fileList->errmsg() ) errorBox->label(fileList->errmsg());     // show OS errormsg when possible
-    else                      errorBox->label("No files found...");
-    show_error_box(1);
+  // Build the file list, fileListLoadCB() is called when it's done...
+  select_name_[0] = '\0';
+  fileList->load_async(directory_, sort);
+}
+
+
+//
+// 'Fl_File_Chooser::fileListLoadCB()' - Handle the end of loading the file list.
+//
+
+void
+Fl_File_Chooser::fileListLoadCB(Fl_Widget *, void *d)
+{
+  Fl_File_Chooser *fc = (Fl_File_Chooser *)d;
+  int i;
+
+  if ( fc->fileList->errmsg() || fc->fileList->size() <= 0 ) {
+    if ( fc->fileList->errmsg() ) fc->errorBox->label(fc->fileList->errmsg()); // show OS errormsg when possible
+    else                          fc->errorBox->label("No files found...");
+    fc->show_error_box(1);
   } else {
-    show_error_box(0);
+    fc->show_error_box(0);
   }
 
-  if (Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value()) remove_hidden_files();
+  if (Fl::system_driver()->dot_file_hidden() && !fc->showHiddenButton->value()) fc->remove_hidden_files();
   // Update the preview box...
-  update_preview();
+  fc->update_preview();
+
+  if (!fc->select_name_[0]) return;
+
+  // Select the chosen file (see rescan_keep_filename() and value())
+  char found = 0;
+  for (i = 1; i <= fc->fileList->size(); i ++)
+    if ( (Fl::system_driver()->case_insensitive_filenames() ? strcasecmp(fc->fileList->text(i), fc->select_name_) : strcmp(fc->fileList->text(i), fc->select_name_)) == 0) {
+      fc->fileList->topline(i);
+      fc->fileList->select(i);
+      found = 1;
+      break;
+    }
+  fc->select_name_[0] = '\0';
+
+  // update OK button activity
+  if (found || fc->type_ & CREATE)
+    fc->okButton->activate();
+  else
+    fc->okButton->deactivate();
 }
 
 /**
@@ -1118,42 +1153,10 @@ void Fl_File_Chooser::rescan_keep_filename()
     return;
   }
 
-  int   i;
-  char  pathname[FL_PATH_MAX];          // New pathname for filename field
-  strlcpy(pathname, fn, sizeof(pathname));
-
-  // Build the file list...
-  if (fileList->load(directory_, sort) <= 0) {
-    if ( fileList->errmsg() ) errorBox->label(fileList->errmsg());     // show OS errormsg when possible
-    else                      errorBox->label("No files found...");
-    show_error_box(1);
-  } else {
-    show_error_box(0);
-  }
-  if (Fl::system_driver()->dot_file_hidden() && !showHiddenButton->value()) remove_hidden_files();
-  // Update the preview box...
-  update_preview();
-
-  // and select the chosen file
-  char found = 0;
-  char *slash = strrchr(pathname, '/');
-  if (slash)
-    slash++;
-  else
-    slash = pathname;
-  for (i = 1; i <= fileList->size(); i ++)
-    if ( (Fl::system_driver()->case_insensitive_filenames() ? strcasecmp(fileList->text(i), slash) : strcmp(fileList->text(i), slash)) == 0) {
-      fileList->topline(i);
-      fileList->select(i);
-      found = 1;
-      break;
-    }
-
-  // update OK button activity
-  if (found || type_ & CREATE)
-    okButton->activate();
-  else
-    okButton->deactivate();
+  // Build the file list, fileListLoadCB() selects the chosen file...
+  const char *slash = strrchr(fn, '/');
+  strlcpy(select_name_, slash ? slash + 1 : fn, sizeof(select_name_));
+  fileList->load_async(directory_, sort);
 }
 
 
@@ -1540,6 +1543,12 @@ Fl_File_Chooser::value(const char *filename)
   okButton->activate();
 
   // Then find the file in the file list and select it...
+  if (fileList->loading()) {
+    // ...when it is loaded (see fileListLoadCB())
+    strlcpy(select_name_, slash, sizeof(select_name_));
+    return;
+  }
+
   fcount = fileList->size();
 
   fileList->deselect(0);
@@ -1578,7 +1587,7 @@ void Fl_File_Chooser::hide() {
 void Fl_File_Chooser::showHidden(int value)
 {
   if (value) {
-    fileList->load(directory());
+    fileList->load_async(directory());
   } else {
     remove_hidden_files();
     fileList->redraw();
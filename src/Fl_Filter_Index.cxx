@@ -0,0 +1,103 @@
+//
+// Label filter for Fl_Browser and Fl_Tree for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Filter_Index.H"
+
+#include <FL/fl_utf8.h>
+#include <string.h>
+
+Fl_Filter_Index::Fl_Filter_Index(bool caseinsensitive)
+  : caseinsensitive_(caseinsensitive), valid_(true), applied_(false) {
+}
+
+// Appends s to out, converted to lower case if the index is case insensitive
+void Fl_Filter_Index::fold(const char *s, std::string &out) const {
+  if (!caseinsensitive_) {
+    out += s;
+    return;
+  }
+  const char *p = s;
+  for (; *p; p++) {
+    if (*p & 0x80) break;
+    out += (*p >= 'A' && *p <= 'Z') ? char(*p - 'A' + 'a') : *p;
+  }
+  if (*p) {     // not ASCII
+    int len = (int)strlen(p);
+    size_t start = out.size();
+    out.resize(start + 4 * len);
+    int l = fl_utf_tolower((const unsigned char *)p, len, &out[start]);
+    out.resize(start + l);
+  }
+}
+
+// Adds the next item
+void Fl_Filter_Index::add(void *item, const char *label) {
+  items_.push_back(item);
+  offsets_.push_back((int)text_.size());
+  fold(label ? label : "", text_);
+  text_ += '\0';
+  matched_.push_back(1);
+}
+
+/*
+  Finds the items whose label contains text. An empty or NULL text
+  matches all items. Stores the indices of the items whose matched()
+  state changed in 'changed', in increasing order. The first call after
+  building the index reports all items. Returns the number of matching
+  items.
+*/
+int Fl_Filter_Index::match(const char *text, std::vector<int> &changed) {
+  std::string t;
+  if (text) fold(text, t);
+  int n = size();
+  changed.clear();
+  const std::vector<int> *matches = 0;
+  if (t.empty()) {
+    steps_.clear();
+  } else {
+    // drop the texts that are not part of the new one:
+    while (!steps_.empty() && !strstr(t.c_str(), steps_.back().text.c_str()))
+      steps_.pop_back();
+    if (steps_.empty() || steps_.back().text != t) {
+      Step step;
+      step.text = t;
+      const char *s = text_.data();
+      if (steps_.empty()) {
+        for (int i = 0; i < n; i++)
+          if (strstr(s + offsets_[i], t.c_str())) step.matches.push_back(i);
+      } else {
+        const std::vector<int> &prev = steps_.back().matches;
+        for (size_t k = 0; k < prev.size(); k++)
+          if (strstr(s + offsets_[prev[k]], t.c_str())) step.matches.push_back(prev[k]);
+      }
+      steps_.push_back(step);
+    }
+    matches = &steps_.back().matches;
+  }
+  // compare with the state of the last call:
+  size_t k = 0;
+  for (int i = 0; i < n; i++) {
+    char m = 1;
+    if (matches) {
+      m = (k < matches->size() && (*matches)[k] == i);
+      if (m) k++;
+    }
+    if (m != matched_[i] || !applied_) changed.push_back(i);
+    matched_[i] = m;
+  }
+  applied_ = true;
+  return matches ? (int)matches->size() : n;
+}
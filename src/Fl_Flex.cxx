@@ -16,7 +16,10 @@
 //
 
 #include <FL/Fl_Flex.H>
+#include "Fl_Layout_Queue.H"
 #include <stdlib.h>       // malloc, free, ...
+#include <algorithm>
+#include <functional>
 
 /**
   Construct a new Fl_Flex widget with the given position, size, and label.
@@ -123,6 +126,7 @@ void Fl_Flex::init(int t) {
   fixed_size_alloc_ = 0;      // allocated size of array of fixed size widgets
   fixed_size_       = NULL;   // array of fixed size widgets
   need_layout_      = false;  // no need to calculate layout yet
+  in_layout_        = false;
 
   type(HORIZONTAL);
   if (t == VERTICAL)
@@ -130,10 +134,18 @@ void Fl_Flex::init(int t) {
 }
 
 Fl_Flex::~Fl_Flex() {
+  Fl_Layout_Queue::remove(this);
   if (fixed_size_)
     free(fixed_size_);
 }
 
+// Fl_Layout_Queue calls this before Fl::flush()
+static void layout_cb(Fl_Group *g) {
+  Fl_Flex *flex = (Fl_Flex *)g;
+  if (flex->need_layout())
+    flex->layout();
+}
+
 /*
  Fl_Group calls this method when a child widget is about to be removed.
  Make sure that the widget is also removed from our fixed list.
@@ -143,6 +155,53 @@ void Fl_Flex::on_remove(int index) {
   need_layout(1);
 }
 
+/*
+ Fl_Group::clear() calls this method before all children are deleted.
+ */
+void Fl_Flex::on_clear() {
+  fixed_size_size_ = 0;
+  need_layout(1);
+}
+
+/*
+ Fl_Widget::resize() calls this method when a child widget was resized.
+ The size of a fixed size child determines the layout of its siblings,
+ so if it was resized by other code than layout() the layout is needed again.
+ */
+void Fl_Flex::on_child_resize(Fl_Widget *child) {
+  if (!in_layout_ && fixed(child))
+    need_layout(1);
+}
+
+/**
+  Set or reset the request to calculate the layout of children.
+
+  This is intended for internal use but can also be used by user
+  code to request layout calculation before the widget is drawn.
+
+  Call this if you changed attributes or sizes of children to ensure
+  that the layout is calculated properly. Changing other Fl_Flex
+  attributes or changing the size of a fixed size child does this
+  automatically.
+
+  The layout is calculated before the next Fl::flush() or when the widget
+  is drawn, whatever comes first.
+
+  \note Never call this with '\c set == 0' because this would defeat its
+    purpose to recalculate the layout before the widget is drawn.
+*/
+void Fl_Flex::need_layout(int set) {
+  if (!set) {
+    need_layout_ = false;
+    return;
+  }
+  if (!need_layout_) {
+    need_layout_ = true;
+    Fl_Layout_Queue::add(this, layout_cb);
+  }
+  redraw();
+}
+
 /**
   Draw the widget.
 
@@ -162,14 +221,34 @@ void Fl_Flex::draw() {
 }
 
 /**
-  Resize the container and calculate all child positions and sizes.
+  Resize the container and request a new layout of all children.
+
+  If only the position changes and no layout is pending all children are
+  moved by the same distance, otherwise the layout is calculated.
 
   \param[in]  x,y   position
   \param[in]  w,h   width and height
+
+  \see need_layout(int)
 */
 void Fl_Flex::resize(int x, int y, int w, int h) {
+  int dx = x - this->x();
+  int dy = y - this->y();
+  bool same_size = (w == this->w() && h == this->h());
   Fl_Widget::resize(x, y, w, h);
-  layout();
+  if (!same_size || need_layout()) {
+    layout();
+    return;
+  }
+  if (!dx && !dy)
+    return;
+  in_layout_ = true;
+  for (int i = 0; i < children(); i++) {
+    Fl_Widget *c = child(i);
+    if (c->visible())
+      c->position(c->x() + dx, c->y() + dy);
+  }
+  in_layout_ = false;
 } // resize()
 
 
@@ -210,6 +289,8 @@ void Fl_Flex::layout() {
 
   int fw = nc;    // number of flexible widgets
 
+  in_layout_ = true;
+
   // Precalculate remaining space that can be distributed
 
   for (int i = 0; i < nc; i++) {
@@ -263,6 +344,7 @@ void Fl_Flex::layout() {
     }
   }
 
+  in_layout_ = false;
   need_layout(0); // layout done, no need to do it again when drawing
   redraw();
 }
@@ -302,14 +384,10 @@ void Fl_Flex::fixed(Fl_Widget *child, int size) {
   if (size <= 0)
     size = 0;
 
-  // find w in our fixed size list
-  int idx = -1;
-  for (int i = 0; i < fixed_size_size_; i++) {
-    if (fixed_size_[i] == child) {
-      idx = i;
-      break;
-    }
-  }
+  // find w in our fixed size list, which is sorted by address
+  Fl_Widget **end = fixed_size_ + fixed_size_size_;
+  Fl_Widget **pos = std::lower_bound(fixed_size_, end, child, std::less<Fl_Widget *>());
+  int idx = (pos != end && *pos == child) ? int(pos - fixed_size_) : -1;
 
   // remove from array, if we want the widget to be flexible, but an entry was found
   if (size == 0 && idx >= 0) {
@@ -327,11 +405,15 @@ void Fl_Flex::fixed(Fl_Widget *child, int size) {
 
   // if we have no entry yet, add to array of fixed size widgets
   if (idx == -1) {
+    idx = int(pos - fixed_size_);
     if (fixed_size_size_ == fixed_size_alloc_) {
       fixed_size_alloc_ = alloc_size(fixed_size_alloc_);
       fixed_size_ = (Fl_Widget **)realloc(fixed_size_, fixed_size_alloc_ * sizeof(Fl_Widget *));
     }
-    fixed_size_[fixed_size_size_] = child;
+    for (int i = fixed_size_size_; i > idx; i--) {
+      fixed_size_[i] = fixed_size_[i-1];
+    }
+    fixed_size_[idx] = child;
     fixed_size_size_++;
   }
 
@@ -352,12 +434,8 @@ void Fl_Flex::fixed(Fl_Widget *child, int size) {
   \retval     0  the widget resizes dynamically
 */
 int Fl_Flex::fixed(Fl_Widget *w) const {
-  for (int i = 0; i < fixed_size_size_; i++) {
-    if (w == fixed_size_[i]) {
-      return 1;
-    }
-  }
-  return 0;
+  Fl_Widget **end = fixed_size_ + fixed_size_size_;
+  return std::binary_search(fixed_size_, end, w, std::less<Fl_Widget *>()) ? 1 : 0;
 }
 
 /**
@@ -24,6 +24,7 @@
 
 #include <FL/Fl_Grid.H>
 #include <FL/fl_draw.H>
+#include "Fl_Layout_Queue.H"
 
 // private class Col for column management
 
@@ -47,57 +48,19 @@ class Fl_Grid::Col {
 class Fl_Grid::Row {
   friend class Fl_Grid;
 
-  Cell *cells_;         // cells of this row
   int minh_;            // minimal size (height)
   int h_;               // calculated size (height)
   short weight_;        // weight used to allocate extra space
   short gap_;           // gap below the row (-1 = use default)
 
   Row() {
-    cells_  = NULL;
     minh_   =  0;
     h_      =  0;
     weight_ = 50;
     gap_    = -1;
   }
 
-  ~Row() {
-    free_cells();
-  }
-
-  // Fl_Grid::Row::free_cells() - free all cells of a row
-
-  void free_cells() {
-    Cell *cel = cells_;
-    while (cel) {
-      Cell *next = cel->next();
-      delete cel;
-      cel = next;
-    } // free_cells()
-    cells_ = 0;
-  }
-
-  // Fl_Grid::Row::remove_cell() - remove all cells of column col from the list of cells
-
-  void remove_cell(int col) { //
-    Cell *cel = cells_;
-    Cell *prev = 0;
-    while (cel) {
-      Cell *next = cel->next();
-      if (cel->col() == col) {
-        if (prev) {
-          prev->next(next);
-        } else {
-          cells_ = next;
-        }
-        delete cel;
-        return;
-      } else {
-        prev = cel;
-        cel = next;
-      }
-    } // while (cel)
-  } // Row::remove_cell(col)
+  ~Row() {}
 
 }; // class Row
 
@@ -126,6 +89,8 @@ void Fl_Grid::init() {
   gap_col_ = 0;
   Cols_ = 0;
   Rows_ = 0;
+  Cells_ = 0;
+  Outside_ = 0;
   old_size = Fl_Rect(0, 0, 0, 0);
   need_layout_ = false;               // no need to calculate layout
   grid_color = (Fl_Color)0xbbeebb00;  // light green
@@ -135,10 +100,57 @@ void Fl_Grid::init() {
 }
 
 Fl_Grid::~Fl_Grid() {
+  Fl_Layout_Queue::remove(this);
+  free_cells();
   delete[] Cols_;
   delete[] Rows_;
 }
 
+// private: delete all cells
+
+void Fl_Grid::free_cells() {
+  for (int i = 0; i < rows_ * cols_; i++)
+    delete Cells_[i];
+  delete[] Cells_;
+  Cells_ = 0;
+  while (Outside_) {
+    Cell *next = Outside_->next_;
+    delete Outside_;
+    Outside_ = next;
+  }
+}
+
+// private: find a cell in the row after the last row or the column after
+// the last column; these cells are not part of the layout
+
+Fl_Grid::Cell *Fl_Grid::outside_cell(int row, int col) const {
+  for (Cell *c = Outside_; c; c = c->next_)
+    if (c->row_ == row && c->col_ == col)
+      return c;
+  return 0;
+}
+
+// private: link the cells of a row in the order of their columns
+
+void Fl_Grid::link_row(int row) {
+  Cell **cel = Cells_ + row * cols_;
+  Cell *next = 0;
+  for (int c = cols_ - 1; c >= 0; c--) {
+    if (cel[c]) {
+      cel[c]->next_ = next;
+      next = cel[c];
+    }
+  }
+}
+
+// Fl_Layout_Queue calls this before Fl::flush()
+
+static void layout_cb(Fl_Group *g) {
+  Fl_Grid *grid = (Fl_Grid *)g;
+  if (grid->need_layout())
+    grid->layout();
+}
+
 /**
   Set the basic layout parameters of the Fl_Grid widget.
 
@@ -192,9 +204,27 @@ void Fl_Grid::layout(int rows, int cols, int margin, int gap) {
     return;
   }
 
-  // allocate new cells, rows, and columns
+  // reallocate and copy old cells, delete the cells outside of the new layout
 
-  // Cell *new_cells = new Cell[rows * cols];
+  Cell **new_cells = new Cell*[rows * cols];
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < cols; c++) {
+      Cell *&cel = new_cells[r * cols + c];
+      cel = (r < rows_ && c < cols_) ? Cells_[r * cols_ + c] : 0;
+      if (cel) Cells_[r * cols_ + c] = 0;
+    }
+  }
+  // cells outside of the old layout become part of a larger layout
+  while (Outside_) {
+    Cell *cel = Outside_;
+    Outside_ = cel->next_;
+    if (cel->row_ < rows && cel->col_ < cols && !new_cells[cel->row_ * cols + cel->col_])
+      new_cells[cel->row_ * cols + cel->col_] = cel;
+    else
+      delete cel;
+  }
+  free_cells();
+  Cells_ = new_cells;
 
   // reallocate and copy old columns
 
@@ -218,7 +248,6 @@ void Fl_Grid::layout(int rows, int cols, int margin, int gap) {
     for (int r = 0; r < rows; r++, row++) {
       if (r < rows_) {
         new_rows[r] = *row;
-        row->cells_ = 0;
       } else {
         break;
       }
@@ -231,6 +260,8 @@ void Fl_Grid::layout(int rows, int cols, int margin, int gap) {
 
   cols_ = cols;
   rows_ = rows;
+  for (int r = 0; r < rows_; r++)
+    link_row(r);
   need_layout(1);
 
 } // layout(int, int, int, int)
@@ -319,8 +350,9 @@ void Fl_Grid::draw() {
 /**
   Calculate the grid layout and resize and position all widgets.
 
-  This is called automatically when the Fl_Grid is resized. You need to
-  call it once after you added widgets or moved widgets between cells.
+  This is called automatically before the next Fl::flush() when the Fl_Grid
+  was resized. You need to call it once after you added widgets or moved
+  widgets between cells.
 
   Calling it once after all modifications are completed is enough.
 
@@ -330,8 +362,10 @@ void Fl_Grid::draw() {
 */
 void Fl_Grid::layout() {
 
-  if (rows_ == 0 || cols_ == 0) // empty grid
+  if (rows_ == 0 || cols_ == 0) { // empty grid
+    need_layout(0);
     return;
+  }
 
   Row *row;
   Col *col;
@@ -356,11 +390,12 @@ void Fl_Grid::layout() {
 
   // calculate minimal column widths and row heights (in one loop)
 
+  Cell **cells = Cells_;
   row = Rows_;
   for (int r = 0; r < rows_; r++, row++) {
     col = Cols_;
     for (int c = 0; c < cols_; c++, col++) {
-      cel = cell(r, c);
+      cel = *cells++;
       if (cel) {
         Fl_Widget *wi = cel->widget_;
         if (wi && wi->visible()) {
@@ -450,6 +485,7 @@ void Fl_Grid::layout() {
 
   y0 = y() + Fl::box_dy(box()) + margin_top_;
 
+  cells = Cells_;
   row = Rows_;
   for (int r = 0; r < rows_; r++, row++) {
     x0 = x() + Fl::box_dx(box()) + margin_left_;
@@ -457,7 +493,7 @@ void Fl_Grid::layout() {
     for (int c = 0; c < cols_; c++, col++) {
       int wx = x0;  // widget's x
       int wy = y0;  // widget's y
-      cel = cell(r, c);
+      cel = *cells++;
       if (cel) {
         Fl_Widget *wi = cel->widget_;
         if (wi && wi->visible()) {
@@ -540,46 +576,71 @@ void Fl_Grid::on_remove(int index) {
   }
 }
 
-// private: add a new cell to the grid
+/**
+  Fl_Group calls this method when all children are about to be deleted.
 
-Fl_Grid::Cell *Fl_Grid::add_cell(int row, int col) {
-  Cell *c = new Cell(row, col);
-  Row *r = &Rows_[row];
-  Cell* cel = r->cells_;  // "current" cell
-  Cell* prev = 0;         // "previous" cell
-  while (cel) {           // existing cells
-    if (cel->col_ > col) { // found spot ...
-      break;
-    }
-    prev = cel;
-    cel = cel->next_;
+  Removes all cells but keeps the layout (rows and columns).
+*/
+void Fl_Grid::on_clear() {
+  for (int i = 0; i < rows_ * cols_; i++) {
+    delete Cells_[i];
+    Cells_[i] = 0;
   }
+  while (Outside_) {
+    Cell *next = Outside_->next_;
+    delete Outside_;
+    Outside_ = next;
+  }
+  need_layout(1);
+}
 
-  // insertion point: prev => last cell or NULL, cel == next cell or NULL
-
-  if (prev)
-    prev->next_ = c;
-  else
-    r->cells_ = c;
-  c->next_ = cel;
+// private: add a new cell to the grid
 
+Fl_Grid::Cell *Fl_Grid::add_cell(int row, int col) {
+  if (row >= rows_ || col >= cols_) {
+    remove_cell(row, col);
+    Cell *cel = new Cell(row, col);
+    cel->next_ = Outside_;
+    Outside_ = cel;
+    return cel;
+  }
+  Cell *&cel = Cells_[row * cols_ + col];
+  delete cel;
+  cel = new Cell(row, col);
+  link_row(row);
   need_layout(1);
-  return c;
+  return cel;
 }
 
 // private: remove a cell from the grid
 
 void Fl_Grid::remove_cell(int row, int col) {
-  Row *r = &Rows_[row];
-  r->remove_cell(col);
+  if (row < 0 || row > rows_ || col < 0 || col > cols_)
+    return;
+  if (row == rows_ || col == cols_) {
+    for (Cell **p = &Outside_; *p; p = &(*p)->next_) {
+      if ((*p)->row_ == row && (*p)->col_ == col) {
+        Cell *cel = *p;
+        *p = cel->next_;
+        delete cel;
+        return;
+      }
+    }
+    return;
+  }
+  Cell *&cel = Cells_[row * cols_ + col];
+  delete cel;
+  cel = 0;
+  link_row(row);
   need_layout(1);
 }
 
 /**
-  Recalculate the layout and position and resize all widgets.
+  Resize the grid and request a new layout of all widgets.
 
-  This method overrides Fl_Group::resize() and calculates all positions and
-  sizes of its children according to its own rules.
+  This method overrides Fl_Group::resize(). If only the position changes
+  and no layout is pending all widgets are moved by the same distance,
+  otherwise the layout is calculated.
 
   \param[in]  X,Y   new widget position
   \param[in]  W,H   new widget size
@@ -587,7 +648,41 @@ void Fl_Grid::remove_cell(int row, int col) {
 void Fl_Grid::resize(int X, int Y, int W, int H) {
   old_size = Fl_Rect(x(), y(), w(), h());
   Fl_Widget::resize(X, Y, W, H);
-  layout();
+  if (W != old_size.w() || H != old_size.h() || need_layout()) {
+    layout();
+    return;
+  }
+  int dx = X - old_size.x();
+  int dy = Y - old_size.y();
+  if (!dx && !dy)
+    return;
+  for (int i = 0; i < rows_ * cols_; i++) {
+    Fl_Widget *wi = Cells_[i] ? Cells_[i]->widget_ : 0;
+    if (wi && wi->visible())
+      wi->position(wi->x() + dx, wi->y() + dy);
+  }
+}
+
+/**
+  Request or reset the request to calculate the layout of children.
+
+  If called with \p true (1) this calls redraw() to schedule a
+  full draw(). The layout is (re)calculated before the next
+  Fl::flush() or when the widget is drawn, whatever comes first.
+
+  \param[in]  set   1 to request layout calculation,\n
+                    0 to reset the request
+*/
+void Fl_Grid::need_layout(int set) {
+  if (!set) {
+    need_layout_ = false;
+    return;
+  }
+  if (!need_layout_) {
+    need_layout_ = true;
+    Fl_Layout_Queue::add(this, layout_cb);
+  }
+  redraw();
 }
 
 /**
@@ -606,6 +701,7 @@ void Fl_Grid::resize(int X, int Y, int W, int H) {
 */
 void Fl_Grid::clear_layout() {
 
+  free_cells();
   delete[] Cols_;
   delete[] Rows_;
   init();
@@ -737,16 +833,7 @@ void Fl_Grid::gap(int *row_gap, int *col_gap) const {
 Fl_Grid::Cell* Fl_Grid::cell(int row, int col) const {
   if (row < 0 || row >= rows_ || col < 0 || col >= cols_)
     return 0;
-  Row *r = &Rows_[row];
-  Cell *cel = r->cells_;
-  while (cel) {
-    if (cel->col_ > col)
-      return 0;
-    if (cel->col_ == col)
-      return cel;
-    cel = cel->next_;
-  }
-  return 0;
+  return Cells_[row * cols_ + col];
 }
 
 /**
@@ -765,14 +852,13 @@ Fl_Grid::Cell* Fl_Grid::cell(int row, int col) const {
   \retval     NULL    if \p widget is not assigned to a cell
 */
 Fl_Grid::Cell* Fl_Grid::cell(Fl_Widget *widget) const {
-  Row *row = Rows_;
-  for (int r = 0; r < rows_; r++, row++) {
-    Cell *cel = row->cells_;
-    while (cel) {
-      if (cel->widget_ == widget)
-        return cel;
-      cel = cel->next_;
-    }
+  for (int i = 0; i < rows_ * cols_; i++) {
+    if (Cells_[i] && Cells_[i]->widget_ == widget)
+      return Cells_[i];
+  }
+  for (Cell *c = Outside_; c; c = c->next_) {
+    if (c->widget_ == widget)
+      return c;
   }
   return 0;
 }
@@ -814,6 +900,9 @@ Fl_Grid::Cell *Fl_Grid::widget(Fl_Widget *wi, int row, int col, Fl_Grid_Align al
   Before you can assign a widget to a cell it must have been created as
   a child of the Fl_Grid widget (i.e. its Fl_Group).
 
+  \p row == rows() and \p col == cols() are accepted: the widget is not
+  positioned until the layout is enlarged to contain its cell.
+
   \param[in]  wi        widget to be assigned to the cell
   \param[in]  row       row
   \param[in]  col       column
@@ -836,7 +925,7 @@ Fl_Grid::Cell *Fl_Grid::widget(Fl_Widget *wi, int row, int col, int rowspan, int
   if (col < 0 || col > cols_)
     return 0;
 
-  Cell *c = cell(row, col);
+  Cell *c = (row < rows_ && col < cols_) ? cell(row, col) : outside_cell(row, col);
   if (!c) {
     c = add_cell(row, col);
   }
@@ -1180,10 +1269,10 @@ void Fl_Grid::debug(int level) {
   for (int r = 0; r < rows_; r++, row++) {
     fprintf(stderr, "Row %2d: minh = %d, weight = %d, gap = %d, h = %d\n",
             r, row->minh_, row->weight_, row->gap_, row->h_);
-    Cell *cel = row->cells_;
-    while (cel) {
-      fprintf(stderr, "        Cell(%2d, %2d)\n", cel->row_, cel->col_);
-      cel = cel->next_;
+    for (int c = 0; c < cols_; c++) {
+      Cell *cel = Cells_[r * cols_ + c];
+      if (cel)
+        fprintf(stderr, "        Cell(%2d, %2d)\n", cel->row_, cel->col_);
     }
   }
   fflush(stderr); // necessary for Windows
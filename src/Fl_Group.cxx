@@ -22,6 +22,8 @@
 
 #include <FL/Fl_Group.H>
 #include "Fl_Window_Driver.H"
+#include "Fl_Group_Index.H"
+#include "Fl_Retained_Cache.H"
 #include <FL/Fl_Rect.H>
 #include <FL/fl_draw.H>
 
@@ -42,17 +44,108 @@ Fl_Widget*const* Fl_Group::array() const {
   return child_.data();
 }
 
+/*
+  Every child stores an index hint, so find() doesn't need to search the
+  children. Adding or removing the last child doesn't change any other
+  index. Inserting or removing a child elsewhere changes the index of all
+  following children: if there are only a few, their hints are updated
+  immediately. Otherwise removing a child is recorded as a shift of the
+  hints of all children from that index on, which covers removing many
+  children in order, from the start or the end of a range. All other
+  changes make the hints stale. find() verifies the hint and, if it is
+  wrong, searches outwards from it because a stale hint is usually off by
+  only a few places. All children are numbered again when these searches
+  cost about as much as that, because numbering touches every child
+  widget while the search only reads the array of children.
+*/
+
+enum {
+  HINT_UPDATE_MAX = 16,   // max. number of hints updated immediately
+  HINT_RENUMBER_COST = 8  // renumbering costs about as much as this many searches
+};
+
+// Returns the expected index of a child with the given hint
+int Fl_Group::hint_to_index(int hint) const {
+  return hint >= hint_split_ - hint_shift_ ? hint + hint_shift_ : hint;
+}
+
+// Sets the hint of the child at index
+void Fl_Group::set_hint(int index) const {
+  child_[index]->index_hint_ = index >= hint_split_ ? index - hint_shift_ : index;
+}
+
+void Fl_Group::renumber_hints() const {
+  for (int i = 0; i < children(); i++)
+    child_[i]->index_hint_ = i;
+  hint_split_ = hint_shift_ = hint_cost_ = 0;
+  hints_stale_ = false;
+}
+
+// A child was inserted at index
+void Fl_Group::hints_inserted(int index) {
+  int n = children();
+  if (index == n - 1 || (!hints_stale_ && n - index <= HINT_UPDATE_MAX)) {
+    for (int i = index; i < n; i++)
+      set_hint(i);
+  } else {
+    hints_stale_ = true;
+  }
+}
+
+// The child at index was removed
+void Fl_Group::hints_removed(int index) {
+  int n = children();
+  if (index == n || hints_stale_)
+    return;
+  if (hint_shift_ == 0 || index == hint_split_ || index == hint_split_ - 1) {
+    hint_split_ = index;
+    hint_shift_--;
+  } else if (n - index <= HINT_UPDATE_MAX) {
+    for (int i = index; i < n; i++)
+      set_hint(i);
+  } else {
+    hints_stale_ = true;
+  }
+}
+
 /**
   Searches the children for the widget and returns the index.
 
   Returns children() if the widget is NULL or not found.
+
+  This takes constant time for a child of the group in most cases.
 */
 int Fl_Group::find(const Fl_Widget* o) const {
-  Fl_Widget*const* a = array();
-  int i;
-  for (i = 0; i < children(); i++) {
-    if (*a++ == o) break;
+  int n = children();
+  if (!o || o->parent_ != this || n == 0) {
+    // not a child (or a widget that is being added): plain search
+    int i;
+    for (i = 0; i < n; i++)
+      if (child_[i] == o) break;
+    return i;
   }
+  int i = hint_to_index(o->index_hint_);
+  if (i < 0) i = 0;
+  else if (i >= n) i = n - 1;
+  if (!hints_stale_ && child_[i] == o)
+    return i;
+  // a stale hint is usually close, search outwards from it
+  int lo = i, hi = i + 1, steps = 0;
+  for (;;) {
+    if (lo >= 0) {
+      if (child_[lo] == o) { i = lo; break; }
+      lo--;
+    }
+    if (hi < n) {
+      if (child_[hi] == o) { i = hi; break; }
+      hi++;
+    }
+    if (lo < 0 && hi >= n) { i = n; break; } // parent_ out of sync
+    steps++;
+  }
+  hint_cost_ += steps + 1;
+  if (hint_cost_ > HINT_RENUMBER_COST * n)
+    renumber_hints();
   return i;
 }
 
@@ -145,12 +238,43 @@ static int navkey() {
   return 0;
 }
 
+// Returns child k of the children found by the spatial index, or child k
+// of the group if there is no index. Returns NULL if the child was removed
+// in the meantime.
+static Fl_Widget *found_child(const Fl_Group *g, const std::vector<int> &found, int k) {
+  int i = found.empty() ? k : found[k];
+  return i < g->children() ? g->child(i) : 0;
+}
+
 int Fl_Group::handle(int event) {
 
   Fl_Widget*const* a = array();
   int i;
   Fl_Widget* o;
 
+  // with a spatial index, only the children below the mouse are tried
+  // for mouse events, see spatial_index(int)
+  std::vector<int> found;
+  int nfound = children();
+  if (spatial_index_) {
+    switch (event) {
+    case FL_RELEASE:
+    case FL_DRAG:
+      if (Fl::pushed()) break;
+      /* FALLTHROUGH */
+    case FL_SHORTCUT:
+    case FL_ENTER:
+    case FL_MOVE:
+    case FL_DND_ENTER:
+    case FL_DND_DRAG:
+    case FL_PUSH:
+    case FL_MOUSEWHEEL:
+      spatial_index_->find(Fl::e_x, Fl::e_y, 1, 1, found);
+      nfound = (int)found.size();
+      break;
+    }
+  }
+
   switch (event) {
 
   case FL_FOCUS:
@@ -176,9 +300,9 @@ int Fl_Group::handle(int event) {
     return navigation(navkey());
 
   case FL_SHORTCUT:
-    for (i = children(); i--;) {
-      o = a[i];
-      if (o->takesevents() && Fl::event_inside(o) && send(o,FL_SHORTCUT))
+    for (i = nfound; i--;) {
+      o = found_child(this, found, i);
+      if (o && o->takesevents() && Fl::event_inside(o) && send(o,FL_SHORTCUT))
         return 1;
     }
     for (i = children(); i--;) {
@@ -191,9 +315,9 @@ int Fl_Group::handle(int event) {
 
   case FL_ENTER:
   case FL_MOVE:
-    for (i = children(); i--;) {
-      o = a[i];
-      if (o->visible() && Fl::event_inside(o)) {
+    for (i = nfound; i--;) {
+      o = found_child(this, found, i);
+      if (o && o->visible() && Fl::event_inside(o)) {
         if (o->contains(Fl::belowmouse())) {
           return send(o,FL_MOVE);
         } else {
@@ -207,9 +331,9 @@ int Fl_Group::handle(int event) {
 
   case FL_DND_ENTER:
   case FL_DND_DRAG:
-    for (i = children(); i--;) {
-      o = a[i];
-      if (o->takesevents() && Fl::event_inside(o)) {
+    for (i = nfound; i--;) {
+      o = found_child(this, found, i);
+      if (o && o->takesevents() && Fl::event_inside(o)) {
         if (o->contains(Fl::belowmouse())) {
           return send(o,FL_DND_DRAG);
         } else if (send(o,FL_DND_ENTER)) {
@@ -222,9 +346,9 @@ int Fl_Group::handle(int event) {
     return 0;
 
   case FL_PUSH:
-    for (i = children(); i--;) {
-      o = a[i];
-      if (o->takesevents() && Fl::event_inside(o)) {
+    for (i = nfound; i--;) {
+      o = found_child(this, found, i);
+      if (o && o->takesevents() && Fl::event_inside(o)) {
         Fl_Widget_Tracker wp(o);
         if (send(o,FL_PUSH)) {
           if (Fl::pushed() && wp.exists() && !o->contains(Fl::pushed())) Fl::pushed(o);
@@ -240,9 +364,9 @@ int Fl_Group::handle(int event) {
     if (o == this) return 0;
     else if (o) send(o,event);
     else {
-      for (i = children(); i--;) {
-        o = a[i];
-        if (o->takesevents() && Fl::event_inside(o)) {
+      for (i = nfound; i--;) {
+        o = found_child(this, found, i);
+        if (o && o->takesevents() && Fl::event_inside(o)) {
           if (send(o,event)) return 1;
         }
       }
@@ -250,9 +374,9 @@ int Fl_Group::handle(int event) {
     return 0;
 
   case FL_MOUSEWHEEL:
-    for (i = children(); i--;) {
-      o = a[i];
-      if (o->takesevents() && Fl::event_inside(o) && send(o,FL_MOUSEWHEEL))
+    for (i = nfound; i--;) {
+      o = found_child(this, found, i);
+      if (o && o->takesevents() && Fl::event_inside(o) && send(o,FL_MOUSEWHEEL))
         return 1;
     }
     for (i = children(); i--;) {
@@ -358,6 +482,10 @@ Fl_Group::Fl_Group(int X, int Y, int W, int H, const char *L)
   resizable_ = this;
   bounds_ = 0; // this is allocated when first resize() is done
   sizes_ = 0;  // see bounds_ (FLTK 1.3 compatibility)
+  spatial_index_ = 0;
+  hint_split_ = hint_shift_ = hint_cost_ = 0;
+  hints_stale_ = false;
+  clearing_ = false;
 
   // Subclasses may want to construct child objects as part of their
   // constructor, so make sure they are add()'d to this object.
@@ -373,6 +501,10 @@ Fl_Group::Fl_Group(int X, int Y, int W, int H, const char *L)
 
   The resizable() widget of the Fl_Group is set to the Fl_Group itself.
 
+  The children are deleted with delete_child(), starting with the last
+  child. Derived groups are notified once by on_clear() before, and
+  on_remove() is not called for the single children.
+
   \internal If the Fl_Group widget contains the Fl::focus() or the
   Fl::pushed() widget these are set to sensible values (other widgets
   or the Fl_Group widget itself).
@@ -408,12 +540,20 @@ void Fl_Group::clear() {
   // removed and deleted in the order from last child to first
   // child which is much faster than the other way around and
   // should be the "natural order" (last in, first out).
+  // Subclasses are notified once by on_clear() instead of calling
+  // on_remove() for every child. Removing the last child is O(1), and
+  // delete_child() may still refuse to delete a child.
 
+  on_clear();
+  clearing_ = true;
   for (int i = children() - 1; i >= 0; i--) {
     // some children may have been deleted, so check always
     if (i >= children()) continue;
     delete_child(i);
   }
+  clearing_ = false;
+  renumber_hints();
+  init_sizes();
 
   if (pushed != this)
     Fl::pushed(pushed);       // reset pushed() widget
@@ -437,6 +577,7 @@ Fl_Group::~Fl_Group() {
   if (current_ == this)
     end();
   clear();
+  delete spatial_index_;
 }
 
 /**
@@ -499,17 +640,45 @@ int Fl_Group::on_move(int oldIndex, int newIndex) {
   the widgets inside a group.
 */
 void Fl_Group::insert(Fl_Widget &o, int index) {
+  if (insert_(o, index))
+    init_sizes();
+}
+
+/**
+  Adds many widgets to the end of the group at once.
+
+  This is the same as calling add() for each widget but faster, because
+  the group allocates memory for all widgets only once and resets the
+  sizes of its children only once.
+
+  \param[in]  widgets   array of widgets
+  \param[in]  count     number of widgets in the array
+
+  \see add(Fl_Widget&)
+  \since 1.5.0
+*/
+void Fl_Group::add_children(Fl_Widget *const *widgets, int count) {
+  if (count <= 0)
+    return;
+  child_.reserve(child_.size() + count);
+  for (int i = 0; i < count; i++)
+    insert_(*widgets[i], children());
+  init_sizes();
+}
+
+// Implements insert(), returns 0 if nothing was changed
+int Fl_Group::insert_(Fl_Widget &o, int index) {
   if (o.parent()) {
     Fl_Group* g = o.parent();
     int n = g->find(o);
     if (g == this) {
       // avoid expensive remove() and add() if we just move a widget within the group
       index = on_move(n, index);
-      if (index < 0) return;      // don't move: requested by subclass
+      if (index < 0) return 0;    // don't move: requested by subclass
       if (index > children())
         index = children();
       if (index > n) index--;     // compensate for removal and re-insertion
-      if (index == n) return;     // same position; this includes (children() == 1)
+      if (index == n) return 0;   // same position; this includes (children() == 1)
 
       // now it's OK to move the child inside this group
 
@@ -521,21 +690,29 @@ void Fl_Group::insert(Fl_Widget &o, int index) {
           child_[j] = child_[j - 1];
       }
       child_[index] = &o;
-      init_sizes();
-      return;
+      int lo = index < n ? index : n, hi = index < n ? n : index;
+      if (!hints_stale_ && hi - lo < HINT_UPDATE_MAX) {
+        for (int i = lo; i <= hi; i++)
+          set_hint(i);
+      } else {
+        hints_stale_ = true;
+      }
+      return 1;
     }
     g->remove(n);
   }
 
   index = on_insert(&o, index);
-  if (index == -1) return;
+  if (index == -1) return 0;
   if (index >= children()) {              // append
+    index = children();
     child_.push_back(&o);
   } else {                                // insert
     child_.insert(child_.begin() + index, &o);
   }
   o.parent_ = this;
-  init_sizes();
+  hints_inserted(index);
+  return 1;
 }
 
 /**
@@ -559,6 +736,48 @@ void Fl_Group::on_remove(int index) {
   (void)index;
 }
 
+/**
+ Allow derived groups to act when all children are about to be deleted.
+
+ clear() calls this method once before it deletes all children, instead
+ of calling on_remove() for every child. Widgets derived from Fl_Group
+ that store additional data for their children can release these data
+ at once.
+
+ The default implementation calls on_remove() for every child, starting
+ with the last child, so derived groups that only override on_remove()
+ keep working.
+
+ \note Some FLTK groups override this method without calling on_remove().
+    If you derive a class from one of them and override on_remove(),
+    override on_clear() as well.
+
+ \since 1.5.0
+ */
+void Fl_Group::on_clear() {
+  for (int i = children() - 1; i >= 0; i--)
+    on_remove(i);
+}
+
+/**
+ Allow derived groups to act when a child widget was resized or moved.
+
+ Fl_Widget::resize() calls this method of the parent group after it
+ changed the position and size of the widget. Widgets derived from
+ Fl_Group may store data that depend on the positions of their children
+ and can update these data when a child is moved by other code.
+
+ \note Widgets that override resize() must call the resize() method of
+    their base class for this to work, as usual.
+
+ \param widget the child that was resized
+
+ \since 1.5.0
+ */
+void Fl_Group::on_child_resize(Fl_Widget *widget) {
+  (void)widget;
+}
+
 /**
   Removes the widget at \p index from the group but does not delete it.
 
@@ -572,7 +791,8 @@ void Fl_Group::on_remove(int index) {
 void Fl_Group::remove(int index) {
   if (index < 0 || index >= children())
     return;
-  on_remove(index);         // notify subclass
+  if (!clearing_)
+    on_remove(index);       // notify subclass
   if (index >= children())  // do nothing if the subclass removed it (?)
     return;
 
@@ -588,6 +808,7 @@ void Fl_Group::remove(int index) {
   } else {
     child_.erase(child_.begin() + index); // remove the widget from the group
   }
+  hints_removed(index);
   init_sizes();
 }
 
@@ -622,6 +843,9 @@ void Fl_Group::remove(Fl_Widget &o) {
 
   Many subclasses don't need to reimplement this method.
 
+  clear() calls this method for every child, but on_remove() is not
+  called in this case because clear() called on_clear() before.
+
   \note This method \b may refuse to remove and delete the widget
     if it is an essential part of the Fl_Group, for instance
     a scrollbar in an Fl_Scroll group. In this case the widget is
@@ -679,6 +903,46 @@ void Fl_Group::init_sizes() {
   bounds_ = 0;
   delete[] sizes_;      // FLTK 1.3 compatibility
   sizes_ = 0;           // FLTK 1.3 compatibility
+  if (spatial_index_) spatial_index_->invalidate();
+}
+
+/**
+  Turns the spatial index of the children on or off.
+
+  Normally the group looks at all of its children to find the child
+  below the mouse in handle() and to find the children that need to be
+  drawn in draw_children(). This is fine for typical groups, but it
+  becomes slow for "canvas" style groups with thousands of children,
+  of which only a few are visible or under the mouse at a time, for
+  instance the nodes of a node editor inside an Fl_Scroll.
+
+  With the spatial index the group sorts its children into a grid of
+  cells and only looks at the children in the cells that intersect the
+  mouse position or the current clip region. The index is built when it
+  is needed after children have been added, removed or reordered and
+  after the group was resized, moving a single child with resize() or
+  position() only updates the cells of that child.
+
+  Subwindows and children that draw their label outside of the widget
+  are always drawn and tried by handle() like without the index.
+  The index uses the align() of the children when it is built. If you
+  change the position of a child without calling resize() or change its
+  label alignment afterwards, call init_sizes().
+
+  The default is off. The index needs memory for about one cell per
+  child and is only useful if the group has many children.
+
+  \param[in] on  1 to use a spatial index, 0 to look at all children
+
+  \since 1.5.0
+*/
+void Fl_Group::spatial_index(int on) {
+  if (on && !spatial_index_) {
+    spatial_index_ = new Fl_Group_Index(this);
+  } else if (!on && spatial_index_) {
+    delete spatial_index_;
+    spatial_index_ = 0;
+  }
 }
 
 /**
@@ -815,6 +1079,8 @@ void Fl_Group::resize(int X, int Y, int W, int H) {
 
   Fl_Rect* p = bounds(); // save initial sizes and positions
 
+  if (spatial_index_) spatial_index_->invalidate(); // all children may move
+
   Fl_Widget::resize(X, Y, W, H); // make new xywh values visible for children
 
   // Part 1: no resizable() or both width and height didn't change,
@@ -902,8 +1168,6 @@ void Fl_Group::resize(int X, int Y, int W, int H) {
   after drawing the box, border, or background.
 */
 void Fl_Group::draw_children() {
-  Fl_Widget*const* a = array();
-
   if (clip_children()) {
     fl_push_clip(x() + Fl::box_dx(box()),
                  y() + Fl::box_dy(box()),
@@ -911,15 +1175,27 @@ void Fl_Group::draw_children() {
                  h() - Fl::box_dh(box()));
   }
 
+  // with a spatial index, only the children that intersect the clip
+  // region are drawn, see spatial_index(int)
+  std::vector<int> found;
+  int nfound = children();
+  if (spatial_index_) {
+    spatial_index_->find_clipped(found);
+    nfound = (int)found.size();
+  }
+
   if (damage() & ~FL_DAMAGE_CHILD) { // redraw the entire thing:
-    for (int i = children(); i--;) {
-      Fl_Widget& o = **a++;
-      draw_child(o);
-      draw_outside_label(o);
+    for (int i = 0; i < nfound; i++) {
+      Fl_Widget* o = found_child(this, found, i);
+      if (!o) continue;
+      draw_child(*o);
+      draw_outside_label(*o);
     }
   } else {      // only redraw the children that need it:
-    for (int i = children(); i--;)
-      update_child(**a++);
+    for (int i = 0; i < nfound; i++) {
+      Fl_Widget* o = found_child(this, found, i);
+      if (o) update_child(*o);
+    }
   }
 
   if (clip_children()) fl_pop_clip();
@@ -944,7 +1220,8 @@ void Fl_Group::draw() {
 void Fl_Group::update_child(Fl_Widget& widget) const {
   if (widget.damage() && widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
-    widget.draw();
+    if (!widget.retained() || !Fl_Retained_Cache::draw(widget))
+      widget.draw();
     widget.clear_damage();
   }
 }
@@ -954,10 +1231,17 @@ void Fl_Group::update_child(Fl_Widget& widget) const {
 
   This draws a child widget, if it is not clipped.
   The damage bits are cleared after drawing.
+
+  A widget with the retained() flag is copied from its cache unless it
+  is damaged itself.
 */
 void Fl_Group::draw_child(Fl_Widget& widget) const {
   if (widget.visible() && widget.type() < FL_WINDOW &&
       fl_not_clipped(widget.x(), widget.y(), widget.w(), widget.h())) {
+    if (widget.retained() && Fl_Retained_Cache::draw(widget)) {
+      widget.clear_damage();
+      return;
+    }
     // The following call clears all damage flags and then *sets* FL_DAMAGE_ALL
     widget.clear_damage(FL_DAMAGE_ALL);
     widget.draw();
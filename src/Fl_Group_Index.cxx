@@ -0,0 +1,190 @@
+//
+// Spatial index of the children of Fl_Group for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Group_Index.H"
+#include <FL/Fl_Group.H>
+#include <FL/fl_draw.H>
+
+#include <algorithm>
+#include <math.h>
+
+static int clamp(int v, int max) {
+  return v < 0 ? 0 : (v > max ? max : v);
+}
+
+// Returns true if the child draws its label outside of its area
+static bool outside_label(const Fl_Widget *o) {
+  if (!(o->align() & 15) || (o->align() & FL_ALIGN_INSIDE)) return false;
+  return (o->label() && *o->label()) || o->image() || o->deimage();
+}
+
+Fl_Group_Index::Fl_Group_Index(Fl_Group *g)
+  : group_(g), valid_(false), gx_(0), gy_(0), cw_(MIN_CELL), ch_(MIN_CELL),
+    cols_(1), rows_(1), bx_(0), by_(0), br_(0), bb_(0), mark_(0) {
+}
+
+// Children were added, removed or moved, the index is built again when
+// it is used next time
+void Fl_Group_Index::invalidate() {
+  valid_ = false;
+}
+
+// Returns the position of child o in the index
+void Fl_Group_Index::position(const Fl_Widget *o, int &X, int &Y) const {
+  X = o->x();
+  Y = o->y();
+}
+
+void Fl_Group_Index::grow_bounds(const Fl_Widget *o) {
+  int X, Y;
+  position(o, X, Y);
+  if (X < bx_) bx_ = X;
+  if (Y < by_) by_ = Y;
+  if (X + o->w() > br_) br_ = X + o->w();
+  if (Y + o->h() > bb_) bb_ = Y + o->h();
+}
+
+void Fl_Group_Index::build() {
+  int n = group_->children();
+  entries_.assign(n, Entry());
+  numbers_.clear();
+  numbers_.reserve(n);
+  marks_.assign(n, 0);
+  mark_ = 0;
+  always_.clear();
+  if (n) {
+    position(group_->child(0), bx_, by_);
+    br_ = bx_;
+    bb_ = by_;
+    for (int i = 0; i < n; i++)
+      grow_bounds(group_->child(i));
+  } else {
+    bx_ = by_ = br_ = bb_ = 0;
+  }
+  // about one cell per child
+  int W = br_ - bx_ + 1, H = bb_ - by_ + 1;
+  int size = n ? (int)sqrt((double)W * H / n) : MIN_CELL;
+  if (size < MIN_CELL) size = MIN_CELL;
+  gx_ = bx_;
+  gy_ = by_;
+  cols_ = std::min(W / size + 1, (int)MAX_GRID);
+  rows_ = std::min(H / size + 1, (int)MAX_GRID);
+  cw_ = (W + cols_ - 1) / cols_;
+  ch_ = (H + rows_ - 1) / rows_;
+  cells_.assign((size_t)cols_ * rows_, std::vector<int>());
+  valid_ = true;
+  for (int i = 0; i < n; i++)
+    insert(i);
+}
+
+// Stores child n in the cells it overlaps, or in always_
+void Fl_Group_Index::insert(int n) {
+  const Fl_Widget *o = group_->child(n);
+  numbers_[o] = n;
+  int X, Y;
+  position(o, X, Y);
+  Entry &e = entries_[n];
+  e.c0 = clamp((X - gx_) / cw_, cols_ - 1);
+  e.r0 = clamp((Y - gy_) / ch_, rows_ - 1);
+  e.c1 = clamp((X + std::max(o->w(), 1) - 1 - gx_) / cw_, cols_ - 1);
+  e.r1 = clamp((Y + std::max(o->h(), 1) - 1 - gy_) / ch_, rows_ - 1);
+  if (o->as_window() || outside_label(o) ||
+      (e.c1 - e.c0 + 1) * (e.r1 - e.r0 + 1) > MAX_SPAN) {
+    e.c0 = -1;
+    always_.push_back(n);
+    return;
+  }
+  for (int r = e.r0; r <= e.r1; r++)
+    for (int c = e.c0; c <= e.c1; c++)
+      cells_[(size_t)r * cols_ + c].push_back(n);
+}
+
+// Removes child n from its cells
+void Fl_Group_Index::erase(int n) {
+  const Entry &e = entries_[n];
+  if (e.c0 < 0) {
+    always_.erase(std::find(always_.begin(), always_.end(), n));
+    return;
+  }
+  for (int r = e.r0; r <= e.r1; r++) {
+    for (int c = e.c0; c <= e.c1; c++) {
+      std::vector<int> &cell = cells_[(size_t)r * cols_ + c];
+      *std::find(cell.begin(), cell.end(), n) = cell.back();
+      cell.pop_back();
+    }
+  }
+}
+
+// Child o was resized
+void Fl_Group_Index::moved(const Fl_Widget *o) {
+  if (!valid_) return;
+  std::unordered_map<const Fl_Widget*, int>::const_iterator it = numbers_.find(o);
+  if (it == numbers_.end()) return;
+  grow_bounds(o);
+  erase(it->second);
+  insert(it->second);
+}
+
+/*
+  Finds the children that may intersect the rectangle X, Y, W, H.
+  Returns their numbers in increasing order in result.
+*/
+void Fl_Group_Index::find(int X, int Y, int W, int H, std::vector<int> &result) {
+  if (!valid_) build();
+  result.clear();
+  if (W > 0 && H > 0) {
+    if (++mark_ == 0) {
+      marks_.assign(marks_.size(), 0);
+      mark_ = 1;
+    }
+    int c0 = clamp((X - gx_) / cw_, cols_ - 1);
+    int r0 = clamp((Y - gy_) / ch_, rows_ - 1);
+    int c1 = clamp((X + W - 1 - gx_) / cw_, cols_ - 1);
+    int r1 = clamp((Y + H - 1 - gy_) / ch_, rows_ - 1);
+    for (int r = r0; r <= r1; r++) {
+      for (int c = c0; c <= c1; c++) {
+        const std::vector<int> &cell = cells_[(size_t)r * cols_ + c];
+        for (size_t i = 0; i < cell.size(); i++) {
+          int n = cell[i];
+          if (marks_[n] == mark_) continue;
+          marks_[n] = mark_;
+          const Fl_Widget *o = group_->child(n);
+          int ox, oy;
+          position(o, ox, oy);
+          if (ox < X + W && ox + std::max(o->w(), 1) > X &&
+              oy < Y + H && oy + std::max(o->h(), 1) > Y)
+            result.push_back(n);
+        }
+      }
+    }
+  }
+  result.insert(result.end(), always_.begin(), always_.end());
+  std::sort(result.begin(), result.end());
+}
+
+/*
+  Finds the children that may intersect the current clip region.
+  The margin of one pixel covers rounding of scaled clip regions.
+*/
+void Fl_Group_Index::find_clipped(std::vector<int> &result) {
+  if (!valid_) build();
+  int X, Y, W, H;
+  fl_clip_box(bx_, by_, br_ - bx_ + 1, bb_ - by_ + 1, X, Y, W, H);
+  if (W > 0 && H > 0)
+    find(X - 1, Y - 1, W + 2, H + 2, result);
+  else
+    find(0, 0, 0, 0, result);
+}
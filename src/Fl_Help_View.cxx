@@ -44,6 +44,8 @@
 #include <ctype.h>
 #include <errno.h>
 #include <math.h>
+#include <limits.h>
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <string>
@@ -67,6 +69,7 @@
 //
 
 static constexpr int MAX_COLUMNS = 200;
+static constexpr int MAX_LAYOUTS = 2;   // formatted documents kept for other widths
 
 //
 // Implementation class
@@ -108,6 +111,10 @@ public:
     selection_last_ = 0;
 
     scrollbar_size_ = 0;
+
+    layout_width_ = -1;
+    layout_color_ = 0;
+    layout_defcolor_ = 0;
   }
   ~Impl()
   {
@@ -163,6 +170,21 @@ public:
     Fl_Rect       box;                  // Clickable rectangle that defines the link area
   };
 
+  /** Private struct to keep the formatted document for another width.
+     Switching between a few widths (e.g. maximizing and restoring the window)
+     then doesn't need to format the document again. */
+  struct Layout {
+    int           width;                // Text width the document was formatted for
+    Fl_Color      color;                // Widget color at that time
+    Fl_Color      defcolor;             // Default text color at that time
+    int           size, hsize;          // Document height and width
+    Fl_Color      bgcolor, textcolor, linkcolor;
+    std::string   title;
+    std::vector<Text_Block> blocks;
+    std::vector<std::shared_ptr<Link> > links;
+    std::map<std::string, int> targets;
+  };
+
   /** Private font stack element definition. */
   struct Font_Style {
     Fl_Font       f;                    ///< Font
@@ -203,6 +225,12 @@ public:
   std::vector<Text_Block> blocks_;      ///< List of all text blocks on screen
   std::vector<std::shared_ptr<Link> > link_list_; ///< List of all clickable links and their position on screen
   std::map<std::string, int> target_line_map_;    ///< List of vertical position of all HTML Targets in a document
+  std::vector<int> block_bottom_;       ///< Maximum bottom of blocks_[0..i], to find the first visible block
+  std::vector<int> block_top_;          ///< Minimum top of blocks_[i..end], to find the last visible block
+  std::vector<Layout> layouts_;         ///< Documents formatted for other widths, most recent first
+  int           layout_width_;          ///< Text width of the current layout, -1 if none
+  Fl_Color      layout_color_;          ///< Widget color of the current layout
+  Fl_Color      layout_defcolor_;       ///< Default text color of the current layout
 
   int           topline_;               ///< Vertical offset of document, measure in pixels
   int           leftline_;              ///< Horizontal offset of document, measure in pixels
@@ -258,6 +286,10 @@ public:
   int           do_align(Text_Block *block, int line, int xx, Align a, int &l);
   void          format();
   void          format_table(int *table_width, int *columns, const char *table);
+  void          format_scrollbars();
+  bool          find_layout(int width);
+  void          clear_layouts();
+  void          index_blocks();
   Align         get_align(const char *p, Align a);
   const char    *get_attr(const char *p, const char *n, char *buf, int bufsize);
   Fl_Color      get_color(const char *n, Fl_Color c);
@@ -320,11 +352,11 @@ public:
   /** Return the current default text color. */
   Fl_Color      textcolor() const { return (defcolor_); }
   /** Set the default text font. */
-  void          textfont(Fl_Font f) { textfont_ = f; format(); }
+  void          textfont(Fl_Font f) { textfont_ = f; clear_layouts(); format(); }
   /** Return the default text font. */
   Fl_Font       textfont() const { return (textfont_); }
   /** Set the default text size. */
-  void          textsize(Fl_Fontsize s) { textsize_ = s; format(); }
+  void          textsize(Fl_Fontsize s) { textsize_ = s; clear_layouts(); format(); }
   /** Get the default text size. */
   Fl_Fontsize   textsize() const { return (textsize_); }
   void          topline(const char *n);
@@ -670,6 +702,9 @@ void Fl_Help_View::Impl::free_data() {
   blocks_ .clear();
   link_list_.clear();
   target_line_map_.clear();
+  block_bottom_.clear();
+  block_top_.clear();
+  clear_layouts();
 }
 
 
@@ -882,6 +917,11 @@ int Fl_Help_View::Impl::do_align(
   The main algorithm consists of an outer loop that may repeat if the computed content
   exceeds the available width (to adjust hsize_), and an inner loop that parses the text,
   handles tags, manages formatting state, and builds the layout structures.
+  The inner loop always runs to the end to find the widest content, so the
+  outer loop usually repeats at most once.
+
+  If the document was formatted for the same width before, the layout is
+  reused (see find_layout()) and only the scrollbars are updated.
 */
 void Fl_Help_View::Impl::format() {
   int           i;              // Looping var
@@ -928,7 +968,15 @@ void Fl_Help_View::Impl::format() {
 
   // Reset document width...
   int scrollsize = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
-  hsize_ = view.w() - scrollsize - Fl::box_dw(b);
+  int width = view.w() - scrollsize - Fl::box_dw(b);
+
+  // Formatted for this width before?
+  if (find_layout(width)) {
+    format_scrollbars();
+    return;
+  }
+
+  hsize_ = width;
 
   done = 0;
   while (!done)
@@ -984,10 +1032,11 @@ void Fl_Help_View::Impl::format() {
         if (!head && !pre)
         {
           // Check width...
+          //   Don't restart at once: keep going to find the widest element,
+          //   so that the document is formatted at most once more.
           if (ww > hsize_) {
             hsize_ = ww;
             done   = 0;
-            break;
           }
 
           if (needspace && xx > block->x)
@@ -1049,7 +1098,6 @@ void Fl_Help_View::Impl::format() {
           if (xx > hsize_) {
             hsize_ = xx;
             done   = 0;
-            break;
           }
 
           needspace = 0;
@@ -1198,7 +1246,6 @@ void Fl_Help_View::Impl::format() {
 #endif // DEBUG
               hsize_ = xx + table_width;
               done   = 0;
-              break;
             }
 
             switch (get_align(attrs, talign))
@@ -1549,7 +1596,6 @@ void Fl_Help_View::Impl::format() {
           if (ww > hsize_) {
             hsize_ = ww;
             done   = 0;
-            break;
           }
 
           if (needspace && xx > block->x)
@@ -1583,7 +1629,6 @@ void Fl_Help_View::Impl::format() {
         if (xx > hsize_) {
           hsize_ = xx;
           done   = 0;
-          break;
         }
 
         line      = do_align(block, line, xx, newalign, links);
@@ -1637,7 +1682,6 @@ void Fl_Help_View::Impl::format() {
       if (ww > hsize_) {
         hsize_ = ww;
         done   = 0;
-        break;
       }
 
       if (needspace && xx > block->x)
@@ -1668,6 +1712,21 @@ void Fl_Help_View::Impl::format() {
 
 //  printf("margins.depth_=%d\n", margins.depth_);
 
+  index_blocks();
+  format_scrollbars();
+}
+
+
+/**
+  \brief Shows or hides the scrollbars and adjusts the scroll position.
+
+  This depends on the widget size and the formatted document size, but not
+  on the document itself, so resize() doesn't need to format the document
+  again if only the height of the widget changes.
+*/
+void Fl_Help_View::Impl::format_scrollbars() {
+  Fl_Boxtype    b = view.box() ? view.box() : FL_DOWN_BOX;
+                                // Box to draw...
   int dx = Fl::box_dw(b) - Fl::box_dx(b);
   int dy = Fl::box_dh(b) - Fl::box_dy(b);
   int ss = scrollbar_size_ ? scrollbar_size_ : Fl::scrollbar_size();
@@ -1717,6 +1776,107 @@ void Fl_Help_View::Impl::format() {
 }
 
 
+/**
+  \brief Makes the document formatted for a given text width current.
+
+  If the current layout was formatted for \p width, nothing changes.
+  Otherwise the current layout is kept for later and a layout for \p width
+  is restored if one was kept before.
+
+  \param[in] width Text width, i.e. the initial document width
+  \return true if the document is formatted, false if it must be formatted
+ */
+bool Fl_Help_View::Impl::find_layout(int width)
+{
+  if (!value_)
+    return false;
+
+  if (width == layout_width_ && view.color() == layout_color_ && defcolor_ == layout_defcolor_)
+    return true;
+
+  // Keep the current layout...
+  if (layout_width_ >= 0) {
+    Layout l;
+    l.width     = layout_width_;
+    l.color     = layout_color_;
+    l.defcolor  = layout_defcolor_;
+    l.size      = size_;
+    l.hsize     = hsize_;
+    l.bgcolor   = bgcolor_;
+    l.textcolor = textcolor_;
+    l.linkcolor = linkcolor_;
+    l.title.swap(title_);
+    l.blocks.swap(blocks_);
+    l.links.swap(link_list_);
+    l.targets.swap(target_line_map_);
+    layouts_.insert(layouts_.begin(), std::move(l));
+  }
+
+  layout_width_    = width;
+  layout_color_    = view.color();
+  layout_defcolor_ = defcolor_;
+
+  // ..and restore the one for this width, if any
+  for (size_t i = 1; i < layouts_.size(); i++) {
+    Layout &l = layouts_[i];
+    if (l.width == width && l.color == layout_color_ && l.defcolor == defcolor_) {
+      size_      = l.size;
+      hsize_     = l.hsize;
+      bgcolor_   = l.bgcolor;
+      textcolor_ = l.textcolor;
+      linkcolor_ = l.linkcolor;
+      title_.swap(l.title);
+      blocks_.swap(l.blocks);
+      link_list_.swap(l.links);
+      target_line_map_.swap(l.targets);
+      layouts_.erase(layouts_.begin() + i);
+      index_blocks();
+      return true;
+    }
+  }
+
+  if (layouts_.size() > MAX_LAYOUTS)
+    layouts_.resize(MAX_LAYOUTS);
+  return false;
+}
+
+
+/**
+  \brief Forgets all formatted documents, so that format() formats again.
+ */
+void Fl_Help_View::Impl::clear_layouts()
+{
+  layouts_.clear();
+  layout_width_ = -1;
+}
+
+
+/**
+  \brief Indexes the vertical extent of the blocks for draw().
+
+  Blocks are mostly, but not strictly, sorted by their position (e.g. table
+  cells and nested blocks), so draw() uses the running maximum of the block
+  bottoms and the running minimum of the block tops from the end to find the
+  range of blocks that can be visible by binary search.
+ */
+void Fl_Help_View::Impl::index_blocks()
+{
+  int n = (int)blocks_.size();
+  block_bottom_.resize(n);
+  block_top_.resize(n);
+  int m = INT_MIN;
+  for (int i = 0; i < n; i++) {
+    m = std::max(m, blocks_[i].y + blocks_[i].h);
+    block_bottom_[i] = m;
+  }
+  m = INT_MAX;
+  for (int i = n - 1; i >= 0; i--) {
+    m = std::min(m, blocks_[i].y);
+    block_top_[i] = m;
+  }
+}
+
+
 /**
   \brief Format a table
   \param[out] table_width Total width of the table
@@ -2700,7 +2860,11 @@ void Fl_Help_View::Impl::draw()
   fl_color(textcolor_);
 
   // Draw all visible blocks...
-  for (i = 0, block = &blocks_[0]; i < (int)blocks_.size(); i ++, block ++)
+  int first = (int)(std::lower_bound(block_bottom_.begin(), block_bottom_.end(), topline_)
+                    - block_bottom_.begin());
+  int last = (int)(std::lower_bound(block_top_.begin(), block_top_.end(), topline_ + view.h())
+                   - block_top_.begin());
+  for (i = first, block = &blocks_[0] + first; i < last; i ++, block ++)
     if ((block->y + block->h) >= topline_ && block->y < (topline_ + view.h()))
     {
       line      = 0;
@@ -0,0 +1,275 @@
+//
+// Idle job scheduler for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+  \file Fl_Idle_Scheduler.cxx
+*/
+
+#include <FL/Fl_Idle_Scheduler.H>
+#include <FL/Fl.H>
+#include "Fl_Screen_Driver.H"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+struct Job {
+  unsigned int id;
+  Fl_Idle_Job_Handler handler;
+  void *data;
+  int priority;
+  double budget;            // time slice per event loop iteration
+  double run_time;          // accumulated time spent in 'handler'
+  unsigned long calls;      // number of calls of 'handler'
+  bool removed;             // removed while the scheduler was running
+};
+
+// Jobs sorted by descending priority, in round-robin order within a priority,
+// unless 'unsorted' is set
+std::vector<Job *> jobs;
+bool unsorted = false;      // sweep_jobs() must sort the jobs again
+
+unsigned int last_id = 0;
+double max_total = 0.010;   // see Fl_Idle_Scheduler::total_budget()
+bool running = false;       // run_jobs() is active
+
+// minimal time between two checks for pending input (in seconds)
+const double input_check_interval = 0.0005;
+
+bool higher_priority(const Job *a, const Job *b) {
+  return a->priority > b->priority;
+}
+
+Job *find_job(unsigned int id) {
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (jobs[i]->id == id && !jobs[i]->removed) return jobs[i];
+  }
+  return 0;
+}
+
+// Moves a job behind all other jobs. This doesn't depend on the order of
+// the jobs, which may be changed by the handlers: the stable sort in
+// sweep_jobs() moves the job back behind the other jobs of its priority.
+void rotate_job(Job *job) {
+  std::vector<Job *>::iterator it = std::find(jobs.begin(), jobs.end(), job);
+  if (it != jobs.end()) std::rotate(it, it + 1, jobs.end());
+  unsorted = true;
+}
+
+void run_jobs(void *);
+
+// Deletes removed jobs and restores the priority order, not while running:
+// run_jobs() calls it again when it is done
+void sweep_jobs() {
+  if (running) return;
+  size_t n = 0;
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (jobs[i]->removed) delete jobs[i];
+    else jobs[n++] = jobs[i];
+  }
+  jobs.resize(n);
+  if (unsorted) {
+    std::stable_sort(jobs.begin(), jobs.end(), higher_priority);
+    unsorted = false;
+  }
+  if (jobs.empty()) Fl::remove_idle(run_jobs);
+}
+
+// The idle callback: runs jobs in priority order until the total budget
+// is used or user input is pending
+void run_jobs(void *) {
+  Fl_Screen_Driver *driver = Fl::screen_driver();
+  if (driver->input_pending()) return;
+  running = true;
+  Fl_Timestamp start = Fl::now();
+  double last_check = 0.0;
+  bool stop = false;
+  std::vector<Job *> order(jobs); // jobs may be added or removed by handlers
+  for (size_t i = 0; i < order.size() && !stop; i++) {
+    Job *job = order[i];
+    if (job->removed) continue;
+    Fl_Timestamp slice = Fl::now();
+    double used = 0.0;
+    int more;
+    do {
+      more = job->handler(job->data);
+      job->calls++;
+      used = Fl::seconds_since(slice);
+      double total = Fl::seconds_since(start);
+      if (total >= max_total) {
+        stop = true;
+      } else if (total - last_check >= input_check_interval) {
+        last_check = total;
+        stop = (driver->input_pending() != 0);
+      }
+    } while (more && !job->removed && !stop && used < job->budget);
+    job->run_time += used;
+    if (!more) job->removed = true;
+    else if (!job->removed) rotate_job(job);
+  }
+  running = false;
+  sweep_jobs();
+}
+
+} // anonymous namespace
+
+
+/**
+  Adds an idle job.
+
+  The job function \p job is called with \p data repeatedly by the event loop
+  until it returns 0 or the job is removed with remove().
+
+  \param[in] job       job function, must not be NULL
+  \param[in] data      user data passed to \p job
+  \param[in] priority  jobs with higher priority run first, default 0
+  \param[in] budget    time slice per event loop iteration in seconds,
+                       default 0.002 (2 ms)
+
+  \return a job id (> 0) that can be used with the other methods of this class,
+    or 0 if \p job is NULL
+*/
+unsigned int Fl_Idle_Scheduler::add(Fl_Idle_Job_Handler job, void *data,
+                                    int priority, double budget) {
+  if (!job) return 0;
+  Job *j = new Job;
+  if (++last_id == 0) last_id = 1;
+  j->id = last_id;
+  j->handler = job;
+  j->data = data;
+  j->priority = priority;
+  j->budget = budget > 0.0 ? budget : 0.0;
+  j->run_time = 0.0;
+  j->calls = 0;
+  j->removed = false;
+  // insert behind all jobs with the same or a higher priority
+  if (unsorted) {
+    jobs.push_back(j);        // sorted by sweep_jobs()
+  } else {
+    size_t pos = 0;
+    while (pos < jobs.size() && jobs[pos]->priority >= priority) pos++;
+    jobs.insert(jobs.begin() + pos, j);
+  }
+  if (!Fl::has_idle(run_jobs)) Fl::add_idle(run_jobs);
+  return j->id;
+}
+
+/**
+  Removes an idle job. A job may remove itself.
+
+  \param[in] id  job id as returned by add()
+  \return 1 if the job was found and removed, 0 otherwise
+*/
+int Fl_Idle_Scheduler::remove(unsigned int id) {
+  Job *job = find_job(id);
+  if (!job) return 0;
+  job->removed = true;
+  sweep_jobs();
+  return 1;
+}
+
+/**
+  Returns 1 if the job with the given \p id is queued, 0 otherwise.
+  Jobs are removed automatically when their function returned 0.
+*/
+int Fl_Idle_Scheduler::has(unsigned int id) {
+  return find_job(id) != 0;
+}
+
+/**
+  Returns the number of queued idle jobs.
+*/
+int Fl_Idle_Scheduler::count() {
+  int n = 0;
+  for (size_t i = 0; i < jobs.size(); i++) {
+    if (!jobs[i]->removed) n++;
+  }
+  return n;
+}
+
+/**
+  Sets the priority of a job. Jobs with higher priority run first.
+*/
+void Fl_Idle_Scheduler::priority(unsigned int id, int p) {
+  Job *job = find_job(id);
+  if (!job || job->priority == p) return;
+  job->priority = p;
+  unsorted = true;
+  sweep_jobs();
+}
+
+/**
+  Returns the priority of a job, or 0 if the job does not exist.
+*/
+int Fl_Idle_Scheduler::priority(unsigned int id) {
+  Job *job = find_job(id);
+  return job ? job->priority : 0;
+}
+
+/**
+  Sets the time slice of a job per event loop iteration in seconds.
+
+  The job function is called at least once per event loop iteration if
+  the job gets a turn, even if the budget is 0.
+*/
+void Fl_Idle_Scheduler::budget(unsigned int id, double seconds) {
+  Job *job = find_job(id);
+  if (job) job->budget = seconds > 0.0 ? seconds : 0.0;
+}
+
+/**
+  Returns the time slice of a job in seconds, or 0 if the job does not exist.
+*/
+double Fl_Idle_Scheduler::budget(unsigned int id) {
+  Job *job = find_job(id);
+  return job ? job->budget : 0.0;
+}
+
+/**
+  Returns the total time in seconds spent in the job function so far,
+  or 0 if the job does not exist.
+*/
+double Fl_Idle_Scheduler::run_time(unsigned int id) {
+  Job *job = find_job(id);
+  return job ? job->run_time : 0.0;
+}
+
+/**
+  Returns the number of calls of the job function so far,
+  or 0 if the job does not exist.
+*/
+unsigned long Fl_Idle_Scheduler::calls(unsigned int id) {
+  Job *job = find_job(id);
+  return job ? job->calls : 0;
+}
+
+/**
+  Sets the maximal time spent in all idle jobs per event loop iteration.
+
+  The default is 0.01 seconds (10 ms). If this is used up, remaining jobs
+  get their turn in the next event loop iteration.
+*/
+void Fl_Idle_Scheduler::total_budget(double seconds) {
+  max_total = seconds > 0.0 ? seconds : 0.0;
+}
+
+/**
+  Returns the maximal time spent in all idle jobs per event loop iteration.
+*/
+double Fl_Idle_Scheduler::total_budget() {
+  return max_total;
+}
@@ -0,0 +1,81 @@
+//
+// Deferred layout of Fl_Flex and Fl_Grid for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Layout_Queue.H"
+#include <FL/Fl_Group.H>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Entry {
+  Fl_Group *group;
+  int depth;                            // number of parents
+};
+
+bool shallower(const Entry &a, const Entry &b) {
+  return a.depth < b.depth;
+}
+
+} // namespace
+
+// The widgets in the queue and their layout functions. pending and batch
+// may contain widgets that were removed (or added again) in the meantime,
+// only the entries of widgets that are in 'queued' are calculated.
+static std::unordered_map<Fl_Group *, Fl_Layout_Queue::Layout> queued;
+static std::vector<Entry> pending;      // added since the last round
+static std::vector<Entry> batch;        // round being calculated by run()
+static bool running = false;
+
+void Fl_Layout_Queue::add(Fl_Group *g, Layout layout) {
+  if (!queued.insert(std::make_pair(g, layout)).second) return;
+  Entry e = { g, 0 };
+  pending.push_back(e);
+}
+
+void Fl_Layout_Queue::remove(Fl_Group *g) {
+  queued.erase(g);
+}
+
+// Calculates all pending layouts, outer widgets first
+void Fl_Layout_Queue::run() {
+  if (running) return;
+  running = true;
+  while (!pending.empty()) {
+    batch.swap(pending);
+    pending.clear();
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (!queued.count(batch[i].group)) continue;
+      int depth = 0;
+      for (const Fl_Widget *p = batch[i].group->parent(); p; p = p->parent())
+        depth++;
+      batch[i].depth = depth;
+    }
+    std::stable_sort(batch.begin(), batch.end(), shallower);
+    for (size_t i = 0; i < batch.size(); i++) {
+      // the layout of an outer widget may delete the widget
+      std::unordered_map<Fl_Group *, Layout>::iterator it = queued.find(batch[i].group);
+      if (it == queued.end()) continue;
+      Layout layout = it->second;
+      queued.erase(it);
+      layout(batch[i].group);
+    }
+    batch.clear();
+  }
+  running = false;
+}
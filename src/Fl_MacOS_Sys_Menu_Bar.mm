@@ -412,7 +412,9 @@ static void createSubMenu( NSMenu *mh, pFl_Menu_Item &mm,  const Fl_Menu_Item *m
     else if ( mm->flags & FL_SUBMENU_POINTER )
     {
       const Fl_Menu_Item *smm = (Fl_Menu_Item*)mm->user_data_;
-      createSubMenu( submenu, smm, mm, selector);
+      if (!smm && fl_sys_menu_bar) // lazy submenu: native menus need its items now
+        smm = fl_sys_menu_bar->populate_submenu(mm);
+      if (smm) createSubMenu( submenu, smm, mm, selector);
     }
     if ( flags & FL_MENU_DIVIDER ) {
       [submenu addItem:[NSMenuItem separatorItem]];
@@ -28,6 +28,10 @@
 #include <FL/fl_draw.H>
 #include <stdio.h>
 #include "flstring.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
 
 // This file will declare:
 class Menu_Window_Basetype;
@@ -128,6 +132,16 @@ struct Menu_State
   // handle FL_SHORTCUT in any of the menu windows
   int handle_shortcut();
 
+  // select an item by typing the start of its label in a scrolling menu
+  int handle_type_ahead();
+
+  // scroll the menu window under the mouse pointer
+  int handle_mousewheel();
+
+  // text typed by handle_type_ahead() and the time of the last key
+  std::string typed;
+  Fl_Timestamp typed_time { };
+
   // move menu item selection left
   int handle_left();
 
@@ -298,6 +312,41 @@ public:
   // Scroll so item i is visible on screen. This may move the entire window..
   void autoscroll(item_index_t i);
 
+  // Show the items starting at index top in a scrolling window
+  void scroll_to(item_index_t top);
+
+  // Keep scrolling while the mouse pointer is over a scroll arrow
+  void edge_scroll(int mx, int my);
+  static void edge_scroll_cb(void *data);
+
+  // Return true if the window is shorter than the menu and scrolls the items
+  bool scrolling() const { return visible_items < num_items; }
+
+  // Return the row of the window at the given root coordinates, or -1
+  item_index_t find_row(int mx, int my);
+
+  // Return -1 or 1 if the row shows an arrow to scroll up or down, else 0.
+  // The first (last) row shows an arrow instead of an item while there are
+  // more items above (below) the visible ones.
+  int scroll_arrow(item_index_t row) const {
+    if (!scrolling()) return 0;
+    if (row == 0 && top_item > 0) return -1;
+    if (row == visible_items-1 && top_item+visible_items < num_items) return 1;
+    return 0;
+  }
+
+  // Return the item at index n, or the terminator if n >= num_items
+  const Fl_Menu_Item *item(item_index_t n) const {
+    if (n < 0 || items.empty()) return nullptr;
+    return items[n < num_items ? n : num_items];
+  }
+
+  // Find the next item whose label starts with prefix, beginning at start
+  item_index_t find_label(const char *prefix, item_index_t start);
+
+  // Draw the visible items in the rows first to last
+  void draw_items(item_index_t first, item_index_t last);
+
   // Also reposition the title (relative to the parent_ window?)
   void position(int x, int y);
 
@@ -316,6 +365,22 @@ public:
   // Number of menu items in the window.
   item_index_t num_items { 0 };
 
+  // All menu items of the window followed by the terminator, so that items
+  // can be accessed by index without walking the menu array.
+  std::vector<const Fl_Menu_Item*> items;
+
+  // A menu that is taller than the screen shows visible_items items,
+  // starting with item top_item, and scrolls. Only these items are drawn.
+  item_index_t visible_items { 0 };
+  item_index_t top_item { 0 };
+
+  // Remember the top_item we drew, so a scroll can move the drawn items.
+  item_index_t drawn_top { 0 };
+
+  // Labels of the selectable items in lower case with their item index,
+  // sorted for find_label(). Created by the first search.
+  std::vector<std::pair<std::string, item_index_t> > labels;
+
   // Index of selected item, or -1 if none is selected.
   item_index_t selected { -1 };
 
@@ -371,7 +436,7 @@ void Menu_State::set_current_item(const Fl_Menu_Item* i, menu_index_t m, item_in
   \param[in] n index into visible item in that menu window
 */
 void Menu_State::set_current_item(menu_index_t m, item_index_t n) {
-  current_item = (n >= 0) ? menu_window[m]->menu->next(n) : 0;
+  current_item = (n >= 0) ? menu_window[m]->item(n) : 0;
   current_menu_ix = m;
   current_item_ix = n;
 }
@@ -390,7 +455,7 @@ bool Menu_State::next_item(menu_index_t menu) { // go to next item in menu menu
   bool wrapped = false;
   do {
     while (++item < m.num_items) {
-      const Fl_Menu_Item* m1 = m.menu->next(item);
+      const Fl_Menu_Item* m1 = m.item(item);
       if (m1->selectable()) {
         set_current_item(m1, menu, item);
         return true;
@@ -418,7 +483,7 @@ bool Menu_State::prev_item(menu_index_t menu) { // previous item in menu menu if
   bool wrapped = false;
   do {
     while (--item >= 0) {
-      const Fl_Menu_Item* m1 = m.menu->next(item);
+      const Fl_Menu_Item* m1 = m.item(item);
       if (m1->selectable()) {
         set_current_item(m1, menu, item);
         return true;
@@ -450,6 +515,53 @@ int Menu_State::handle_shortcut() {
   return 0;
 }
 
+/* Select an item by typing the first characters of its label.
+  This is only done in scrolling menus: in these, the items can't be seen
+  at once. Keys typed within a second are collected, typing the same key
+  repeatedly cycles through the items that start with it.
+  \return 1 if the key was used.
+*/
+int Menu_State::handle_type_ahead() {
+  if (num_menus < 1 || !Fl::event_length()) return 0;
+  menu_index_t mymenu = (current_item && current_menu_ix >= 0) ? current_menu_ix : num_menus-1;
+  Menu_Window &mw = *(menu_window[mymenu]);
+  if (!mw.scrolling()) return 0;
+  const char *text = Fl::event_text();
+  if ((uchar)text[0] < ' ' || text[0] == 127) return 0;
+  if (Fl::seconds_since(typed_time) > 1.0) typed.clear();
+  typed_time = Fl::now();
+  typed += text;
+  std::string prefix(typed);
+  for (size_t i = 0; i < prefix.size(); i++)
+    prefix[i] = (char)tolower((uchar)prefix[i]);
+  item_index_t start = (mymenu == current_menu_ix && current_item_ix >= 0) ? current_item_ix : 0;
+  if (prefix.find_first_not_of(prefix[0]) == std::string::npos && prefix.size() > 1) {
+    prefix.resize(1);                   // same key again: next item
+    start++;
+  }
+  item_index_t n = mw.find_label(prefix.c_str(), start);
+  if (n >= 0) set_current_item(mw.item(n), mymenu, n);
+  return 1;
+}
+
+/* Scroll the scrolling menu window under the mouse pointer and select the
+  item under the pointer.
+  \return 1 if a window was scrolled.
+*/
+int Menu_State::handle_mousewheel() {
+  int mx = Fl::event_x_root();
+  int my = Fl::event_y_root();
+  for (menu_index_t mymenu = num_menus-1; mymenu >= 0; mymenu--) {
+    Menu_Window &mw = *(menu_window[mymenu]);
+    if (!mw.scrolling() || !mw.is_inside(mx, my)) continue;
+    mw.scroll_to(mw.top_item + 3 * Fl::event_dy());
+    item_index_t item = mw.find_selected(mx, my);
+    if (item >= 0) set_current_item(mymenu, item);
+    return 1;
+  }
+  return 0;
+}
+
 /* Move menu item selection left.
   \return 1
 */
@@ -571,6 +683,8 @@ int Menu_State::handle_mouse_events(int e) {
       int my = Fl::event_y_root();
       item_index_t item = 0;
       menu_index_t mymenu = num_menus-1;
+      for (menu_index_t i = 0; i < num_menus; i++)
+        menu_window[i]->edge_scroll(mx, my);
       // Clicking or dragging outside menu cancels it...
       if ((!in_menubar || mymenu) && !is_inside(mx, my)) {
         set_current_item(0, -1, 0);
@@ -652,6 +766,12 @@ bool Menu_State::create_submenu(const Fl_Rect &r, Menu_Window& cw, const Fl_Menu
     menutable = m+1;
   else
     menutable = (Fl_Menu_Item*)(m)->user_data_;
+  if (!menutable && button) // lazy submenu: let the widget supply the items
+    menutable = ((Fl_Menu_*)button)->populate_submenu(m);
+  if (!menutable) {
+    static Fl_Menu_Item empty_menu;
+    menutable = &empty_menu;
+  }
   // figure out where new menu goes:
   int nX, nY;
   if (!current_menu_ix && in_menubar) {      // menu off a menubar:
@@ -660,7 +780,7 @@ bool Menu_State::create_submenu(const Fl_Rect &r, Menu_Window& cw, const Fl_Menu
     initial_item = 0;
   } else {
     nX = cw.x() + cw.w();
-    nY = cw.y() + current_item_ix * cw.item_height;
+    nY = cw.y() + (current_item_ix - cw.top_item) * cw.item_height;
     title = 0;
   }
   if (initial_item) { // bring up submenu containing initial item:
@@ -770,6 +890,7 @@ Menu_Window::Menu_Window(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
   {
     item_index_t j = 0;
     if (m) for (const Fl_Menu_Item* m1=m; ; m1 = m1->next(), j++) {
+      items.push_back(m1);
       if (picked) {
         if (m1 == picked) {
           selected = j;
@@ -783,6 +904,7 @@ Menu_Window::Menu_Window(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
       if (!m1->text) break;
     }
     num_items = j;
+    visible_items = num_items;
   }
 
   if (in_menubar) {
@@ -839,8 +961,29 @@ Menu_Window::Menu_Window(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
   //if (X > scr_x+scr_w-W) X = right_edge-W;
   if (X > scr_x+scr_w-W) X = scr_x+scr_w-W;
   x(X); w(W);
-  h((num_items ? item_height*num_items-4 : 0)+2*BW+3);
-  if (selected >= 0) {
+  // a menu that doesn't fit on the screen scrolls inside a smaller window:
+  int max_h = scr_h;
+  if (display_height_ > 0 && display_height_ < max_h) max_h = display_height_;
+  if (num_items > 1 && item_height*num_items-4+2*BW+3 > max_h) {
+    visible_items = (max_h-2*BW+1) / item_height;
+    if (visible_items < 3) visible_items = 3; // room for the scroll arrows
+    if (visible_items > num_items) visible_items = num_items;
+  }
+  h((num_items ? item_height*visible_items-4 : 0)+2*BW+3);
+  if (selected >= 0 && scrolling()) {
+    // show the selected item at Y, or as close to it as the screen allows
+    int sel_y = Y+(Hp-item_height)/2;
+    item_index_t row = (sel_y-BW-scr_y) / item_height;
+    if (row > selected) row = selected;
+    if (row < selected-(num_items-visible_items)) row = selected-(num_items-visible_items);
+    if (row > visible_items-1) row = visible_items-1;
+    if (row < 0) row = 0;
+    // don't hide the selected item under a scroll arrow
+    if (row == 0 && selected > 0) row = 1;
+    if (row == visible_items-1 && selected < num_items-1) row = visible_items-2;
+    top_item = drawn_top = selected-row;
+    Y = sel_y-row*item_height-BW;
+  } else if (selected >= 0) {
     Y = Y+(Hp-item_height)/2-selected*item_height-BW;
   } else {
     Y = Y+Hp;
@@ -868,6 +1011,10 @@ Menu_Window::Menu_Window(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
       }
     }
   }
+  if (scrolling()) { // keep the scrolling window on the screen
+    if (Y+h() > scr_y+scr_h) Y = scr_y+scr_h-h();
+    if (Y < scr_y) Y = scr_y;
+  }
   if (m) y(Y); else {y(Y-2); w(1); h(1);}
 
   if (t) {
@@ -887,6 +1034,7 @@ Menu_Window::Menu_Window(const Fl_Menu_Item* m, int X, int Y, int Wp, int Hp,
 
 /* Destroy this window. */
 Menu_Window::~Menu_Window() {
+  Fl::remove_timeout(edge_scroll_cb, this);
   hide();
   delete title;
 }
@@ -944,6 +1092,10 @@ int Menu_Window::handle_part1(int e) {
       break;
     case FL_SHORTCUT:
       if (pp.handle_shortcut()) return 1;
+      if (pp.handle_type_ahead()) return 1;
+      break;
+    case FL_MOUSEWHEEL:
+      if (pp.handle_mousewheel()) return 1;
       break;
     case FL_MOVE:
     case FL_ENTER:
@@ -988,13 +1140,13 @@ int Menu_Window::handle_part2(int e, int ret) {
 void Menu_Window::set_selected(item_index_t n) {
   if (n != selected) {
     if ((selected!=-1) && (menu)) {
-      const Fl_Menu_Item *mi = menu->next(selected);
+      const Fl_Menu_Item *mi = item(selected);
       if ((mi) && (mi->callback_) && (mi->flags & FL_MENU_CHATTY))
         mi->do_callback(this, FL_REASON_LOST_FOCUS);
     }
     selected = n;
     if ((selected!=-1) && (menu)) {
-      const Fl_Menu_Item *mi = menu->next(selected);
+      const Fl_Menu_Item *mi = item(selected);
       if ((mi) && (mi->callback_) && (mi->flags & FL_MENU_CHATTY))
         mi->do_callback(this, FL_REASON_GOT_FOCUS);
     }
@@ -1023,7 +1175,23 @@ item_index_t Menu_Window::find_selected(int mx, int my) {
   }
   if (mx < Fl::box_dx(box()) || mx >= w()) return -1;
   item_index_t n = (my-Fl::box_dx(box())-1)/item_height;
-  if (n < 0 || n>=num_items) return -1;
+  if (n < 0 || n>=visible_items || scroll_arrow(n)) return -1;
+  n += top_item;
+  if (n>=num_items) return -1;
+  return n;
+}
+
+/* Find the row of a scrolling window at the given pixel position.
+ \param[in] mx, my position in pixels
+ \return row index counted from the top of the window, or -1 for none
+ */
+item_index_t Menu_Window::find_row(int mx, int my) {
+  if (!scrolling()) return -1;
+  mx -= x();
+  my -= y();
+  if (my < 0 || my >= h() || mx < Fl::box_dx(box()) || mx >= w()) return -1;
+  item_index_t n = (my-Fl::box_dx(box())-1)/item_height;
+  if (n < 0 || n >= visible_items) return -1;
   return n;
 }
 
@@ -1043,6 +1211,15 @@ int Menu_Window::titlex(int n) {
  \param[in] n index into visible menu items
  */
 void Menu_Window::autoscroll(item_index_t n) {
+  if (scrolling()) { // scroll the items instead of moving the window
+    if (n < 0) return;
+    // keep the item out of the rows that show the scroll arrows
+    if (n-top_item < 1 && top_item > 0)
+      scroll_to(n-1);
+    else if (n-top_item > visible_items-2 && top_item+visible_items < num_items)
+      scroll_to(n < num_items-1 ? n-visible_items+2 : n-visible_items+1);
+    return;
+  }
   int scr_y, scr_h;
   int Y = y()+Fl::box_dx(box())+2+n*item_height;
 
@@ -1061,6 +1238,81 @@ void Menu_Window::autoscroll(item_index_t n) {
   // y(y()+Y); // don't wait for response from X
 }
 
+/* Show the items starting with index top in a scrolling window.
+  The drawn items are moved on the screen, and only the uncovered ones
+  are drawn, see draw().
+ \param[in] top index of the first visible item
+ */
+void Menu_Window::scroll_to(item_index_t top) {
+  if (top > num_items-visible_items) top = num_items-visible_items;
+  if (top < 0) top = 0;
+  if (top == top_item) return;
+  top_item = top;
+  damage(FL_DAMAGE_SCROLL);
+}
+
+/* Scroll by one item at a time while the mouse pointer is over one of the
+  scroll arrows of a scrolling window.
+ \param[in] mx, my mouse position in root coordinates
+ */
+void Menu_Window::edge_scroll(int mx, int my) {
+  if (Fl::has_timeout(edge_scroll_cb, this)) return;
+  if (scroll_arrow(find_row(mx, my)))
+    Fl::add_timeout(0.05, edge_scroll_cb, this);
+}
+
+void Menu_Window::edge_scroll_cb(void *data) {
+  Menu_Window *mw = (Menu_Window*)data;
+  int mx, my;
+  Fl::get_mouse(mx, my);
+  int dir = mw->scroll_arrow(mw->find_row(mx, my));
+  if (!dir || !menu_state) return;
+  mw->scroll_to(mw->top_item+dir);
+  // the arrow disappears at the end of the menu and uncovers an item
+  item_index_t n = mw->find_selected(mx, my);
+  if (n >= 0) {
+    for (menu_index_t i = 0; i < menu_state->num_menus; i++) {
+      if (menu_state->menu_window[i] == mw) {
+        menu_state->set_current_item(i, n);
+        break;
+      }
+    }
+  }
+  Fl::repeat_timeout(0.05, edge_scroll_cb, data);
+}
+
+/* Find the next selectable item whose label starts with prefix.
+ Labels are compared in lower case and without '&' characters.
+ \param[in] prefix lower case text to look for
+ \param[in] start first item index to check, the search wraps around
+ \return index of the item, or -1 if none was found
+ */
+item_index_t Menu_Window::find_label(const char *prefix, item_index_t start) {
+  if (labels.empty()) {
+    for (item_index_t i = 0; i < num_items; i++) {
+      const Fl_Menu_Item *m = items[i];
+      if (!m->selectable() || is_special_labeltype(m->labeltype_)) continue;
+      std::string label;
+      for (const char *t = m->text; *t; t++) {
+        if (*t == '&' && t[1] != '&') continue;
+        if (*t == '&') t++;
+        label += (char)tolower((uchar)*t);
+      }
+      labels.push_back(std::make_pair(label, i));
+    }
+    std::sort(labels.begin(), labels.end());
+  }
+  std::string p(prefix);
+  item_index_t first = -1, next = -1;
+  std::vector<std::pair<std::string, item_index_t> >::const_iterator it =
+    std::lower_bound(labels.begin(), labels.end(), std::make_pair(p, (item_index_t)-1));
+  for (; it != labels.end() && it->first.compare(0, p.size(), p) == 0; ++it) {
+    if (first < 0 || it->second < first) first = it->second;
+    if (it->second >= start && (next < 0 || it->second < next)) next = it->second;
+  }
+  return next >= 0 ? next : first;
+}
+
 /* Set the position of this menu and its title window. */
 void Menu_Window::position(int X, int Y) {
   if (title) {
@@ -1092,22 +1344,35 @@ bool Menu_Window::is_inside(int mx, int my) {
  */
 void Menu_Window::draw_entry(const Fl_Menu_Item* m, int n, int eraseit) {
   if (!m) return; // this happens if -1 is selected item and redrawn
+  if (n < top_item || n >= top_item+visible_items) return; // scrolled out
 
   Fl_Rect bbox {
     Fl::box_dx(box()),
-    Fl::box_dy(box()) + 1 + n*item_height + Fl::menu_linespacing()/2 - 2,
+    Fl::box_dy(box()) + 1 + (n-top_item)*item_height + Fl::menu_linespacing()/2 - 2,
     w() - Fl::box_dw(box()) - 1/*sic*/,
     item_height - Fl::menu_linespacing()
   };
 
+  int arrow = scroll_arrow(n-top_item);
+
   // Clear the entire item rect including the spacing
-  if (eraseit && n != selected) {
+  if (eraseit && (n != selected || arrow)) {
     fl_push_clip(bbox.x()+1, bbox.y()-(Fl::menu_linespacing()-2)/2,
                  bbox.w()-2, bbox.h()+(Fl::menu_linespacing()-2));
     draw_box(box(), 0, 0, w(), h(), button ? button->color() : color());
     fl_pop_clip();
   }
 
+  // Draw the scroll arrow that covers the item
+  if (arrow) {
+    int sz = ((bbox.h()-2) & (-2)) + 1;
+    if (sz > 13) sz = 13;
+    fl_draw_arrow(Fl_Rect(bbox.x() + (bbox.w()-sz)/2, bbox.y() + (bbox.h()-sz)/2, sz, sz),
+                  FL_ARROW_SINGLE, arrow < 0 ? FL_ORIENT_UP : FL_ORIENT_DOWN,
+                  button ? button->textcolor() : FL_FOREGROUND_COLOR);
+    return;
+  }
+
   // Draw the checkbox, radio box, the menu icon, and the label
   m->draw(bbox.x(), bbox.y(), bbox.w(), bbox.h(), button, n==selected);
 
@@ -1175,11 +1440,39 @@ void Menu_Window::draw_divider(const Fl_Rect& bbox) {
 }
 
 
+/* Draw the items of a scrolling menu window that intersect an area.
+ This is the callback of fl_scroll() in Menu_Window::draw().
+ */
+static void draw_area(void *data, int X, int Y, int W, int H) {
+  Menu_Window *mw = (Menu_Window*)data;
+  int y0 = Fl::box_dy(mw->box());
+  fl_push_clip(X, Y, W, H);
+  fl_draw_box(mw->box(), 0, 0, mw->w(), mw->h(), button ? button->color() : mw->color());
+  // one more row on each side for the spacing and dividers between the rows
+  mw->draw_items((Y-y0)/mw->item_height-1, (Y+H-y0)/mw->item_height+1);
+  fl_pop_clip();
+}
+
+/* Draw the visible items of the window in the given rows. */
+void Menu_Window::draw_items(item_index_t first, item_index_t last) {
+  if (!menu || items.empty()) return;
+  if (first < 0) first = 0;
+  if (last > visible_items-1) last = visible_items-1;
+  for (item_index_t j = top_item+first; j <= top_item+last && j < num_items; j++)
+    draw_entry(items[j], j, 0);
+}
+
 /* Draw the menuwindow. If the damage flags are FL_DAMAGE_CHILD, only redraw
- the old selected and the newly selected items.
+ the old selected and the newly selected items. FL_DAMAGE_SCROLL moves the
+ items drawn before and draws the items that became visible.
  */
 void Menu_Window::draw() {
-  if (damage() != FL_DAMAGE_CHILD) {    // complete redraw
+  float scale = Fl_Surface_Device::surface()->driver()->scale();
+  if ((damage() & FL_DAMAGE_SCROLL) && scale != int(scale))
+    damage(FL_DAMAGE_ALL); // fl_scroll() isn't pixel-accurate with this scaling
+  uchar d = damage();
+  if (!(d & (FL_DAMAGE_CHILD|FL_DAMAGE_SCROLL)) || (d & ~(FL_DAMAGE_CHILD|FL_DAMAGE_SCROLL))) {
+    // complete redraw
     if (    (box() != FL_FLAT_BOX)
          && (Fl::is_scheme( "gtk+" ) || Fl::is_scheme( "plastic") || Fl::is_scheme( "gleam" ) )) {
       // Draw a FL_FLAT_BOX to avoid on macOS the white corners of the menus
@@ -1187,19 +1480,27 @@ void Menu_Window::draw() {
                   button ? button->color() : color());
     }
     fl_draw_box(box(), 0, 0, w(), h(), button ? button->color() : color());
-    if (menu) {
-      const Fl_Menu_Item* m; int j;
-      for (m=menu->first(), j=0; m->text; j++, m = m->next())
-        draw_entry(m, j, 0);
-    }
+    draw_items(0, visible_items-1);
   } else {
-    if (damage() & FL_DAMAGE_CHILD && selected!=drawn_selected) {
+    if ((d & FL_DAMAGE_SCROLL) && top_item != drawn_top) {
+      item_index_t dy = drawn_top-top_item;
+      int X = Fl::box_dx(box()), Y = Fl::box_dy(box());
+      fl_scroll(X, Y, w()-Fl::box_dw(box()), h()-Fl::box_dh(box()),
+                0, dy*item_height, draw_area, this);
+      // the rows with the scroll arrows before and after scrolling
+      item_index_t rows[4] = { 0, visible_items-1, dy, visible_items-1+dy };
+      for (int i = 0; i < 4; i++)
+        if (rows[i] >= 0 && rows[i] < visible_items)
+          draw_entry(items[top_item+rows[i]], top_item+rows[i], 1);
+    }
+    if (selected!=drawn_selected) {
       // change selection
-      draw_entry(menu->next(drawn_selected), drawn_selected, 1);
-      draw_entry(menu->next(selected), selected, 1);
+      draw_entry(item(drawn_selected), drawn_selected, 1);
+      draw_entry(item(selected), selected, 1);
     }
   }
   drawn_selected = selected;
+  drawn_top = top_item;
 }
 
 //
@@ -1632,7 +1933,7 @@ const Fl_Menu_Item* Fl_Menu_Item::test_shortcut() const {
       if (!ret && m->submenu()) {
         const Fl_Menu_Item* s =
         (m->flags&FL_SUBMENU) ? m+1:(const Fl_Menu_Item*)m->user_data_;
-        ret = s->test_shortcut();
+        if (s) ret = s->test_shortcut(); // NULL: lazy submenu
       }
     }
   }
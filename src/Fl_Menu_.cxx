@@ -26,6 +26,63 @@
 #include "flstring.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <unordered_map>
+
+/*
+  Fl_Menu_Path_Index maps the pathnames of all items of the menu array to
+  the index of the first item with that pathname, so that find_index(const
+  char*) and find_item(const char*) don't need to build and compare the
+  pathnames of all items. It is built on the first lookup and dropped by
+  all Fl_Menu_ methods that change the array: add(), insert(), replace(),
+  remove(), mode(), menu() and clear(). Lookups only check that the array
+  was not moved, e.g. by menu_end().
+*/
+class Fl_Menu_Path_Index {
+public:
+  const Fl_Menu_Item *array;            // the array the index was built for
+  std::unordered_map<std::string, int> map;
+  Fl_Menu_Path_Index(const Fl_Menu_Item *menu, int n);
+};
+
+// The pathnames are built like item_pathname() does, but submenu pointers
+// (FL_SUBMENU_POINTER) are not followed. If several items have the same
+// pathname, the first one is found.
+Fl_Menu_Path_Index::Fl_Menu_Path_Index(const Fl_Menu_Item *menu, int n)
+  : array(menu) {
+  map.reserve(n);
+  std::string menupath;                 // File/Export
+  for (int t = 0; t < n; t++) {
+    const Fl_Menu_Item *m = menu + t;
+    if (m->flags&FL_SUBMENU) {
+      if (!menupath.empty()) menupath += '/';
+      menupath += m->label();
+      map.insert(std::make_pair(menupath, t));
+    } else if (!m->label()) {           // end of submenu: pop back one level
+      size_t ss = menupath.rfind('/');
+      menupath.resize(ss == std::string::npos ? 0 : ss);
+    } else {
+      std::string itempath(menupath);   // eg. Edit/Copy
+      if (!itempath.empty()) itempath += '/';
+      itempath += m->label();
+      map.insert(std::make_pair(itempath, t));
+    }
+  }
+}
+
+// Drops the path index after the menu array was changed
+void Fl_Menu_::clear_path_index_() const {
+  delete path_index_;
+  path_index_ = 0;
+}
+
+// Returns whether the last part of a pathname is the label of the item found
+static bool path_label_matches(const char *pathname, const char *label) {
+  if (!label) return false;
+  size_t n = strlen(pathname), l = strlen(label);
+  if (l > n || strcmp(pathname + n - l, label)) return false;
+  return l == n || pathname[n - l - 1] == '/';
+}
 
 #define SAFE_STRCAT(s) { len += (int) strlen(s); if ( len >= namelen ) { *name='\0'; return(-2); } else strcat(name,(s)); }
 
@@ -74,13 +131,15 @@ int Fl_Menu_::item_pathname_(char *name,
   int level = 0;
   finditem = finditem ? finditem : mvalue();
   menu = menu ? menu : this->menu();
-  for ( int t=0; t<size(); t++ ) {
+  int n = size();
+  for ( int t=0; t<n; t++ ) {
     const Fl_Menu_Item *m = menu + t;
     if (m->submenu()) {                         // submenu? descend
       if (m->flags & FL_SUBMENU_POINTER) {
         // SUBMENU POINTER? Recurse to descend
         int slen = (int)strlen(name);
         const Fl_Menu_Item *submenu = (const Fl_Menu_Item*)m->user_data();
+        if (!submenu) continue;                 // lazy submenu, not populated yet
         if (m->label()) {
           if (*name) SAFE_STRCAT("/");
           SAFE_STRCAT(m->label());
@@ -196,7 +255,8 @@ int Fl_Menu_::find_index(const Fl_Menu_Item *item) const {
  \see      find_index(const char*)
  */
 int Fl_Menu_::find_index(Fl_Callback *cb) const {
-  for ( int t=0; t < size(); t++ )
+  int n = size();
+  for ( int t=0; t < n; t++ )
     if (menu_[t].callback_==cb)
       return(t);
   return(-1);
@@ -210,38 +270,37 @@ int Fl_Menu_::find_index(Fl_Callback *cb) const {
 
  To get the menu item pointer for a pathname, use find_item()
 
+ The pathnames of all items are indexed by the first call and further
+ lookups take constant time, until the menu is changed with add(), insert(),
+ replace(), remove(), mode(), menu() or clear(). Items renamed directly,
+ e.g. with Fl_Menu_Item::label(), are found by their new pathnames because
+ the index is built again if the label of the item found doesn't match the
+ last part of \p pathname or if no item is found. If you rename a submenu
+ or change the FL_SUBMENU flags of items directly, call replace() or mode()
+ for the changed items, or the index may still find the old pathnames of
+ the items in the submenu.
+
  \param[in] pathname The path and name of the menu item to find
  \returns        The index of the matching item, or -1 if not found.
  \see            item_pathname()
 
 */
 int Fl_Menu_::find_index(const char *pathname) const {
-  char menupath[1024] = "";     // File/Export
-  for ( int t=0; t < size(); t++ ) {
-    Fl_Menu_Item *m = menu_ + t;
-    if (m->flags&FL_SUBMENU) {
-      // IT'S A SUBMENU
-      // we do not support searches through FL_SUBMENU_POINTER links
-      if (menupath[0]) strlcat(menupath, "/", sizeof(menupath));
-      strlcat(menupath, m->label(), sizeof(menupath));
-      if (!strcmp(menupath, pathname)) return(t);
-    } else {
-      if (!m->label()) {
-        // END OF SUBMENU? Pop back one level.
-        char *ss = strrchr(menupath, '/');
-        if ( ss ) *ss = 0;
-        else menupath[0] = '\0';
-        continue;
-      }
-      // IT'S A MENU ITEM
-      char itempath[1024];      // eg. Edit/Copy
-      strcpy(itempath, menupath);
-      if (itempath[0]) strlcat(itempath, "/", sizeof(itempath));
-      strlcat(itempath, m->label(), sizeof(itempath));
-      if (!strcmp(itempath, pathname)) return(t);
+  if (!menu_) return(-1);
+  if (path_index_ && path_index_->array != menu_)
+    clear_path_index_();
+  bool built = false;
+  for (;;) {
+    if (!path_index_) {
+      path_index_ = new Fl_Menu_Path_Index(menu_, size());
+      built = true;
     }
+    std::unordered_map<std::string, int>::const_iterator it = path_index_->map.find(pathname);
+    if (it != path_index_->map.end() && path_label_matches(pathname, menu_[it->second].label()))
+      return it->second;
+    if (built) return -1;
+    clear_path_index_();      // an item may have been renamed: build the index again
   }
-  return(-1);
 }
 
 /**
@@ -257,7 +316,8 @@ int Fl_Menu_::find_index(const char *pathname) const {
  \see find_item(const char*)
  */
 const Fl_Menu_Item * Fl_Menu_::find_item(Fl_Callback *cb) {
-  for ( int t=0; t < size(); t++ ) {
+  int n = size();
+  for ( int t=0; t < n; t++ ) {
     const Fl_Menu_Item *m = menu_ + t;
     if (m->callback_==cb) {
       return m;
@@ -274,7 +334,8 @@ const Fl_Menu_Item * Fl_Menu_::find_item(Fl_Callback *cb) {
  \see find_item(const char*)
  */
 const Fl_Menu_Item* Fl_Menu_::find_item_with_user_data(void *v) {
-  for ( int t=0; t < size(); t++ ) {
+  int n = size();
+  for ( int t=0; t < n; t++ ) {
     const Fl_Menu_Item *m = menu_ + t;
     if (m->user_data_==v) {
       return m;
@@ -291,7 +352,8 @@ const Fl_Menu_Item* Fl_Menu_::find_item_with_user_data(void *v) {
  \see find_item(const char*)
  */
 const Fl_Menu_Item* Fl_Menu_::find_item_with_argument(long v) {
-  for ( int t=0; t < size(); t++ ) {
+  int n = size();
+  for ( int t=0; t < n; t++ ) {
     const Fl_Menu_Item *m = menu_ + t;
     if (m->argument()==v) {
       return m;
@@ -429,6 +491,7 @@ static Fl_Menu_Item *first_submenu_item(Fl_Menu_Item *item, Fl_Menu_Item *start)
       if (m == item) return start; // item is found, return menu start item
       if (m->flags & FL_SUBMENU_POINTER) {
         // scan the detached submenu which begins at m->user_data()
+        if (!m->user_data()) { m++; continue; } // lazy submenu, not populated yet
         Fl_Menu_Item *first = first_submenu_item(item, (Fl_Menu_Item*)m->user_data());
         if (first) return first; // if item was found in the submenu, return
       }
@@ -461,6 +524,62 @@ void Fl_Menu_::setonly(Fl_Menu_Item* item) {
   }
 }
 
+/**
+  Sets the callback that supplies the items of lazy submenus.
+
+  A lazy submenu is an item with the FL_SUBMENU_POINTER flag and a NULL
+  user_data(). When it is opened for the first time, \p cb is called
+  with this widget, the item and \p data, and returns the array of items
+  of the submenu (terminated by an item with a NULL label) or NULL.
+  The array is stored in the item's user_data(), so the callback is only
+  called again after the application sets the user_data() to NULL.
+
+  This allows large menus to be built without creating the items of all
+  submenus in advance. The returned array is owned by the application
+  and must stay valid as long as the item refers to it.
+
+  \note Shortcuts and item_pathname() don't see the items of lazy
+    submenus that were not opened yet.
+
+  \b Example:
+  \code
+    const Fl_Menu_Item *recent_files(Fl_Menu_ *menu, const Fl_Menu_Item *item, void *data) {
+      static Fl_Menu_Item items[MAX_RECENT + 1];
+      // fill in the items ...
+      return items;
+    }
+    [..]
+    menubar->add("File/Open Recent", 0, 0, 0, FL_SUBMENU_POINTER);
+    menubar->populate_callback(recent_files);
+  \endcode
+
+  \param[in] cb    the callback, or NULL
+  \param[in] data  user data passed to the callback
+  \see populate_submenu(const Fl_Menu_Item*)
+*/
+void Fl_Menu_::populate_callback(Fl_Menu_Populate_Callback *cb, void *data) {
+  populate_cb_ = cb;
+  populate_data_ = data;
+}
+
+/**
+  Returns the first item of the submenu of \p item.
+
+  If \p item is a lazy submenu, the populate_callback() is called first
+  to supply its items. Menu windows call this when a submenu is opened.
+
+  \param[in] item  a submenu item of this menu
+  \returns the first item of the submenu, or NULL if \p item is not a
+    submenu or no items were supplied for it
+*/
+const Fl_Menu_Item *Fl_Menu_::populate_submenu(const Fl_Menu_Item *item) {
+  if (!item || !item->submenu()) return 0;
+  if (item->flags & FL_SUBMENU) return item + 1;
+  if (!item->user_data_ && populate_cb_)
+    ((Fl_Menu_Item*)item)->user_data_ = (void*)populate_cb_(this, item, populate_data_);
+  return (const Fl_Menu_Item*)item->user_data_;
+}
+
 /**
  \deprecated Please use Fl_Menu_Item::setonly(Fl_Menu_Item const* first) instead.
  */
@@ -497,6 +616,9 @@ Fl_Menu_::Fl_Menu_(int X,int Y,int W,int H,const char* l)
   menu_(NULL),
   value_(NULL),
   prev_value_(NULL),
+  path_index_(NULL),
+  populate_cb_(NULL),
+  populate_data_(NULL),
   alloc(0),
   down_box_(FL_NO_BOX),
   menu_box_(FL_NO_BOX),
@@ -605,6 +727,7 @@ void Fl_Menu_::clear() {
   }
   menu_ = 0;
   value_ = prev_value_ = 0;
+  clear_path_index_();
 }
 
 /**
@@ -29,6 +29,9 @@
 #include "flstring.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // If the array is this, we will double-reallocate as necessary:
 static Fl_Menu_Item* local_array = 0;
@@ -75,6 +78,19 @@ static Fl_Menu_Item* array_insert(
 
 
 
+// Returns the item after m, skipping the contents of submenus. Unlike
+// Fl_Menu_Item::next() this doesn't skip invisible items, which would
+// also skip the visible item after an invisible one:
+static Fl_Menu_Item* next_item(Fl_Menu_Item* m) {
+  int nest = 0;
+  do {
+    if (!m->text) nest--;
+    else if (m->flags & FL_SUBMENU) nest++;
+    m++;
+  } while (nest > 0);
+  return m;
+}
+
 // Comparison that does not care about deleted '&' signs:
 static int compare(const char* a, const char* b) {
   for (;;) {
@@ -170,7 +186,7 @@ int Fl_Menu_Item::insert(
     mytext = p+1;         /* point at item title */
 
     /* find a matching menu title: */
-    for (; m->text; m = m->next())
+    for (; m->text; m = next_item(m))
       if (m->flags&FL_SUBMENU && !compare(item, m->text)) break;
 
     if (!m->text) { /* create a new menu */
@@ -186,7 +202,7 @@ int Fl_Menu_Item::insert(
   }
 
   /* find a matching menu item: */
-  for (; m->text; m = m->next())
+  for (; m->text; m = next_item(m))
     if (!(m->flags&FL_SUBMENU) && !compare(m->text,item)) break;
 
   if (!m->text) {       /* add a new menu item */
@@ -416,6 +432,7 @@ int Fl_Menu_::insert(
     }
     fl_menu_array_owner = this;
   }
+  clear_path_index_();
   int r = menu_->insert(index,label,shortcut,callback,userdata,flags);
   // if it rellocated array we must fix the pointer:
   int value_offset = (int) (value_-menu_);
@@ -461,6 +478,243 @@ int Fl_Menu_::add(const char *str) {
 
 
 
+/*
+  Fl_Menu_Builder adds many items to a menu array in one pass for
+  Fl_Menu_::add_items(). The array is parsed into a tree, and the children
+  of each submenu get a hash table that maps their labels (without '&') to
+  the first matching child, so each path is found without comparing the
+  labels of all items of a submenu, and the new array is written once.
+
+  The items are matched and added in the same way as Fl_Menu_Item::insert()
+  does with index -1: submenu titles only match submenus, items only match
+  other items, and the first match wins.
+*/
+class Fl_Menu_Builder {
+
+  struct Node {
+    Fl_Menu_Item item;                  // text and flags may be changed
+    int old_index;                      // index in the old array or -1
+    bool indexed;                       // lookup is valid
+    std::vector<int> children;
+    std::unordered_map<std::string, int> lookup; // 'S' or 'I' + label
+  };
+  std::vector<Node> nodes_;             // nodes_[0] is the top level menu
+
+  // these labeltypes don't point to a string:
+  static bool searchable(const Node &n) {
+    return n.item.labeltype_ != _FL_MULTI_LABEL && n.item.labeltype_ != _FL_IMAGE_LABEL;
+  }
+
+  static std::string key(const char *label, int flags) {
+    std::string k(1, (flags & FL_SUBMENU) ? 'S' : 'I');
+    for (; *label; label++)
+      if (*label != '&') k += *label;
+    return k;
+  }
+
+  void index(int parent) {
+    Node &p = nodes_[parent];
+    p.lookup.clear();
+    for (size_t j = 0; j < p.children.size(); j++) {
+      const Node &c = nodes_[p.children[j]];
+      if (searchable(c))
+        p.lookup.insert(std::make_pair(key(c.item.text, c.item.flags), p.children[j]));
+    }
+    p.indexed = true;
+  }
+
+  int find(int parent, const char *label, int submenu) {
+    if (!nodes_[parent].indexed) index(parent);
+    const std::unordered_map<std::string, int> &lookup = nodes_[parent].lookup;
+    std::unordered_map<std::string, int>::const_iterator it = lookup.find(key(label, submenu));
+    return it == lookup.end() ? -1 : it->second;
+  }
+
+  int add(int parent, const Fl_Menu_Item *from, int old_index) {
+    int k = (int)nodes_.size();
+    nodes_.push_back(Node());
+    Node &n = nodes_.back();
+    n.item = *from;
+    n.old_index = old_index;
+    n.indexed = false;
+    Node &p = nodes_[parent];
+    p.children.push_back(k);
+    if (p.indexed && searchable(n))
+      p.lookup.insert(std::make_pair(key(n.item.text, n.item.flags), k));
+    return k;
+  }
+
+  int add(int parent, const char *text, int flags) {
+    Fl_Menu_Item m;
+    memset(&m, 0, sizeof(m));
+    m.text = fl_strdup(text);
+    m.flags = flags;
+    m.labelfont_ = FL_HELVETICA;
+    return add(parent, &m, -1);
+  }
+
+  void write(int k, Fl_Menu_Item *array, int &pos, std::vector<int> &new_index) const {
+    const Node &n = nodes_[k];
+    if (k) {
+      new_index[k] = pos;
+      array[pos++] = n.item;
+    }
+    if (!k || (n.item.flags & FL_SUBMENU)) {
+      for (size_t j = 0; j < n.children.size(); j++)
+        write(n.children[j], array, pos, new_index);
+      pos++;                            // terminator (already cleared)
+    }
+  }
+
+public:
+
+  // Parses the menu array with n items including the final terminator
+  Fl_Menu_Builder(const Fl_Menu_Item *menu, int n) : nodes_(1) {
+    nodes_.reserve(n + 1);
+    nodes_[0].old_index = -1;
+    nodes_[0].indexed = false;
+    std::vector<int> stack(1, 0);
+    for (int i = 0; i < n - 1; i++) {
+      const Fl_Menu_Item *m = menu + i;
+      if (!m->text) {
+        if (stack.size() > 1) stack.pop_back();
+        continue;
+      }
+      int k = add(stack.back(), m, i);
+      if (m->flags & FL_SUBMENU) stack.push_back(k);
+    }
+  }
+
+  // Same as Fl_Menu_Item::insert(-1, ...), returns the node of the item
+  int insert(const char *mytext, int sc, Fl_Callback *cb, void *data, int myflags) {
+    int parent = 0;
+    int flags1 = 0;
+    std::string item;
+    // split at slashes to make submenus:
+    for (;;) {
+      // leading slash makes us assume it is a filename:
+      if (*mytext == '/') {item = mytext; break;}
+      // leading underscore causes divider line:
+      if (*mytext == '_') {mytext++; flags1 = FL_MENU_DIVIDER;}
+      // copy to item, changing \x to x:
+      item.clear();
+      const char *p;
+      for (p = mytext; *p && *p != '/'; p++) {
+        if (*p == '\\' && p[1]) p++;
+        item += *p;
+      }
+      if (*p != '/') break;             // not a menu title
+      mytext = p + 1;                   // point at item title
+      int k = find(parent, item.c_str(), FL_SUBMENU);
+      if (k < 0) k = add(parent, item.c_str(), FL_SUBMENU|flags1);
+      parent = k;                       // go into the submenu
+      flags1 = 0;
+    }
+    int k = find(parent, item.c_str(), 0);
+    if (k < 0) k = add(parent, item.c_str(), myflags|flags1);
+    Fl_Menu_Item &m = nodes_[k].item;
+    int changed = (m.flags ^ (myflags|flags1)) & FL_SUBMENU;
+    m.shortcut_ = sc;
+    m.callback_ = cb;
+    m.user_data_ = data;
+    m.flags = myflags|flags1;
+    if (changed) nodes_[parent].indexed = false;
+    return k;
+  }
+
+  // Writes the new array, new_index maps the nodes to their array index
+  Fl_Menu_Item *array(int &n, std::vector<int> &new_index) const {
+    n = 1;
+    for (size_t k = 1; k < nodes_.size(); k++)
+      n += (nodes_[k].item.flags & FL_SUBMENU) ? 2 : 1;
+    Fl_Menu_Item *array = new Fl_Menu_Item[n];
+    memset(array, 0, n * sizeof(Fl_Menu_Item));
+    new_index.assign(nodes_.size(), -1);
+    int pos = 0;
+    write(0, array, pos, new_index);
+    return array;
+  }
+
+  int old_index(int k) const { return nodes_[k].old_index; }
+  int count() const { return (int)nodes_.size(); }
+};
+
+
+/**
+  Adds many menu items at once.
+
+  Each item of \p items is added as if add() was called with its text as
+  the label (usually a menu pathname like "File/Open") and its shortcut,
+  callback, user data and flags. The other members of the items are
+  ignored, and items with a NULL text are skipped.
+
+  This is much faster than calling add() for each item of a large menu,
+  because add() searches and moves the items of the menu array for each
+  new item, whereas add_items() finds the submenus with hash tables and
+  writes the new menu array once.
+
+  \code
+    static Fl_Menu_Item items[] = {
+      { "File/&Open",     FL_COMMAND+'o', open_cb },
+      { "File/&Save",     FL_COMMAND+'s', save_cb },
+      { "_File/Save &As", 0,              saveas_cb },
+      { "File/&Quit",     FL_COMMAND+'q', quit_cb },
+      { 0 }
+    };
+    menubar->add_items(items);
+  \endcode
+
+  Since this method changes the menu array, any menu item pointers or
+  indices the application may have cached become stale.
+
+  \param[in] items    array of items with menu pathnames as their text
+  \param[in] count    number of items, or -1 if the array is terminated
+                      by an item with a NULL text
+  \returns            The index into the menu() array of the last added
+                      item, or -1 if no item was added.
+  \see add(const char*, int, Fl_Callback*, void*, int)
+*/
+int Fl_Menu_::add_items(const Fl_Menu_Item *items, int count) {
+  if (!items) return -1;
+  if (count < 0)
+    for (count = 0; items[count].text; count++) { /* empty */ }
+  if (this == fl_menu_array_owner)
+    menu_end();                         // stop using the local array
+  int old_size = size();
+  Fl_Menu_Builder builder(menu_, old_size);
+  int last = -1;
+  for (int i = 0; i < count; i++) {
+    const Fl_Menu_Item &m = items[i];
+    if (m.text)
+      last = builder.insert(m.text, m.shortcut_, m.callback_, m.user_data_, m.flags);
+  }
+  if (last < 0) return -1;
+  int n;
+  std::vector<int> new_index;
+  Fl_Menu_Item *array = builder.array(n, new_index);
+  // remap the pointers to items of the old array:
+  std::vector<int> old_to_new(old_size, -1);
+  for (int k = 1; k < builder.count(); k++)
+    if (builder.old_index(k) >= 0) old_to_new[builder.old_index(k)] = new_index[k];
+  const Fl_Menu_Item *old_menu = menu_;
+  const Fl_Menu_Item *value = value_;
+  const Fl_Menu_Item *prev_value = prev_value_;
+  if (value >= old_menu && value < old_menu + old_size)
+    value = old_to_new[value - old_menu] < 0 ? 0 : array + old_to_new[value - old_menu];
+  if (prev_value >= old_menu && prev_value < old_menu + old_size)
+    prev_value = old_to_new[prev_value - old_menu] < 0 ? 0 : array + old_to_new[prev_value - old_menu];
+  // take over the new array, the strings are kept:
+  if (alloc) delete[] menu_;
+  if (!menu_) alloc = 2;                // all strings were created here
+  else if (!alloc) alloc = 1;           // the old strings are not ours
+  menu_ = array;
+  value_ = value;
+  prev_value_ = prev_value;
+  clear_path_index_();
+  return new_index[last];
+}
+
+
 /**
   Changes the text of item \p i.  This is the only way to get
   slash into an add()'ed menu item.  If the menu array was directly set
@@ -472,6 +726,7 @@ int Fl_Menu_::add(const char *str) {
 void Fl_Menu_::replace(int i, const char *str) {
   if (i<0 || i>=size()) return;
   if (!alloc) copy(menu_);
+  clear_path_index_();
   if (alloc > 1) {
     free((void *)menu_[i].text);
       str = fl_strdup(str?str:"");
@@ -493,6 +748,7 @@ void Fl_Menu_::remove(int i) {
   int n = size();
   if (i<0 || i>=n) return;
   if (!alloc) copy(menu_);
+  clear_path_index_();
   // find the next item, skipping submenus:
   Fl_Menu_Item* item = menu_+i;
   const Fl_Menu_Item* next_item = item->next();
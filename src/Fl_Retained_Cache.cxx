@@ -0,0 +1,142 @@
+//
+// Retained drawing of widgets for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Retained_Cache.H"
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Image_Surface.H>
+#include <FL/Fl_Graphics_Driver.H>
+#include <FL/fl_draw.H>
+
+#include <map>
+#include <vector>
+
+Fl_Retained_Tiles::Fl_Retained_Tiles()
+: w(0), h(0), scale(0), cols(0), rows(0), c0(0), c1(-1), r0(0), r1(-1) { }
+
+Fl_Retained_Tiles::~Fl_Retained_Tiles() {
+  clear();
+}
+
+// Deletes all tiles
+void Fl_Retained_Tiles::clear() {
+  for (size_t i = 0; i < tiles.size(); i++)
+    delete tiles[i].surface;
+  tiles.clear();
+  w = h = cols = rows = 0;
+}
+
+// Deletes all tiles if the size or scale changed, returns 1 if it did
+int Fl_Retained_Tiles::resize(int W, int H, float s) {
+  if (W == w && H == h && s == scale)
+    return 0;
+  clear();
+  w = W; h = H; scale = s;
+  cols = (W + TILE_SIZE - 1) / TILE_SIZE;
+  rows = (H + TILE_SIZE - 1) / TILE_SIZE;
+  Tile empty = { NULL, false };
+  tiles.assign(cols * rows, empty);
+  return 1;
+}
+
+/*
+  Finds the tiles that intersect the visible area X,Y,W,H (relative to the
+  widget) and returns the damage bits to draw them with, 0 if the valid
+  visible tiles can be copied. With damage all hidden tiles become invalid.
+*/
+uchar Fl_Retained_Tiles::damage(uchar d, int X, int Y, int W, int H) {
+  if (d & FL_DAMAGE_SCROLL) d = FL_DAMAGE_ALL;
+  c0 = 0; c1 = -1; r0 = 0; r1 = -1;
+  if (W > 0 && H > 0) {
+    c0 = X / TILE_SIZE; c1 = (X + W - 1) / TILE_SIZE;
+    r0 = Y / TILE_SIZE; r1 = (Y + H - 1) / TILE_SIZE;
+  }
+  if (d && (c1 > c0 || r1 > r0)) d = FL_DAMAGE_ALL;
+  if (d) {
+    for (int r = 0; r < rows; r++)
+      for (int c = 0; c < cols; c++)
+        if (!visible(r, c)) tile(r, c).valid = false;
+  }
+  return d;
+}
+
+static std::map<const Fl_Widget*, Fl_Retained_Tiles*> caches;
+
+// Draws widget w with damage bits d into tile t at X,Y (window coordinates)
+static void draw_tile(Fl_Widget &w, Fl_Retained_Tiles::Tile &t, int X, int Y, int W, int H, uchar d) {
+  if (!t.surface) {
+    t.surface = new Fl_Image_Surface(W, H, 1);
+    d = FL_DAMAGE_ALL;
+  }
+  Fl_Widget_Surface *surface = t.surface; // translate() is public here
+  Fl_Surface_Device::push_current(surface);
+  surface->translate(-X, -Y);
+  fl_push_clip(X, Y, W, H);
+  if (d & FL_DAMAGE_ALL) {
+    // parts of the widget that are not drawn show the color of the parent
+    fl_color(w.parent() ? w.parent()->color() : FL_BACKGROUND_COLOR);
+    fl_rectf(X, Y, W, H);
+  }
+  w.clear_damage(d);
+  w.draw();
+  fl_pop_clip();
+  surface->untranslate();
+  Fl_Surface_Device::pop_current();
+  t.valid = true;
+}
+
+int Fl_Retained_Cache::draw(Fl_Widget &w) {
+  // printers get the widget itself
+  if (fl_graphics_driver->has_feature(Fl_Graphics_Driver::PRINTER))
+    return 0;
+  if (w.w() <= 0 || w.h() <= 0)
+    return 0;
+
+  Fl_Retained_Tiles *&c = caches[&w];
+  if (!c) c = new Fl_Retained_Tiles;
+  c->resize(w.w(), w.h(), fl_graphics_driver->scale());
+
+  int X, Y, W, H;
+  fl_clip_box(w.x(), w.y(), w.w(), w.h(), X, Y, W, H);
+  uchar d = c->damage(w.damage(), X - w.x(), Y - w.y(), W, H);
+
+  const int TILE_SIZE = Fl_Retained_Tiles::TILE_SIZE;
+  for (int r = c->r0; r <= c->r1; r++) {
+    for (int col = c->c0; col <= c->c1; col++) {
+      Fl_Retained_Tiles::Tile &t = c->tile(r, col);
+      int tx = w.x() + col * TILE_SIZE, ty = w.y() + r * TILE_SIZE;
+      int tw = w.w() - col * TILE_SIZE, th = w.h() - r * TILE_SIZE;
+      if (tw > TILE_SIZE) tw = TILE_SIZE;
+      if (th > TILE_SIZE) th = TILE_SIZE;
+      if (!t.valid)
+        draw_tile(w, t, tx, ty, tw, th, FL_DAMAGE_ALL);
+      else if (d)
+        draw_tile(w, t, tx, ty, tw, th, d);
+      // copy the visible part of the tile
+      int x0 = X > tx ? X : tx, y0 = Y > ty ? Y : ty;
+      int x1 = X + W < tx + tw ? X + W : tx + tw;
+      int y1 = Y + H < ty + th ? Y + H : ty + th;
+      fl_copy_offscreen(x0, y0, x1 - x0, y1 - y0, t.surface->offscreen(), x0 - tx, y0 - ty);
+    }
+  }
+  return 1;
+}
+
+void Fl_Retained_Cache::remove(const Fl_Widget *w) {
+  std::map<const Fl_Widget*, Fl_Retained_Tiles*>::iterator it = caches.find(w);
+  if (it == caches.end()) return;
+  delete it->second;
+  caches.erase(it);
+}
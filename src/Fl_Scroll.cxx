@@ -18,6 +18,8 @@
 #include <FL/Fl_Tiled_Image.H>
 #include <FL/Fl_Scroll.H>
 #include <FL/fl_draw.H>
+#include "Fl_Group_Index.H"
+#include "Fl_Scroll_Offsets.H"
 
 /** Clear all but the scrollbars... */
 void Fl_Scroll::clear() {
@@ -41,6 +43,8 @@ void Fl_Scroll::clear() {
 Fl_Scroll::~Fl_Scroll() {
   remove(hscrollbar); // remove last child first
   remove(scrollbar);
+  delete offsets_;
+  offsets_ = 0;
 }
 
 /** Ensure the scrollbars are the last children.
@@ -100,6 +104,8 @@ int Fl_Scroll::on_insert(Fl_Widget *candidate, int index) {
       candidate != &scrollbar && candidate != &hscrollbar) {
     index = children() - 2;
   }
+  if (offsets_ && candidate != &scrollbar && candidate != &hscrollbar)
+    offsets_->inserted(candidate);
   return index;
 }
 
@@ -117,7 +123,45 @@ int Fl_Scroll::on_insert(Fl_Widget *candidate, int index) {
  \return new index, possibly corrected to avoid last two scrollbar entries
  */
 int Fl_Scroll::on_move(int old_index, int new_index) {
-  return on_insert(child(old_index), new_index);
+  if (children() > 1 && new_index > children() - 2 &&
+      child(old_index) != &scrollbar && child(old_index) != &hscrollbar) {
+    new_index = children() - 2;
+  }
+  if (offsets_) offsets_->reordered();
+  return new_index;
+}
+
+/**
+  Updates the data of offset scrolling before a child is removed.
+
+  \param[in] index  index of the child that will be removed
+
+  \see Fl_Group::on_remove(int)
+*/
+void Fl_Scroll::on_remove(int index) {
+  if (offsets_) offsets_->removed(child(index));
+  Fl_Group::on_remove(index);
+}
+
+/**
+  Resets the data of offset scrolling before all children are deleted.
+
+  \see Fl_Group::on_clear()
+*/
+void Fl_Scroll::on_clear() {
+  if (offsets_) offsets_->cleared();
+}
+
+/**
+  Updates the data of offset scrolling after a child was resized.
+
+  \param[in] o  the child that was resized
+
+  \see Fl_Group::on_child_resize(Fl_Widget*)
+*/
+void Fl_Scroll::on_child_resize(Fl_Widget *o) {
+  if (offsets_) offsets_->resized(o);
+  Fl_Group::on_child_resize(o);
 }
 
 /**
@@ -168,11 +212,22 @@ void Fl_Scroll::draw_clip(void* v,int X, int Y, int W, int H) {
   }
 
   // draw visible children
-  Fl_Widget*const* a = s->array();
-  for (int i=s->children()-2; i--;) {
-    Fl_Widget& o = **a++;
-    s->draw_child(o);
-    s->draw_outside_label(o);
+  if (s->spatial_index_) {
+    std::vector<int> found;
+    s->spatial_index_->find_clipped(found);
+    for (size_t i = 0; i < found.size(); i++) {
+      Fl_Widget& o = *s->child(found[i]);
+      if (&o == &s->scrollbar || &o == &s->hscrollbar) continue;
+      s->draw_child(o);
+      s->draw_outside_label(o);
+    }
+  } else {
+    Fl_Widget*const* a = s->array();
+    for (int i=s->children()-2; i--;) {
+      Fl_Widget& o = **a++;
+      s->draw_child(o);
+      s->draw_outside_label(o);
+    }
   }
   fl_pop_clip();
 }
@@ -203,24 +258,30 @@ void Fl_Scroll::recalc_scrollbars(ScrollInfo &si) const {
   // start with top left corner, zero width, zero height
   si.child = Fl_Rect(si.innerbox.x(), si.innerbox.y(), 0, 0);
 
-  int first = 1;
-  Fl_Widget*const* a = array();
-  for (int i = children(); i--;) {
-    Fl_Widget* o = *a++;
-    if (o == &scrollbar || o == &hscrollbar || o->visible() == 0)
-      continue;
-    if (first) {
-      first = 0;
-      si.child = Fl_Rect(o);
-    } else {
-      if (o->x() < si.child.x())
-        si.child.x(o->x());
-      if (o->y() < si.child.y())
-        si.child.y(o->y());
-      if (o->x() + o->w() > si.child.r())
-        si.child.r(o->x() + o->w());
-      if (o->y() + o->h() > si.child.b())
-        si.child.b(o->y() + o->h());
+  if (offsets_) { // offset scrolling caches the bounding box
+    int X, Y, W, H;
+    if (offsets_->bounds(X, Y, W, H))
+      si.child = Fl_Rect(X, Y, W, H);
+  } else {
+    int first = 1;
+    Fl_Widget*const* a = array();
+    for (int i = children(); i--;) {
+      Fl_Widget* o = *a++;
+      if (o == &scrollbar || o == &hscrollbar || o->visible() == 0)
+        continue;
+      if (first) {
+        first = 0;
+        si.child = Fl_Rect(o);
+      } else {
+        if (o->x() < si.child.x())
+          si.child.x(o->x());
+        if (o->y() < si.child.y())
+          si.child.y(o->y());
+        if (o->x() + o->w() > si.child.r())
+          si.child.r(o->x() + o->w());
+        if (o->y() + o->h() > si.child.b())
+          si.child.b(o->y() + o->h());
+      }
     }
   }
 
@@ -358,11 +419,18 @@ void Fl_Scroll::draw() {
       R = 0;
       T = 999999;
       B = 0;
-      for (int i=children()-2; i--; a++) {
-        if ((*a)->x() < L) L = (*a)->x();
-        if (((*a)->x() + (*a)->w()) > R) R = (*a)->x() + (*a)->w();
-        if ((*a)->y() < T) T = (*a)->y();
-        if (((*a)->y() + (*a)->h()) > B) B = (*a)->y() + (*a)->h();
+      if (offsets_) { // cached bounding box of the visible children
+        if (offsets_->bounds(L, T, R, B)) {
+          R += L;
+          B += T;
+        }
+      } else {
+        for (int i=children()-2; i--; a++) {
+          if ((*a)->x() < L) L = (*a)->x();
+          if (((*a)->x() + (*a)->w()) > R) R = (*a)->x() + (*a)->w();
+          if ((*a)->y() < T) T = (*a)->y();
+          if (((*a)->y() + (*a)->h()) > B) B = (*a)->y() + (*a)->h();
+        }
       }
       if (L > X) draw_clip(this, X, Y, L - X, H);
       if (R < (X + W)) draw_clip(this, R, Y, X + W - R, H);
@@ -371,8 +439,17 @@ void Fl_Scroll::draw() {
     }
     if (d & FL_DAMAGE_CHILD) { // draw damaged children
       fl_push_clip(X, Y, W, H);
-      Fl_Widget*const* a = array();
-      for (int i=children()-2; i--;) update_child(**a++);
+      if (spatial_index_) {
+        std::vector<int> found;
+        spatial_index_->find_clipped(found);
+        for (size_t i = 0; i < found.size(); i++) {
+          Fl_Widget* o = child(found[i]);
+          if (o != &scrollbar && o != &hscrollbar) update_child(*o);
+        }
+      } else {
+        Fl_Widget*const* a = array();
+        for (int i=children()-2; i--;) update_child(**a++);
+      }
       fl_pop_clip();
     }
   }
@@ -459,12 +536,15 @@ void Fl_Scroll::resize(int X, int Y, int W, int H) {
   int dw = W-w(), dh = H-h();
   Fl_Widget::resize(X,Y,W,H); // resize _before_ moving children around
   fix_scrollbar_order();
+  if (offsets_) offsets_->place_all();
+  if (spatial_index_) spatial_index_->invalidate();
   // move all the children:
   Fl_Widget*const* a = array();
   for (int i=children()-2; i--;) {
     Fl_Widget* o = *a++;
     o->position(o->x()+dx, o->y()+dy);
   }
+  if (offsets_) offsets_->reset();
   if (dw==0 && dh==0) {
     char pad = ( scrollbar.visible() && hscrollbar.visible() );
     char al = ( (scrollbar.align() & FL_ALIGN_LEFT) != 0 );
@@ -499,16 +579,64 @@ void Fl_Scroll::scroll_to(int X, int Y) {
   if (!dx && !dy) return;
   xposition_ = X;
   yposition_ = Y;
-  Fl_Widget*const* a = array();
-  for (int i=children(); i--;) {
-    Fl_Widget* o = *a++;
-    if (o == &hscrollbar || o == &scrollbar) continue;
-    o->position(o->x()+dx, o->y()+dy);
+  if (offsets_) {
+    offsets_->scroll(dx, dy);
+  } else {
+    if (spatial_index_) spatial_index_->invalidate();
+    Fl_Widget*const* a = array();
+    for (int i=children(); i--;) {
+      Fl_Widget* o = *a++;
+      if (o == &hscrollbar || o == &scrollbar) continue;
+      o->position(o->x()+dx, o->y()+dy);
+    }
   }
   if (parent() == (Fl_Group *)window() && Fl::scheme_bg_) damage(FL_DAMAGE_ALL);
   else damage(FL_DAMAGE_SCROLL);
 }
 
+/**
+  Turns offset scrolling on or off.
+
+  Normally scroll_to() moves all children of the Fl_Scroll to their new
+  positions, and drawing calculates the bounding box of all children.
+  With many children this makes scrolling slow, even if only a few of
+  them are visible.
+
+  With offset scrolling the Fl_Scroll remembers the position of every
+  child relative to the scrolled contents and only moves the children
+  that are inside the scroll area before or after scrolling. The time for
+  a scroll step then depends on the number of visible children only. The
+  bounding box of the children is cached. Offset scrolling also turns on
+  the spatial index of the group, see Fl_Group::spatial_index(int).
+
+  \note The x() and y() of children that are outside of the scroll area
+    are not updated while scrolling. They are updated when the child is
+    scrolled into view, and all children are moved to their correct
+    positions when offset scrolling is turned off. To move a child, set
+    its position like without offset scrolling, i.e. relative to the
+    current scroll position:
+  \code
+    o->position(scroll->x() - scroll->xposition() + X,
+                scroll->y() - scroll->yposition() + Y);
+  \endcode
+    Changing only the size of a child that is out of view is fine.
+
+  \param[in] on  1 to turn offset scrolling on, 0 to turn it off
+
+  \since 1.5.0
+*/
+void Fl_Scroll::offset_scrolling(int on) {
+  if (on && !offsets_) {
+    spatial_index(1);
+    offsets_ = new Fl_Scroll_Offsets(this);
+    offsets_->reset();
+  } else if (!on && offsets_) {
+    offsets_->place_all();
+    delete offsets_;
+    offsets_ = 0;
+  }
+}
+
 void Fl_Scroll::hscrollbar_cb(Fl_Widget* o, void*) {
   Fl_Scroll* s = (Fl_Scroll*)(o->parent());
   s->scroll_to(int(((Fl_Scrollbar*)o)->value()), s->yposition());
@@ -532,6 +660,7 @@ void Fl_Scroll::scrollbar_cb(Fl_Widget* o, void*) {
 */
 Fl_Scroll::Fl_Scroll(int X, int Y, int W, int H, const char *L)
   : Fl_Group(X, Y, W, H, L),
+    offsets_(0),
     scrollbar(X+W-Fl::scrollbar_size(),Y,
               Fl::scrollbar_size(),H-Fl::scrollbar_size()),
     hscrollbar(X,Y+H-Fl::scrollbar_size(),
@@ -0,0 +1,226 @@
+//
+// Offset scrolling of Fl_Scroll for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Scroll_Offsets.H"
+#include <FL/Fl_Scroll.H>
+
+#include <algorithm>
+
+Fl_Scroll_Offsets::Index::Index(Fl_Scroll *s, const Fl_Scroll_Offsets *offsets)
+  : Fl_Group_Index(s), offsets_(offsets) {
+}
+
+void Fl_Scroll_Offsets::Index::position(const Fl_Widget *o, int &X, int &Y) const {
+  offsets_->logical_position(o, X, Y);
+}
+
+Fl_Scroll_Offsets::Fl_Scroll_Offsets(Fl_Scroll *s)
+  : scroll_(s), index_(s, this), dx_(0), dy_(0), placing_(false),
+    bounds_valid_(false), bounds_empty_(true), bx_(0), by_(0), br_(0), bb_(0) {
+}
+
+// Returns true for children other than the scrollbars
+bool Fl_Scroll_Offsets::content(const Fl_Widget *o) const {
+  return o != &scroll_->scrollbar && o != &scroll_->hscrollbar;
+}
+
+// Returns true if child o is inside the scroll area at its current x() and y()
+bool Fl_Scroll_Offsets::inside(const Fl_Widget *o) const {
+  return o->x() < scroll_->x() + scroll_->w() && o->x() + std::max(o->w(), 1) > scroll_->x() &&
+         o->y() < scroll_->y() + scroll_->h() && o->y() + std::max(o->h(), 1) > scroll_->y();
+}
+
+// Returns the position of child o at offset 0
+void Fl_Scroll_Offsets::logical_position(const Fl_Widget *o, int &X, int &Y) const {
+  std::unordered_map<const Fl_Widget*, Stamp>::const_iterator it = stamps_.find(o);
+  if (it == stamps_.end()) {
+    X = o->x() - dx_;
+    Y = o->y() - dy_;
+  } else {
+    X = o->x() - it->second.dx;
+    Y = o->y() - it->second.dy;
+  }
+}
+
+// Moves child o to its correct position at the current offset
+void Fl_Scroll_Offsets::place(Fl_Widget *o) {
+  std::unordered_map<const Fl_Widget*, Stamp>::iterator it = stamps_.find(o);
+  if (it == stamps_.end()) {
+    Stamp s = { dx_, dy_, o->x(), o->y(), false };
+    stamps_[o] = s;
+    return;
+  }
+  Stamp &s = it->second;
+  if (s.dx == dx_ && s.dy == dy_) return;
+  int X = o->x() + dx_ - s.dx;
+  int Y = o->y() + dy_ - s.dy;
+  s.dx = dx_;
+  s.dy = dy_;
+  s.x = X;
+  s.y = Y;
+  o->position(X, Y);
+}
+
+void Fl_Scroll_Offsets::map(Fl_Widget *o, Stamp &s) {
+  if (s.mapped) return;
+  s.mapped = true;
+  mapped_.push_back(o);
+}
+
+// Moves all children to their correct positions
+void Fl_Scroll_Offsets::place_all() {
+  placing_ = true;
+  for (int i = 0; i < scroll_->children(); i++) {
+    Fl_Widget *o = scroll_->child(i);
+    if (content(o)) place(o);
+  }
+  placing_ = false;
+  index_.invalidate();
+}
+
+// All children are at their correct positions, maybe after they were
+// moved by Fl_Scroll::resize(): starts again at offset 0
+void Fl_Scroll_Offsets::reset() {
+  place_all();
+  dx_ = dy_ = 0;
+  stamps_.clear();
+  mapped_.clear();
+  for (int i = 0; i < scroll_->children(); i++) {
+    Fl_Widget *o = scroll_->child(i);
+    if (!content(o)) continue;
+    Stamp s = { 0, 0, o->x(), o->y(), false };
+    Stamp &t = stamps_[o] = s;
+    if (inside(o)) map(o, t);
+  }
+  index_.invalidate();
+  bounds_valid_ = false;
+}
+
+// The contents were scrolled by dx, dy: moves only the children
+// inside the scroll area before and after scrolling
+void Fl_Scroll_Offsets::scroll(int dx, int dy) {
+  dx_ += dx;
+  dy_ += dy;
+  placing_ = true;
+  std::vector<Fl_Widget*> old;
+  old.swap(mapped_);
+  for (size_t i = 0; i < old.size(); i++) {
+    stamps_[old[i]].mapped = false;
+    place(old[i]);
+  }
+  std::vector<int> found;
+  index_.find(scroll_->x() - dx_, scroll_->y() - dy_, scroll_->w(), scroll_->h(), found);
+  for (size_t i = 0; i < found.size(); i++) {
+    Fl_Widget *o = scroll_->child(found[i]);
+    if (!content(o)) continue;
+    place(o);
+    map(o, stamps_[o]);
+  }
+  placing_ = false;
+}
+
+// Child o is about to be added at its correct position
+void Fl_Scroll_Offsets::inserted(Fl_Widget *o) {
+  Stamp s = { dx_, dy_, o->x(), o->y(), false };
+  Stamp &t = stamps_[o] = s;
+  if (inside(o)) map(o, t);
+  index_.invalidate();
+  bounds_valid_ = false;
+}
+
+// Child o is about to be removed, it leaves at its correct position
+void Fl_Scroll_Offsets::removed(Fl_Widget *o) {
+  std::unordered_map<const Fl_Widget*, Stamp>::iterator it = stamps_.find(o);
+  if (it == stamps_.end()) return;
+  placing_ = true;
+  place(o);
+  placing_ = false;
+  if (it->second.mapped)
+    mapped_.erase(std::find(mapped_.begin(), mapped_.end(), o));
+  stamps_.erase(it);
+  index_.invalidate();
+  bounds_valid_ = false;
+}
+
+// All children except the scrollbars are about to be deleted
+void Fl_Scroll_Offsets::cleared() {
+  stamps_.clear();
+  mapped_.clear();
+  index_.invalidate();
+  bounds_valid_ = false;
+}
+
+// The order of the children changed
+void Fl_Scroll_Offsets::reordered() {
+  index_.invalidate();
+}
+
+// Child o was resized by other code than place(). If its position
+// changed, the new position is the correct one at the current offset.
+void Fl_Scroll_Offsets::resized(Fl_Widget *o) {
+  if (placing_ || !content(o)) return;
+  std::unordered_map<const Fl_Widget*, Stamp>::iterator it = stamps_.find(o);
+  if (it == stamps_.end()) return;
+  Stamp &s = it->second;
+  if (o->x() != s.x || o->y() != s.y) {
+    s.dx = dx_;
+    s.dy = dy_;
+    s.x = o->x();
+    s.y = o->y();
+    if (inside(o)) map(o, s);
+  }
+  index_.moved(o);
+  bounds_valid_ = false;
+}
+
+/*
+  Returns the bounding box of the visible children at the current offset.
+  Returns false if no child is visible.
+*/
+bool Fl_Scroll_Offsets::bounds(int &X, int &Y, int &W, int &H) {
+  if (bounds_valid_) {
+    for (int i = 0; i < 4 && bounds_valid_; i++)
+      if (!edges_[i]->visible()) bounds_valid_ = false;
+    for (size_t i = 0; i < hidden_.size() && bounds_valid_; i++)
+      if (hidden_[i]->visible()) bounds_valid_ = false;
+  }
+  if (!bounds_valid_) {
+    bounds_empty_ = true;
+    hidden_.clear();
+    for (int i = 0; i < scroll_->children(); i++) {
+      const Fl_Widget *o = scroll_->child(i);
+      if (!content(o)) continue;
+      if (!o->visible()) {
+        hidden_.push_back(o);
+        continue;
+      }
+      int L, T;
+      logical_position(o, L, T);
+      if (bounds_empty_ || L < bx_) { bx_ = L; edges_[0] = o; }
+      if (bounds_empty_ || T < by_) { by_ = T; edges_[1] = o; }
+      if (bounds_empty_ || L + o->w() > br_) { br_ = L + o->w(); edges_[2] = o; }
+      if (bounds_empty_ || T + o->h() > bb_) { bb_ = T + o->h(); edges_[3] = o; }
+      bounds_empty_ = false;
+    }
+    bounds_valid_ = !bounds_empty_;
+  }
+  if (bounds_empty_) return false;
+  X = bx_ + dx_;
+  Y = by_ + dy_;
+  W = br_ - bx_;
+  H = bb_ - by_;
+  return true;
+}
@@ -23,6 +23,7 @@
 #include "Fl_System_Driver.H"
 #include "Fl_Private.H"
 #include "Fl_Timeout.h"
+#include "Fl_Event_Stats_Scope.H"
 #include <FL/Fl_File_Icon.H>
 #include <FL/fl_utf8.h>
 #include <stdlib.h>
@@ -354,7 +355,10 @@ void Fl_System_Driver::gettime(time_t *sec, int *usec) {
 double Fl_System_Driver::wait(double time_to_wait) {
 
   // delete all widgets that were listed during callbacks
-  Fl::do_widget_deletion();
+  {
+    FL_EVENT_STATS_SCOPE(WIDGET_DELETION, 0);
+    Fl::do_widget_deletion();
+  }
 
   Fl_Timeout::do_timeouts();
   Fl::Private::run_checks();
@@ -19,6 +19,7 @@
 #include <FL/Fl_Table.H>
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
+#include "Fl_Table_Sizes.H"
 
 #include <sys/types.h>
 #include <string.h>             // memcpy
@@ -40,7 +41,7 @@ void Fl_Table::row_position(int row) {
   }
   vscrollbar->Fl_Slider::value(newtop);
   table_scrolled();
-  redraw();
+  damage(FL_DAMAGE_SCROLL);
   _row_position = row;  // HACK: override what table_scrolled() came up with
 }
 
@@ -59,7 +60,7 @@ void Fl_Table::col_position(int col) {
   }
   hscrollbar->Fl_Slider::value(newleft);
   table_scrolled();
-  redraw();
+  damage(FL_DAMAGE_SCROLL);
   _col_position = col;  // HACK: override what table_scrolled() came up with
 }
 
@@ -67,38 +68,14 @@ void Fl_Table::col_position(int col) {
   Returns the scroll position (in pixels) of the specified 'row'.
 */
 long Fl_Table::row_scroll_position(int row) {
-  int startrow = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( toprow_scrollpos != -1 && row >= toprow ) {
-    scroll = toprow_scrollpos;
-    startrow = toprow;
-  }
-  for ( int t=startrow; t<row; t++ ) {
-    scroll += row_height(t);
-  }
-  return(scroll);
+  return _rowheights->position(row);
 }
 
 /**
   Returns the scroll position (in pixels) of the specified column 'col'.
 */
 long Fl_Table::col_scroll_position(int col) {
-  int startcol = 0;
-  long scroll = 0;
-  // OPTIMIZATION:
-  //     Attempt to use precomputed row scroll position
-  //
-  if ( leftcol_scrollpos != -1 && col >= leftcol ) {
-    scroll = leftcol_scrollpos;
-    startcol = leftcol;
-  }
-  for ( int t=startcol; t<col; t++ ) {
-    scroll += col_width(t);
-  }
-  return(scroll);
+  return _colwidths->position(col);
 }
 
 /**
@@ -136,6 +113,9 @@ Fl_Table::Fl_Table(int X, int Y, int W, int H, const char *l) : Fl_Group(X,Y,W,H
   _resizing_row     = -1;
   _dragging_x       = -1;
   _dragging_y       = -1;
+  _drawn_hpos       = 0;
+  _drawn_vpos       = 0;
+  _drawn_tix = _drawn_tiy = _drawn_tiw = _drawn_tih = -1;
   _last_row         = -1;
   _auto_drag        = 0;
   current_col       = -1;
@@ -144,9 +124,11 @@ Fl_Table::Fl_Table(int X, int Y, int W, int H, const char *l) : Fl_Group(X,Y,W,H
   select_col        = -1;
   _scrollbar_size   = 0;
   flags_            = 0;        // TABCELLNAV off
+  _update_depth     = 0;
+  _resize_pending   = 0;
 
-  _colwidths        = new std::vector<int>;  // column widths in pixels
-  _rowheights       = new std::vector<int>;  // row heights in pixels
+  _colwidths        = new Fl_Table_Sizes;  // column widths in pixels
+  _rowheights       = new Fl_Table_Sizes;  // row heights in pixels
 
   box(FL_THIN_DOWN_FRAME);
 
@@ -189,23 +171,23 @@ Fl_Table::~Fl_Table() {
 /**
   Returns the current number of columns.
 
-  This is equivalent to the size of the column widths vector.
+  This is equivalent to the number of column widths.
 
   \returns Number of columns.
 */
 int Fl_Table::col_size() {
-  return int(_colwidths->size());
+  return _colwidths->count();
 }
 
 /**
   Returns the current number of rows.
 
-  This is equivalent to the size of the row heights vector.
+  This is equivalent to the number of row heights.
 
   \returns Number of rows.
 */
 int Fl_Table::row_size() {
-  return int(_rowheights->size());
+  return _rowheights->count();
 }
 
 /**
@@ -216,15 +198,15 @@ int Fl_Table::row_size() {
 */
 void Fl_Table::row_height(int row, int height) {
   if ( row < 0 ) return;
-  if ( row < row_size() && (*_rowheights)[row] == height ) {
+  if ( row < row_size() && _rowheights->size(row) == height ) {
     return;             // OPTIMIZATION: no change? avoid redraw
   }
   // Add row heights, even if none yet
   int now_size = row_size();
   if (row >= now_size) {
-    _rowheights->resize(row, height);
+    _rowheights->resize(row+1, height);
   }
-  (*_rowheights)[row] = height;
+  _rowheights->size(row, height);
   table_resized();
   if ( row <= botrow ) {        // OPTIMIZATION: only redraw if onscreen or above screen
     redraw();
@@ -243,7 +225,7 @@ void Fl_Table::row_height(int row, int height) {
 void Fl_Table::col_width(int col, int width)
 {
   if ( col < 0 ) return;
-  if ( col < col_size() && (*_colwidths)[col] == width ) {
+  if ( col < col_size() && _colwidths->size(col) == width ) {
     return;                     // OPTIMIZATION: no change? avoid redraw
   }
   // Add column widths, even if none yet
@@ -251,7 +233,7 @@ void Fl_Table::col_width(int col, int width)
   if ( col >= now_size ) {
     _colwidths->resize(col+1, width);
   }
-  (*_colwidths)[col] = width;
+  _colwidths->size(col, width);
   table_resized();
   if ( col <= rightcol ) {      // OPTIMIZATION: only redraw if onscreen or to the left
     redraw();
@@ -563,38 +545,28 @@ void Fl_Table::recalc_dimensions() {
   TODO: Assumes ti[xywh] has already been recalculated.
 */
 void Fl_Table::table_scrolled() {
-  // Find top row
-  int y, row, voff = vscrollbar->value();
-  for ( row=y=0; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y > voff ) { y -= row_height(row); break; }
-  }
+  // Find top row: the first row whose bottom edge is below the scroll position
+  long voff = (long)vscrollbar->value();
+  int row = _rowheights->find(voff);
+  if ( row > _rows ) row = _rows;
   _row_position = toprow = ( row >= _rows ) ? (row - 1) : row;
-  toprow_scrollpos = y;         // OPTIMIZATION: save for later use
-  // Find bottom row
-  voff = vscrollbar->value() + tih;
-  for ( ; row < _rows; row++ ) {
-    y += row_height(row);
-    if ( y >= voff ) { break; }
-  }
+  toprow_scrollpos = (int)row_scroll_position(row);   // OPTIMIZATION: save for later use
+  // Find bottom row: the first row whose bottom edge reaches the window bottom
+  row = _rowheights->find(voff + tih - 1);
+  if ( row > _rows ) row = _rows;
   botrow = ( row >= _rows ) ? (row - 1) : row;
+  if ( botrow < toprow ) botrow = toprow;
   // Left column
-  int x, col, hoff = hscrollbar->value();
-  for ( col=x=0; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x > hoff ) { x -= col_width(col); break; }
-  }
+  long hoff = (long)hscrollbar->value();
+  int col = _colwidths->find(hoff);
+  if ( col > _cols ) col = _cols;
   _col_position = leftcol = ( col >= _cols ) ? (col - 1) : col;
-  leftcol_scrollpos = x;        // OPTIMIZATION: save for later use
+  leftcol_scrollpos = (int)col_scroll_position(col);  // OPTIMIZATION: save for later use
   // Right column
-  //    Work with data left over from leftcol calculation
-  //
-  hoff = hscrollbar->value() + tiw;
-  for ( ; col < _cols; col++ ) {
-    x += col_width(col);
-    if ( x >= hoff ) { break; }
-  }
+  col = _colwidths->find(hoff + tiw - 1);
+  if ( col > _cols ) col = _cols;
   rightcol = ( col >= _cols ) ? (col - 1) : col;
+  if ( rightcol < leftcol ) rightcol = leftcol;
   // First tell children to scroll
   draw_cell(CONTEXT_RC_RESIZE, 0,0,0,0,0,0);
 }
@@ -604,6 +576,11 @@ void Fl_Table::table_scrolled() {
   Calls recall_dimensions(), and recalculates scrollbar sizes.
 */
 void Fl_Table::table_resized() {
+  if ( _update_depth > 0 ) {    // OPTIMIZATION: recalc once in end_update()
+    _resize_pending = 1;
+    return;
+  }
+  _resize_pending = 0;
   table_h = (int)row_scroll_position(rows());
   table_w = (int)col_scroll_position(cols());
   recalc_dimensions();
@@ -643,6 +620,87 @@ void Fl_Table::table_resized() {
   // redraw();
 }
 
+/**
+  Starts a batch of changes to the table's size.
+
+  Until the matching end_update(), changes of rows(), cols(), row_height(),
+  col_width() etc. don't recalculate the table's dimensions and scrollbars,
+  which is done once by end_update(). Calls can be nested.
+
+  Use this when changing the sizes of many rows or columns individually:
+  \code
+    table->begin_update();
+    for (int r = 0; r < table->rows(); r++)
+      table->row_height(r, compute_height(r));
+    table->end_update();
+  \endcode
+
+  Note that toprow/botrow/leftcol/rightcol and the scrollbars are not
+  updated until end_update().
+  \see end_update(), updating()
+*/
+void Fl_Table::begin_update() {
+  _update_depth++;
+}
+
+/**
+  Ends a batch of changes started with begin_update().
+
+  If this ends the outermost batch and any change affected the table's
+  dimensions, table_resized() is called and the table is redrawn.
+  \see begin_update()
+*/
+void Fl_Table::end_update() {
+  if ( _update_depth <= 0 ) return;
+  if ( --_update_depth > 0 ) return;
+  if ( _resize_pending ) {
+    table_resized();
+    redraw();
+  }
+}
+
+/**
+  Convenience method to set the height of all rows to the
+  same value, in pixels. The screen is redrawn.
+
+  This does not depend on the number of rows, unless a callback
+  is called for each changed row (see row_height(int, int)).
+*/
+void Fl_Table::row_height_all(int height) {
+  if ( Fl_Widget::callback() && (when() & FL_WHEN_CHANGED) ) {
+    begin_update();
+    for ( int r=0; r<rows(); r++ ) {
+      row_height(r, height);
+    }
+    end_update();
+    return;
+  }
+  _rowheights->fill(height);
+  table_resized();
+  redraw();
+}
+
+/**
+  Convenience method to set the width of all columns to the
+  same value, in pixels. The screen is redrawn.
+
+  This does not depend on the number of columns, unless a callback
+  is called for each changed column (see col_width(int, int)).
+*/
+void Fl_Table::col_width_all(int width) {
+  if ( Fl_Widget::callback() && (when() & FL_WHEN_CHANGED) ) {
+    begin_update();
+    for ( int c=0; c<cols(); c++ ) {
+      col_width(c, width);
+    }
+    end_update();
+    return;
+  }
+  _colwidths->fill(width);
+  table_resized();
+  redraw();
+}
+
 /**
   Callback for when someone moves a scrollbar.
 */
@@ -650,7 +708,7 @@ void Fl_Table::scroll_cb(Fl_Widget*w, void *data) {
   Fl_Table *o = (Fl_Table*)data;
   o->recalc_dimensions();       // recalc tix, tiy, etc.
   o->table_scrolled();
-  o->redraw();
+  o->damage(FL_DAMAGE_SCROLL);  // draw() moves the cells drawn before
 }
 
 /**
@@ -682,7 +740,7 @@ void Fl_Table::rows(int val) {
 void Fl_Table::cols(int val) {
   _cols = val;
 
-  int default_w = col_size() > 0 ? (*_colwidths)[col_size()-1] : 80;
+  int default_w = col_size() > 0 ? _colwidths->back() : 80;
   int now_size = col_size();
 
   if (now_size != val)
@@ -1263,9 +1321,52 @@ void Fl_Table::draw() {
     table_resized();
   }
 
+  // If only the scroll position changed, the cells and headers drawn before
+  // are moved in the window and only the cells that became visible are
+  // drawn. Not with child widgets, with fractional scaling (fl_scroll()
+  // is not pixel-accurate) or when drawing to another surface.
+  int scroll_cells = 0;
+  if ( damage() & FL_DAMAGE_SCROLL ) {
+    float scale = Fl_Surface_Device::surface()->driver()->scale();
+    if ( !(damage() & ~(FL_DAMAGE_SCROLL|FL_DAMAGE_CHILD)) &&
+         scale == int(scale) &&
+         Fl_Surface_Device::surface() == Fl_Display_Device::display_device() &&
+         !table->visible() &&               // no child widgets
+         tix == _drawn_tix && tiy == _drawn_tiy &&
+         tiw == _drawn_tiw && tih == _drawn_tih ) {
+      scroll_cells = 1;
+      clear_damage(damage() & ~FL_DAMAGE_SCROLL);
+    } else {
+      clear_damage(damage() | FL_DAMAGE_ALL);
+    }
+  }
+
   draw_cell(CONTEXT_STARTPAGE, 0, 0,            // let user's drawing routine
             tix, tiy, tiw, tih);                // prep new page
 
+  long hpos = (long)hscrollbar->value();
+  long vpos = (long)vscrollbar->value();
+  if ( scroll_cells ) {
+    int dx = (int)(_drawn_hpos - hpos);
+    int dy = (int)(_drawn_vpos - vpos);
+    int X,Y,W,H;
+    fl_push_clip(wix, wiy, wiw, wih);
+    fl_scroll(tix, tiy, tiw, tih, dx, dy, _draw_area_cb, this);
+    if ( row_header() && dy ) {
+      get_bounds(CONTEXT_ROW_HEADER, X, Y, W, H);
+      fl_push_clip(X, Y, W, H);
+      fl_scroll(X, Y, W, H, 0, dy, _draw_area_cb, this);
+      fl_pop_clip();
+    }
+    if ( col_header() && dx ) {
+      get_bounds(CONTEXT_COL_HEADER, X, Y, W, H);
+      fl_push_clip(X, Y, W, H);
+      fl_scroll(X, Y, W, H, dx, 0, _draw_area_cb, this);
+      fl_pop_clip();
+    }
+    fl_pop_clip();
+  }
+
   // Let fltk widgets draw themselves first. Do this after
   // draw_cell(CONTEXT_STARTPAGE) in case user moves widgets around.
   // Use window 'inner' clip to prevent drawing into table border.
@@ -1285,7 +1386,7 @@ void Fl_Table::draw() {
   //    that leak around the border.
   //
   if ( ! table->visible() ) {
-    if ( damage() & FL_DAMAGE_ALL || damage() & FL_DAMAGE_CHILD ) {
+    if ( (damage() & FL_DAMAGE_ALL || damage() & FL_DAMAGE_CHILD) && !scroll_cells ) {
       draw_box(table->box(), tox, toy, tow, toh, table->color());
     }
   }
@@ -1390,20 +1491,59 @@ void Fl_Table::draw() {
               tix, tiy, tiw, tih);              // routines cleanup
 
     _redraw_leftcol = _redraw_rightcol = _redraw_toprow = _redraw_botrow = -1;
+    _drawn_hpos = hpos;
+    _drawn_vpos = vpos;
+    _drawn_tix = tix; _drawn_tiy = tiy; _drawn_tiw = tiw; _drawn_tih = tih;
+  }
+  fl_pop_clip();
+}
+
+// Draws the row headers, column headers or cells that intersect an area.
+// This is the callback of fl_scroll() in draw(), areas left of the cells
+// are in the row header, areas above the cells in the column header.
+void Fl_Table::_draw_area(int X, int Y, int W, int H) {
+  long hpos = (long)hscrollbar->value();
+  long vpos = (long)vscrollbar->value();
+  int r0 = _rowheights->find(vpos + (Y > tiy ? Y - tiy : 0));
+  int r1 = _rowheights->find(vpos + (Y + H > tiy ? Y + H - 1 - tiy : 0));
+  int c0 = _colwidths->find(hpos + (X > tix ? X - tix : 0));
+  int c1 = _colwidths->find(hpos + (X + W > tix ? X + W - 1 - tix : 0));
+  if ( r0 < toprow ) r0 = toprow;
+  if ( r1 > botrow ) r1 = botrow;
+  if ( c0 < leftcol ) c0 = leftcol;
+  if ( c1 > rightcol ) c1 = rightcol;
+  fl_push_clip(X, Y, W, H);
+  if ( X < tox ) {
+    for ( int r = r0; r <= r1; r++ )
+      _redraw_cell(CONTEXT_ROW_HEADER, r, 0);
+  } else if ( Y < toy ) {
+    for ( int c = c0; c <= c1; c++ )
+      _redraw_cell(CONTEXT_COL_HEADER, 0, c);
+  } else {
+    for ( int r = r0; r <= r1; r++ )
+      for ( int c = c0; c <= c1; c++ )
+        _redraw_cell(CONTEXT_CELL, r, c);
+    // table smaller than the window, see draw()
+    if ( table_w < tiw ) fl_rectf(tix + table_w, tiy, tiw - table_w, tih, color());
+    if ( table_h < tih ) fl_rectf(tix, tiy + table_h, tiw, tih - table_h, color());
   }
   fl_pop_clip();
 }
 
+void Fl_Table::_draw_area_cb(void *d, int X, int Y, int W, int H) {
+  ((Fl_Table*)d)->_draw_area(X, Y, W, H);
+}
+
 /**
   Returns the current height of the specified row as a value in pixels.
 */
 int Fl_Table::row_height(int row) {
-  return((row < 0 || row >= row_size()) ? 0 : (*_rowheights)[row]);
+  return((row < 0 || row >= row_size()) ? 0 : _rowheights->size(row));
 }
 
 /**
   Returns the current width of the specified column in pixels.
 */
 int Fl_Table::col_width(int col) {
-  return((col < 0 || col >= col_size()) ? 0 : (*_colwidths)[col]);
+  return((col < 0 || col >= col_size()) ? 0 : _colwidths->size(col));
 }
@@ -27,6 +27,7 @@
 #include <FL/Fl.H>
 #include <FL/fl_draw.H>
 #include <stdlib.h>
+#include <algorithm>
 
 // for debugging...
 // #define DEBUG 1
@@ -179,12 +180,81 @@ void Fl_Table_Row::select_all_rows(int flag) {
 
 // Set number of rows
 void Fl_Table_Row::rows(int val) {
+  if (!_rowmap.empty()) {
+    if (val > (int)_rowmap.size()) {              // new rows go to the end
+      for (int i = (int)_rowmap.size(); i < val; i++) _rowmap.push_back(i);
+    } else if (val < (int)_rowmap.size()) {       // remove data rows >= val
+      int n = 0;
+      for (size_t r = 0; r < _rowmap.size(); r++) {
+        if (_rowmap[r] >= val) continue;
+        _rowselect[n] = _rowselect[r];
+        _rowmap[n++] = _rowmap[r];
+      }
+      _rowmap.resize(n);
+      for (size_t r = n; r < _rowselect.size(); r++) _rowselect[r] = 0;
+    }
+  }
   // Note: order of operations below matters, see PR #1187
   if (val > (int)_rowselect.size()) { _rowselect.resize(val, 0); }  // enlarge
   Fl_Table::rows(val);
   if (val < (int)_rowselect.size()) { _rowselect.resize(val); }     // shrink
 }
 
+// Shows the data rows in the order given by map, keeping the selection
+// with the data. 'map' is swapped with the current order.
+void Fl_Table_Row::row_order(std::vector<int> &map) {
+  int n = (int)map.size();
+  std::vector<uint8_t> sel(n);
+  for (int r = 0; r < n; r++) sel[row_index(r)] = _rowselect[r];
+  for (int r = 0; r < n; r++) _rowselect[r] = sel[map[r]];
+  _rowmap.swap(map);
+  _last_row = -1;
+  redraw();
+}
+
+/**
+  Sorts the rows with a comparison function.
+
+  Only the order in which the rows are shown changes, the application's
+  data is not moved: row_index() returns the index of the data shown in a
+  row, which is also what \p compare is called with. The selection stays
+  with the data. The sort is stable, so rows that compare equal keep the
+  order they are shown in, which allows sorting by several columns in turn.
+
+  Rows added later with rows(int) are shown at the end.
+
+  \param[in] compare  returns <0, 0 or >0 if the data of its first row sorts
+                      before, together with or after the data of the second
+  \param[in] data     the last argument of \p compare
+  \param[in] reverse  non-zero to sort in descending order
+
+  \see unsort_rows(), row_index()
+*/
+void Fl_Table_Row::sort_rows(Fl_Table_Row_Compare *compare, void *data, int reverse) {
+  int n = rows();
+  if (!compare || n < 2) return;
+  std::vector<int> map(n);
+  for (int r = 0; r < n; r++) map[r] = row_index(r);
+  std::stable_sort(map.begin(), map.end(), [&](int a, int b) {
+    int c = compare(a, b, data);
+    return reverse ? c > 0 : c < 0;
+  });
+  row_order(map);
+}
+
+/**
+  Shows the rows in the order of the application's data again.
+  The selection stays with the data.
+  \see sort_rows(), row_index()
+*/
+void Fl_Table_Row::unsort_rows() {
+  if (_rowmap.empty()) return;
+  std::vector<int> map(_rowmap.size());
+  for (size_t r = 0; r < map.size(); r++) map[r] = (int)r;
+  row_order(map);
+  _rowmap.clear();
+}
+
 // Handle events
 int Fl_Table_Row::handle(int event) {
   PRINTEVENT;
@@ -0,0 +1,229 @@
+//
+// Row height and column width index for Fl_Table for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Table_Sizes.H"
+
+#include <algorithm>
+
+Fl_Table_Sizes::Fl_Table_Sizes()
+  : count_(0), default_(0), total_(0), dense_(false), valid_(false) {
+}
+
+// Returns the position of the first entry in index_ that is >= i
+int Fl_Table_Sizes::lower(int i) const {
+  return (int)(std::lower_bound(index_.begin(), index_.end(), i) - index_.begin());
+}
+
+// Rebuilds the prefix sums of the sparse differences in O(k),
+// or the Fenwick tree of the dense sizes in O(n)
+void Fl_Table_Sizes::build() const {
+  if (dense_) {
+    int n = count_;
+    tree_.assign(n + 1, 0);
+    for (int i = 1; i <= n; i++) {
+      tree_[i] += sizes_[i - 1];
+      int j = i + (i & -i);
+      if (j <= n) tree_[j] += tree_[i];
+    }
+  } else {
+    size_t k = index_.size();
+    delta_.resize(k + 1);
+    delta_[0] = 0;
+    for (size_t j = 0; j < k; j++)
+      delta_[j + 1] = delta_[j] + (value_[j] - default_);
+  }
+  valid_ = true;
+}
+
+// Converts the sparse storage to a dense array
+void Fl_Table_Sizes::make_dense() {
+  sizes_.assign(count_, default_);
+  for (size_t j = 0; j < index_.size(); j++)
+    sizes_[index_[j]] = value_[j];
+  std::vector<int>().swap(index_);
+  std::vector<int>().swap(value_);
+  std::vector<long>().swap(delta_);
+  dense_ = true;
+  valid_ = false;
+}
+
+// Returns the size of entry i (must be in range)
+int Fl_Table_Sizes::size(int i) const {
+  if (dense_) return sizes_[i];
+  int j = lower(i);
+  if (j < (int)index_.size() && index_[j] == i) return value_[j];
+  return default_;
+}
+
+// Sets the number of entries to n, new entries get the size 'value'
+void Fl_Table_Sizes::resize(int n, int value) {
+  if (n < 0) n = 0;
+  if (n == count_) return;
+  valid_ = false;
+  if (n < count_) {
+    if (dense_) {
+      for (int i = n; i < count_; i++)
+        total_ -= sizes_[i];
+      sizes_.resize(n);
+    } else {
+      int j = lower(n);
+      total_ -= (long)(count_ - n) * default_;
+      for (size_t m = j; m < index_.size(); m++)
+        total_ -= value_[m] - default_;
+      index_.resize(j);
+      value_.resize(j);
+    }
+    count_ = n;
+    return;
+  }
+  int added = n - count_;
+  total_ += (long)added * value;
+  if (count_ == 0 && !dense_) default_ = value;
+  if (dense_) {
+    sizes_.resize(n, value);
+  } else if (value != default_) {
+    size_t k = index_.size() + added;
+    if (k > SPARSE_MIN && k > (size_t)(n / SPARSE_RATIO)) {
+      make_dense();
+      sizes_.resize(n, value);
+    } else {
+      for (int i = count_; i < n; i++) {
+        index_.push_back(i);
+        value_.push_back(value);
+      }
+    }
+  }
+  count_ = n;
+}
+
+// Sets the size of entry i (must be in range)
+void Fl_Table_Sizes::size(int i, int value) {
+  int old = size(i);
+  if (old == value) return;
+  total_ += value - old;
+  if (dense_) {
+    sizes_[i] = value;
+    if (valid_) {
+      for (int j = i + 1; j <= count_; j += (j & -j))
+        tree_[j] += value - old;
+    }
+    return;
+  }
+  if (count_ == 1) {                    // change the default instead
+    default_ = value;
+    index_.clear();
+    value_.clear();
+    valid_ = false;
+    return;
+  }
+  int j = lower(i);
+  int k = (int)index_.size();
+  if (j < k && index_[j] == i) {
+    if (value == default_) {
+      index_.erase(index_.begin() + j);
+      value_.erase(value_.begin() + j);
+      valid_ = false;
+    } else {
+      value_[j] = value;
+      if (valid_) {
+        for (int m = j + 1; m <= k; m++)
+          delta_[m] += value - old;
+      }
+    }
+    return;
+  }
+  // new difference from the default
+  if (k + 1 > SPARSE_MIN && k + 1 > count_ / SPARSE_RATIO) {
+    make_dense();
+    sizes_[i] = value;
+    return;
+  }
+  index_.insert(index_.begin() + j, i);
+  value_.insert(value_.begin() + j, value);
+  if (valid_ && j == k) {                 // appended: no need to rebuild
+    delta_.push_back(delta_[k] + (value - default_));
+  } else {
+    valid_ = false;
+  }
+}
+
+// Sets the size of all entries to 'value'
+void Fl_Table_Sizes::fill(int value) {
+  std::vector<int>().swap(sizes_);
+  std::vector<long>().swap(tree_);
+  index_.clear();
+  value_.clear();
+  dense_ = false;
+  valid_ = false;
+  default_ = value;
+  total_ = (long)count_ * value;
+}
+
+// Returns the sum of the sizes of all entries before entry i
+long Fl_Table_Sizes::position(int i) const {
+  if (i <= 0) return 0;
+  if (i >= count_) return total_;
+  if (!dense_ && index_.empty()) return (long)i * default_;
+  if (!valid_) build();
+  if (dense_) {
+    long pos = 0;
+    for (; i > 0; i -= (i & -i))
+      pos += tree_[i];
+    return pos;
+  }
+  return (long)i * default_ + delta_[lower(i)];
+}
+
+// Returns the entry that contains position 'pos', i.e. the first entry
+// whose end is greater than 'pos', or count() if 'pos' is not inside.
+// Entries with size 0 are never found.
+int Fl_Table_Sizes::find(long pos) const {
+  if (pos < 0) return 0;
+  if (pos >= total_) return count_;
+  if (!dense_ && index_.empty()) return (int)(pos / default_);
+  if (!valid_) build();
+  if (dense_) {
+    int step = 1;
+    while (step * 2 <= count_) step *= 2;
+    int i = 0;
+    for (; step > 0; step /= 2) {
+      if (i + step <= count_ && tree_[i + step] <= pos) {
+        i += step;
+        pos -= tree_[i];
+      }
+    }
+    return i;
+  }
+  // find the last entry with a different size that starts at or before 'pos'
+  int lo = 0, hi = (int)index_.size();  // answer in [lo-1, hi-1]
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if ((long)index_[mid] * default_ + delta_[mid] <= pos) lo = mid + 1;
+    else hi = mid;
+  }
+  int j = lo - 1;
+  long start = 0;                       // position of the first default entry after j
+  int first = 0;                        // index of this entry
+  if (j >= 0) {
+    long p = (long)index_[j] * default_ + delta_[j];
+    if (pos < p + value_[j]) return index_[j];
+    start = p + value_[j];
+    first = index_[j] + 1;
+  }
+  if (default_ <= 0)                    // only the next different entry is left
+    return (j + 1 < (int)index_.size()) ? index_[j + 1] : count_;
+  return first + (int)((pos - start) / default_);
+}
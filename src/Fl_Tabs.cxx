@@ -47,6 +47,12 @@ int Fl_Tabs::on_insert(Fl_Widget* candidate, int index) {
   return Fl_Group::on_insert(candidate, index);
 }
 
+/** Make sure that we redraw all tabs when all children are deleted. */
+void Fl_Tabs::on_clear() {
+  redraw_tabs();
+  damage(FL_DAMAGE_ALL);
+}
+
 /** Make sure that we redraw all tabs when children are moved. */
 int Fl_Tabs::on_move(int a, int b) {
   redraw_tabs();
@@ -0,0 +1,476 @@
+//
+// Worker thread pool for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+/**
+  \file Fl_Task_Pool.cxx
+*/
+
+#include <FL/Fl_Task_Pool.H>
+#include <FL/Fl.H>
+#include "Fl_System_Driver.H"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// static class variables
+
+int Fl_Task_Pool::owners_ = 0;
+
+namespace {
+
+struct Task {
+  unsigned int id;
+  Fl_Task_Handler work;
+  Fl_Awake_Handler done;
+  void *data;
+  Fl_Widget *owner;                 // accessed by the main thread only
+  std::atomic<bool> cancelled;
+};
+
+/*
+  The state of the pool. It is allocated once and never destroyed: worker
+  threads are detached and idle workers may still be waiting for tasks, and
+  busy workers may still queue their finished tasks, while static objects
+  are destroyed at program exit.
+
+  All members are protected by 'mutex' unless noted otherwise. The system
+  driver only creates threads, it has no portable mutex or condition
+  variable, hence these are taken from the C++ standard library.
+*/
+struct Pool_State {
+  std::mutex mutex;
+  std::condition_variable task_cond;  // a task was queued or workers must exit
+  std::condition_variable exit_cond;  // a worker thread exited
+
+  std::deque<Task *> lanes[Fl_Task_Pool::LANES];  // queued tasks
+  std::vector<Task *> active;         // started tasks, not yet delivered
+  std::deque<Task *> finished;        // finished tasks, not yet delivered
+  int limits[Fl_Task_Pool::LANES];
+
+  int max_threads;                    // configured number of workers
+  int live_threads;                   // number of running worker threads
+  int idle_threads;                   // workers waiting for tasks
+  int starting_threads;               // workers started but not yet running
+  bool stopping;                      // set by shutdown()
+  unsigned int last_id;               // main thread only
+
+  Pool_State()
+    : max_threads(4), live_threads(0), idle_threads(0), starting_threads(0),
+      stopping(false), last_id(0) {
+    for (int i = 0; i < Fl_Task_Pool::LANES; i++)
+      limits[i] = 1024;
+  }
+};
+
+Pool_State &pool = *new Pool_State;
+
+thread_local Task *current_task = 0;
+
+// Returns the next task to be started or NULL, called with 'mutex' locked
+Task *pop_task() {
+  for (int i = 0; i < Fl_Task_Pool::LANES; i++) {
+    if (!pool.lanes[i].empty()) {
+      Task *t = pool.lanes[i].front();
+      pool.lanes[i].pop_front();
+      return t;
+    }
+  }
+  return 0;
+}
+
+// Removes a task from the list of active tasks, called with 'mutex' locked
+void remove_active(Task *t) {
+  for (size_t i = 0; i < pool.active.size(); i++) {
+    if (pool.active[i] == t) {
+      pool.active.erase(pool.active.begin() + i);
+      return;
+    }
+  }
+}
+
+// Deletes a task, main thread only
+void release_task(Task *t) {
+  if (t->owner) Fl_Task_Pool::owners_--;
+  delete t;
+}
+
+// Delivers finished tasks: runs in the main thread (awake handler)
+void deliver_tasks(void *) {
+  for (;;) {
+    Task *t;
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      if (pool.finished.empty()) break;
+      t = pool.finished.front();
+      pool.finished.pop_front();
+      remove_active(t);
+    }
+    if (!t->cancelled && t->done)
+      t->done(t->data);
+    release_task(t);
+  }
+}
+
+// Returns whether tasks are queued, running or not yet delivered, called with 'mutex' locked
+bool busy() {
+  if (!pool.active.empty()) return true;
+  for (int i = 0; i < Fl_Task_Pool::LANES; i++)
+    if (!pool.lanes[i].empty()) return true;
+  return false;
+}
+
+// Interval of poll_tasks() in seconds
+const double POLL_INTERVAL = 0.05;
+
+// Delivers finished tasks while the pool is busy: runs in the main thread
+// (timeout). Fl::awake() only wakes up the main thread if the program called
+// Fl::lock() (e.g. on X11), but Fl_File_Chooser and other users of the pool
+// must not depend on it.
+void poll_tasks(void *) {
+  deliver_tasks(0);
+  bool again;
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    again = busy();
+  }
+  if (again) Fl::repeat_timeout(POLL_INTERVAL, poll_tasks);
+}
+
+void *worker(void *) {
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  pool.starting_threads--;
+  for (;;) {
+    Task *t = 0;
+    while (!pool.stopping && pool.live_threads <= pool.max_threads && !(t = pop_task())) {
+      pool.idle_threads++;
+      pool.task_cond.wait(lock);
+      pool.idle_threads--;
+    }
+    if (!t) break;
+    pool.active.push_back(t);
+    lock.unlock();
+
+    current_task = t;
+    if (!t->cancelled) t->work(t->data);
+    current_task = 0;
+
+    lock.lock();
+    pool.finished.push_back(t);
+    lock.unlock();
+    Fl::awake_once(deliver_tasks, 0);
+    lock.lock();
+  }
+  pool.live_threads--;
+  pool.exit_cond.notify_all();
+  return 0;
+}
+
+// Cancels all tasks of an owner, main thread only.
+// Returns the number of cancelled tasks and optionally forgets the owner.
+int cancel_owner(Fl_Widget *owner, bool forget) {
+  std::vector<Task *> removed;
+  int n = 0;
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (int i = 0; i < Fl_Task_Pool::LANES; i++) {
+      std::deque<Task *> &q = pool.lanes[i];
+      for (size_t j = 0; j < q.size(); ) {
+        if (q[j]->owner == owner) {
+          removed.push_back(q[j]);
+          q.erase(q.begin() + j);
+        } else {
+          j++;
+        }
+      }
+    }
+    for (size_t i = 0; i < pool.active.size(); i++) {
+      Task *t = pool.active[i];
+      if (t->owner != owner) continue;
+      if (!t->cancelled) n++;
+      t->cancelled = true;
+      if (forget) {
+        t->owner = 0;
+        Fl_Task_Pool::owners_--;
+      }
+    }
+  }
+  for (size_t i = 0; i < removed.size(); i++)
+    release_task(removed[i]);
+  return n + (int)removed.size();
+}
+
+} // anonymous namespace
+
+
+/**
+  Queues a task to be run by a worker thread.
+
+  The function \p work is called with \p data in a worker thread. When it
+  returns the optional function \p done is called with \p data in the main
+  thread, unless the task was
+  cancelled. Note that \p done is \b not called for cancelled tasks, hence
+  you may need to track \p data yourself if it must be released.
+
+  If \p owner is not NULL the task is cancelled when the \p owner widget
+  is deleted, see cancel(Fl_Widget*).
+
+  Worker threads are started as needed, up to the number set by threads().
+
+  \param[in] work   function executed by a worker thread, must not be NULL
+  \param[in] data   user data passed to \p work and \p done
+  \param[in] done   optional completion handler called in the main thread
+  \param[in] owner  optional widget that limits the lifetime of the task
+  \param[in] lane   priority lane, see Fl_Task_Pool::Lane
+
+  \return a task id (> 0) that can be used with cancel(unsigned int), or
+    0 if the queue of \p lane is full or \p work is NULL
+
+  \see Fl::run_async()
+*/
+unsigned int Fl_Task_Pool::run(Fl_Task_Handler work, void *data,
+                               Fl_Awake_Handler done, Fl_Widget *owner,
+                               Lane lane) {
+  if (!work) return 0;
+  if (lane < HIGH || lane >= LANES) lane = NORMAL;
+
+  Task *t = new Task;
+  t->work = work;
+  t->done = done;
+  t->data = data;
+  t->owner = owner;
+  t->cancelled = false;
+  if (owner) owners_++;
+
+  bool start = false;
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if ((int)pool.lanes[lane].size() >= pool.limits[lane]) {
+      release_task(t);
+      return 0;
+    }
+    if (++pool.last_id == 0) pool.last_id = 1;
+    t->id = pool.last_id;
+    pool.lanes[lane].push_back(t);
+    if (pool.idle_threads > 0)
+      pool.task_cond.notify_one();
+    // Notified workers stay idle until they run, so start another worker
+    // if more tasks are queued than idle and starting workers can take.
+    int queued = 0;
+    for (int i = 0; i < LANES; i++)
+      queued += (int)pool.lanes[i].size();
+    if (queued > pool.idle_threads + pool.starting_threads &&
+        pool.live_threads < pool.max_threads) {
+      pool.live_threads++;
+      pool.starting_threads++;
+      start = true;
+    }
+  }
+
+  if (start && Fl::system_driver()->create_thread(worker, 0) != 0) {
+    bool sync;
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      pool.live_threads--;
+      pool.starting_threads--;
+      sync = (pool.live_threads == 0);   // no thread support
+      if (sync) {
+        for (std::deque<Task *>::iterator it = pool.lanes[lane].begin(); it != pool.lanes[lane].end(); ++it) {
+          if (*it == t) { pool.lanes[lane].erase(it); break; }
+        }
+      }
+    }
+    if (sync) {
+      unsigned int id = t->id;
+      current_task = t;
+      work(data);
+      current_task = 0;
+      if (done) done(data);
+      release_task(t);
+      return id;
+    }
+  }
+  if (!Fl::has_timeout(poll_tasks))
+    Fl::add_timeout(POLL_INTERVAL, poll_tasks);
+  return t->id;
+}
+
+/**
+  Cancels a task.
+
+  If the task is still queued it is removed from the queue. If it is running
+  it is flagged as cancelled, see cancelled(). In both cases the completion
+  handler will not be called.
+
+  \param[in] id  task id as returned by run()
+  \return 1 if the task was found and cancelled, 0 otherwise
+*/
+int Fl_Task_Pool::cancel(unsigned int id) {
+  Task *removed = 0;
+  int ret = 0;
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    for (int i = 0; i < LANES && !removed; i++) {
+      for (std::deque<Task *>::iterator it = pool.lanes[i].begin(); it != pool.lanes[i].end(); ++it) {
+        if ((*it)->id == id) {
+          removed = *it;
+          pool.lanes[i].erase(it);
+          break;
+        }
+      }
+    }
+    if (removed) {
+      ret = 1;
+    } else {
+      for (size_t i = 0; i < pool.active.size(); i++) {
+        if (pool.active[i]->id == id && !pool.active[i]->cancelled) {
+          pool.active[i]->cancelled = true;
+          ret = 1;
+          break;
+        }
+      }
+    }
+  }
+  if (removed) release_task(removed);
+  return ret;
+}
+
+/**
+  Cancels all tasks owned by a widget.
+
+  This is called automatically when the owner widget is deleted.
+
+  \param[in] owner  widget given to run()
+  \return number of cancelled tasks
+*/
+int Fl_Task_Pool::cancel(Fl_Widget *owner) {
+  if (!owner || !owners_) return 0;
+  return cancel_owner(owner, false);
+}
+
+/**
+  Returns whether the task running in the current thread was cancelled.
+
+  Task functions can call this periodically and return early if the task
+  was cancelled. It returns false if called outside of a task function.
+*/
+bool Fl_Task_Pool::cancelled() {
+  return current_task && current_task->cancelled;
+}
+
+/**
+  Returns the number of queued tasks that have not been started yet.
+*/
+int Fl_Task_Pool::pending() {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  int n = 0;
+  for (int i = 0; i < LANES; i++)
+    n += (int)pool.lanes[i].size();
+  return n;
+}
+
+/**
+  Returns the number of queued tasks in one lane.
+*/
+int Fl_Task_Pool::pending(Lane lane) {
+  if (lane < HIGH || lane >= LANES) return 0;
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return (int)pool.lanes[lane].size();
+}
+
+/**
+  Sets the maximal number of worker threads.
+
+  The default is 4. Workers are started on demand. If the number is
+  decreased surplus workers exit after finishing their current task.
+
+  \param[in] n  number of worker threads, at least 1
+*/
+void Fl_Task_Pool::threads(int n) {
+  if (n < 1) n = 1;
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.max_threads = n;
+  pool.task_cond.notify_all();
+}
+
+/**
+  Returns the maximal number of worker threads.
+*/
+int Fl_Task_Pool::threads() {
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return pool.max_threads;
+}
+
+/**
+  Sets the maximal number of queued tasks in a lane.
+
+  The default is 1024 tasks per lane. Tasks that are already running
+  are not counted.
+
+  \param[in] lane  priority lane
+  \param[in] n     maximal number of queued tasks, at least 1
+*/
+void Fl_Task_Pool::queue_limit(Lane lane, int n) {
+  if (lane < HIGH || lane >= LANES) return;
+  if (n < 1) n = 1;
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.limits[lane] = n;
+}
+
+/**
+  Returns the maximal number of queued tasks in a lane.
+*/
+int Fl_Task_Pool::queue_limit(Lane lane) {
+  if (lane < HIGH || lane >= LANES) return 0;
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return pool.limits[lane];
+}
+
+/**
+  Cancels all tasks and stops all worker threads.
+
+  This waits until all running tasks returned. Completion handlers are not
+  called. The pool can be used again after this, new workers are started
+  when the next task is queued.
+*/
+void Fl_Task_Pool::shutdown() {
+  std::vector<Task *> removed;
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    Task *t;
+    while ((t = pop_task()))
+      removed.push_back(t);
+    for (size_t i = 0; i < pool.active.size(); i++)
+      pool.active[i]->cancelled = true;
+    pool.stopping = true;
+    pool.task_cond.notify_all();
+    while (pool.live_threads > 0)
+      pool.exit_cond.wait(lock);
+    pool.stopping = false;
+  }
+  for (size_t i = 0; i < removed.size(); i++)
+    release_task(removed[i]);
+  deliver_tasks(0);
+}
+
+/*
+  Internal: cancels all tasks of a widget that is being deleted.
+*/
+void Fl_Task_Pool::owner_deleted_(Fl_Widget *owner) {
+  cancel_owner(owner, true);
+}
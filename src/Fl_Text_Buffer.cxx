@@ -23,6 +23,7 @@
 #include <FL/Fl.H>
 #include <FL/Fl_Text_Buffer.H>
 #include <FL/fl_ask.H>
+#include "Fl_Update_Queue.H"
 
 
 /*
@@ -229,6 +230,7 @@ Fl_Text_Buffer::Fl_Text_Buffer(int requestedSize, int preferredGapSize)
   mUndo = new Fl_Text_Undo_Action();
   mUndoList = new Fl_Text_Undo_Action_List();
   mRedoList = new Fl_Text_Undo_Action_List();
+  mUpdateQueue = NULL;
   input_file_was_transcoded = 0;
   transcoding_warning_action = def_transcoding_warning_action;
 }
@@ -251,6 +253,110 @@ Fl_Text_Buffer::~Fl_Text_Buffer()
   delete mUndo;
   delete mUndoList;
   delete mRedoList;
+  Fl_Update_Queue::destroy(mUpdateQueue);
+}
+
+
+/*
+ Applies changes posted by other threads, called by the main thread.
+ Runs of consecutive APPEND operations are applied with a single append.
+ */
+static void apply_posted_cb(void *target, const Fl_Update_Queue::Op *ops, int n) {
+  Fl_Text_Buffer *buf = (Fl_Text_Buffer *)target;
+  std::string appended;
+  for (int i = 0; i < n; i++) {
+    const Fl_Update_Queue::Op &op = ops[i];
+    const char *str = op.str ? op.str : "";
+    if (op.code == Fl_Update_Queue::APPEND) {
+      appended += str;
+      if (i + 1 < n && ops[i + 1].code == Fl_Update_Queue::APPEND) continue;
+      buf->append(appended.c_str(), (int)appended.size());
+      appended.clear();
+      continue;
+    }
+    switch (op.code) {
+      case Fl_Update_Queue::TEXT:
+        buf->text(str);
+        break;
+      case Fl_Update_Queue::INSERT:
+        buf->insert(op.i1, str);
+        break;
+      case Fl_Update_Queue::REMOVE:
+        buf->remove(op.i1, op.i2);
+        break;
+      case Fl_Update_Queue::REPLACE:
+        buf->replace(op.i1, op.i2, str);
+        break;
+    }
+  }
+}
+
+/**
+ Replaces the entire contents of the buffer, can be called from any thread.
+ \param text UTF-8 encoded text, NULL is the same as an empty string
+ \see text(const char*)
+ */
+void Fl_Text_Buffer::post_text(const char *text) {
+  Fl_Update_Queue::post(mUpdateQueue, this, apply_posted_cb, Fl_Update_Queue::TEXT, 0, 0, 0.0, 0, text);
+}
+
+/**
+ Inserts text, can be called from any thread.
+ \param pos insertion position as byte offset (must be UTF-8 character aligned)
+ \param text UTF-8 encoded text
+ \see insert()
+ */
+void Fl_Text_Buffer::post_insert(int pos, const char *text) {
+  Fl_Update_Queue::post(mUpdateQueue, this, apply_posted_cb, Fl_Update_Queue::INSERT, pos, 0, 0.0, 0, text);
+}
+
+/**
+ Appends text to the end of the buffer, can be called from any thread.
+ \param text UTF-8 encoded text
+ \see append()
+ */
+void Fl_Text_Buffer::post_append(const char *text) {
+  Fl_Update_Queue::post(mUpdateQueue, this, apply_posted_cb, Fl_Update_Queue::APPEND, 0, 0, 0.0, 0, text);
+}
+
+/**
+ Deletes a range of characters, can be called from any thread.
+ \param start byte offset to first character to be removed
+ \param end byte offset to character after last character to be removed
+ \see remove()
+ */
+void Fl_Text_Buffer::post_remove(int start, int end) {
+  Fl_Update_Queue::post(mUpdateQueue, this, apply_posted_cb, Fl_Update_Queue::REMOVE, start, end);
+}
+
+/**
+ Replaces a range of characters, can be called from any thread.
+ \param start byte offset to first character to be removed and new insert position
+ \param end byte offset to character after last character to be removed
+ \param text UTF-8 encoded text
+ \see replace()
+ */
+void Fl_Text_Buffer::post_replace(int start, int end, const char *text) {
+  Fl_Update_Queue::post(mUpdateQueue, this, apply_posted_cb, Fl_Update_Queue::REPLACE, start, end, 0.0, 0, text);
+}
+
+/**
+ Returns the number of posted changes that have not yet been taken over
+ by the main thread. Can be called from any thread.
+ */
+int Fl_Text_Buffer::posted() const {
+  return Fl_Update_Queue::pending(mUpdateQueue);
+}
+
+/**
+ Applies all posted changes immediately. Must be called by the main thread.
+
+ This is done automatically before the next Fl::flush(), but you may
+ call it if you need to access the buffer contents including all
+ posted changes.
+ */
+void Fl_Text_Buffer::apply_posted() {
+  Fl_Update_Queue::flush(mUpdateQueue);
 }
 
 
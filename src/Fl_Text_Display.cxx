@@ -161,6 +161,8 @@ Fl_Text_Display::Fl_Text_Display(int X, int Y, int W, int H, const char* l)
   mVScrollBar->callback((Fl_Callback*)v_scrollbar_cb, this);
 
   display_needs_recalc_ = false;
+  mDrawnValid = false;
+  mDrawnTopLineNum = mDrawnHorizOffset = mDrawnMaxsize = 0;
 
   scrollbar_width_ = 0;         // 0: default from Fl::scrollbar_size()
   scrollbar_align_ = FL_ALIGN_BOTTOM_RIGHT;
@@ -452,6 +454,7 @@ void Fl_Text_Display::highlight_data(Fl_Text_Buffer *styleBuffer,
 
   if (mStyleBuffer)
     mStyleBuffer->canUndo(0);
+  mDrawnValid = false;
   damage(FL_DAMAGE_EXPOSE);
 }
 
@@ -1828,6 +1831,7 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
 
   /* If the changes caused scrolling, re-paint everything and we're done. */
   if ( scrolled ) {
+    textD->mDrawnValid = false;
     textD->damage(FL_DAMAGE_EXPOSE);
     if ( textD->mStyleBuffer )   /* See comments in extend_range_for_styles() */
       textD->mStyleBuffer->primary_selection()->selected(0);
@@ -1860,6 +1864,7 @@ void Fl_Text_Display::buffer_modified_cb( int pos, int nInserted, int nDeleted,
     }
     if (linesInserted > 1) {
       // textD->draw_line_numbers(false); // can't do this b/c not called from virtual draw();
+      textD->mDrawnValid = false;
       textD->damage(FL_DAMAGE_EXPOSE);
     }
   } else {
@@ -3925,6 +3930,17 @@ void Fl_Text_Display::draw(void) {
 
   fl_push_clip(x(),y(),w(),h());        // prevent drawing outside widget area
 
+  // If only the scroll position changed since the last draw, move the text
+  // in the window and draw only the parts that became visible. Not with
+  // fractional scaling, where fl_scroll() is not pixel-accurate, or when
+  // drawing to another surface (printer, retained widget cache).
+  float scale = Fl_Surface_Device::surface()->driver()->scale();
+  int scroll_text = mDrawnValid && mDrawnMaxsize == mMaxsize && mMaxsize > 0 &&
+      scale == int(scale) &&
+      Fl_Surface_Device::surface() == Fl_Display_Device::display_device() &&
+      (damage() & (FL_DAMAGE_ALL | FL_DAMAGE_EXPOSE)) == FL_DAMAGE_EXPOSE &&
+      (mDrawnTopLineNum != mTopLineNum || mDrawnHorizOffset != mHorizOffset);
+
   // background color -- change if inactive
   Fl_Color bgcolor = active_r() ? color() : fl_inactive(color());
 
@@ -3987,7 +4003,27 @@ void Fl_Text_Display::draw(void) {
   update_child(*mHScrollBar);
 
   // draw all of the text
-  if (damage() & (FL_DAMAGE_ALL | FL_DAMAGE_EXPOSE)) {
+  if (scroll_text) {
+    fl_push_clip(text_area.x, text_area.y, text_area.w, text_area.h);
+    // only whole lines are moved, the partial line at the bottom was clipped
+    int H = text_area.h / mMaxsize * mMaxsize;
+    fl_scroll(text_area.x, text_area.y, text_area.w, H,
+              mDrawnHorizOffset - mHorizOffset,
+              (mDrawnTopLineNum - mTopLineNum) * mMaxsize,
+              draw_text_cb, this);
+    if (H < text_area.h)
+      draw_text(text_area.x, text_area.y + H, text_area.w, text_area.h - H);
+    // text that changed in the meantime
+    if (damage() & FL_DAMAGE_SCROLL) {
+      draw_range(damage_range1_start, damage_range1_end);
+      if (damage_range2_end != -1)
+        draw_range(damage_range2_start, damage_range2_end);
+      damage_range1_start = damage_range1_end = -1;
+      damage_range2_start = damage_range2_end = -1;
+    }
+    fl_pop_clip();
+  }
+  else if (damage() & (FL_DAMAGE_ALL | FL_DAMAGE_EXPOSE)) {
     //printf("drawing all text\n");
     int X = 0, Y = 0, W = 0, H = 0;
     if (fl_clip_box(text_area.x, text_area.y, text_area.w, text_area.h,
@@ -4042,9 +4078,19 @@ void Fl_Text_Display::draw(void) {
   // will not scroll with the text edit area
   draw_line_numbers(true);
 
+  mDrawnValid = true;
+  mDrawnTopLineNum = mTopLineNum;
+  mDrawnHorizOffset = mHorizOffset;
+  mDrawnMaxsize = mMaxsize;
+
   fl_pop_clip();
 }
 
+// Draws the text in an area, the callback of fl_scroll() in draw()
+void Fl_Text_Display::draw_text_cb(void *d, int X, int Y, int W, int H) {
+  ((Fl_Text_Display*)d)->draw_text(X, Y, W, H);
+}
+
 // GitHub Issue #196: internal selection and visible selection can run out of
 // sync, giving the user unexpected keyboard selection. The code block below
 // captures that and fixes it.
@@ -845,6 +845,14 @@ void Fl_Tile::on_remove(int index) {
   }
 }
 
+/**
+ Clear the size range list when all children are deleted.
+ */
+void Fl_Tile::on_clear() {
+  if (size_range_)
+    size_range_size_ = 0;
+}
+
 /**
  Set the allowed size range for the child at the given index.
 
@@ -19,6 +19,7 @@
 
 #include "Fl_Timeout.h"
 #include "Fl_System_Driver.H"
+#include "Fl_Event_Stats_Scope.H"
 
 #include <stdio.h>
 #include <math.h> // for trunc()
@@ -547,7 +548,10 @@ void Fl_Timeout::do_timeouts() {
       // make this timeout the "current" timeout
       t->make_current();
       // now it is safe for the callback to do add_timeout:
-      t->callback(t->data);
+      {
+        FL_EVENT_STATS_SCOPE(TIMEOUT, t->callback);
+        t->callback(t->data);
+      }
       // release the timer entry
       t->release();
 
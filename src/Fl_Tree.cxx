@@ -22,6 +22,9 @@
 #include <FL/Fl_Tree.H>
 #include <FL/Fl_Preferences.H>
 #include <FL/fl_string_functions.h>
+#include "Fl_Update_Queue.H"
+#include "Fl_Filter_Index.H"
+#include <vector>
 
 // INTERNAL: scroller callback (hor+vert scroll)
 static void scroll_cb(Fl_Widget*,void *data) {
@@ -73,6 +76,7 @@ static int find_total_children(Fl_Tree_Item *item, int count=0) {
 
 /// Constructor.
 Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L) {
+  _filter = 0;                                  // before any item calls recalc_tree()
   _root = new Fl_Tree_Item(this);
   _root->parent(0);                             // we are root of tree
   _root->label("ROOT");
@@ -83,6 +87,9 @@ Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L
   _lastselect           = nullptr;
   _lastpushed           = 0;
   _auto_resize_children = 0;                    // don't resize children automatically
+  _update_queue         = 0;
+  _populate_cb          = 0;
+  _populate_data        = 0;
 
   box(FL_DOWN_BOX);
   color(FL_BACKGROUND2_COLOR, FL_SELECTION_COLOR);
@@ -104,12 +111,15 @@ Fl_Tree::Fl_Tree(int X, int Y, int W, int H, const char *L) : Fl_Group(X,Y,W,H,L
   _toh = _tih = H - Fl::box_dh(box());
   _tree_w = -1;
   _tree_h = -1;
+  _recalc_all = 0;
   end();
 }
 
 /// Destructor.
 Fl_Tree::~Fl_Tree() {
+  Fl_Update_Queue::destroy(_update_queue);
   if ( _root ) { delete _root; _root = 0; }
+  delete _filter;
 }
 
 /// Extend the selection between and including \p 'from' and \p 'to'
@@ -327,8 +337,8 @@ int Fl_Tree::handle(int e) {
               set_item_focus(next_visible_item(_item_focus, ekey));     // next item up|dn
               if ( _item_focus ) {                                      // item in focus?
                 // Autoscroll
-                int itemtop = _item_focus->y();
-                int itembot = _item_focus->y()+_item_focus->h();
+                int itemtop = item_y(_item_focus);
+                int itembot = itemtop + item_h(_item_focus);
                 if ( itemtop < y() ) { show_item_top(_item_focus); }
                 if ( itembot > y()+h() ) { show_item_bottom(_item_focus); }
                 // Extend selection
@@ -648,12 +658,17 @@ void Fl_Tree::calc_dimensions() {
 /// The tree hierarchy's size only changes when items are added/removed,
 /// open/closed, label contents or font sizes changed, margins changed, etc.
 ///
-/// This calculation involves walking the *entire* tree from top to bottom,
-/// potentially a slow calculation if the tree has many items (potentially
-/// hundreds of thousands), and should therefore be called sparingly.
+/// Each item caches the size of itself and its open children. Changes
+/// made through the Fl_Tree_Item methods (e.g. open(), close(), label())
+/// invalidate only the changed item and its parents, so this calculation
+/// only walks the changed part of the tree, and unchanged subtrees are skipped
+/// even if they contain hundreds of thousands of items. The cached sizes
+/// are also used by draw() to skip all items outside the visible area.
 ///
-/// For this reason, recalc_tree() is used as a way to /schedule/
-/// calculation when changes affect the tree hierarchy's size.
+/// recalc_tree() is used as a way to /schedule/ calculation when changes
+/// affect the tree hierarchy's size. It invalidates the cached sizes of
+/// all items, so the next calculation walks the *entire* tree. Call it
+/// e.g. after resizing an item's widget().
 ///
 /// Apps may want to call this method directly if the app makes changes
 /// to the tree's geometry, then immediately needs to work with the tree's
@@ -678,6 +693,10 @@ void Fl_Tree::calc_tree() {
     W += _prefs.openicon_w();
   }
   int xmax = 0, render = 0, ytop = Y;
+  if ( _recalc_all ) {                                  // recalc_tree() called?
+    _root->invalidate_sizes();                          // ..then calc all items again
+    _recalc_all = 0;
+  }
   fl_font(_prefs.labelfont(), _prefs.labelsize());
   _root->draw(X, Y, W, 0, xmax, 1, render);             // descend into tree without drawing (render=0)
   // Save computed tree width and height
@@ -802,6 +821,7 @@ Fl_Tree_Item* Fl_Tree::root() {
 void Fl_Tree::root(Fl_Tree_Item *newitem) {
   if ( _root ) clear();
   _root = newitem;
+  if ( _filter ) _filter->invalidate();
 }
 
 /** Adds a new item, given a menu style \p 'path'.
@@ -910,6 +930,30 @@ Fl_Tree_Item* Fl_Tree::insert(Fl_Tree_Item *item, const char *name, int pos) {
   return(item->insert(_prefs, name, pos));
 }
 
+/**
+ Adds \p 'count' new children with the labels \p 'names' to \p 'parent_item'.
+
+ This does the same as calling add(parent_item, names[i]) for each name,
+ including the order given by sortorder(), but much faster: the names are
+ sorted once and merged with the existing children, and the child array
+ is enlarged only once.
+
+ Unlike add(const char*), the names are plain labels, not paths.
+ \param[in] parent_item The parent of the new items, or NULL for the root.
+ \param[in] names The labels of the new items.
+ \param[in] count The number of labels in \p 'names'.
+ \param[out] items If not NULL, receives the new items in the order of \p 'names'.
+ \returns The number of items added, or 0 if there is no root.
+ \see Fl_Tree_Item::add_children(), populate_callback()
+ \version 1.5.0
+*/
+int Fl_Tree::add_children(Fl_Tree_Item *parent_item, const char * const *names, int count,
+                          Fl_Tree_Item **items) {
+  if ( !parent_item ) parent_item = _root;
+  if ( !parent_item ) return(0);
+  return(parent_item->add_children(_prefs, names, count, items));
+}
+
 /// Remove the specified \p 'item' from the tree.
 /// \p item may not be NULL.
 /// If it has children, all those are removed too.
@@ -939,6 +983,7 @@ void Fl_Tree::clear() {
   delete _root; _root = 0;
   _item_focus = 0;
   _lastselect = 0;
+  if ( _filter ) _filter->invalidate();
 }
 
 /// Clear all the children for \p 'item'.
@@ -951,6 +996,82 @@ void Fl_Tree::clear_children(Fl_Tree_Item *item) {
   }
 }
 
+// Applies items posted by other threads, called by the main thread.
+// The whole batch is drawn with a single redraw.
+static void apply_posted_cb(void *target, const Fl_Update_Queue::Op *ops, int n) {
+  Fl_Tree *tree = (Fl_Tree*)target;
+  for (int i = 0; i < n; i++) {
+    const Fl_Update_Queue::Op &op = ops[i];
+    switch (op.code) {
+      case Fl_Update_Queue::ADD:
+        tree->add(op.str);
+        break;
+      case Fl_Update_Queue::REMOVE: {
+        Fl_Tree_Item *item = tree->find_item(op.str);
+        if ( item ) tree->remove(item);
+        break;
+      }
+      case Fl_Update_Queue::CLEAR:
+        tree->clear();
+        break;
+    }
+  }
+  tree->redraw();
+}
+
+/**
+ Adds a new item given a menu style \p 'path', can be called from any thread.
+
+ The post_xxx() methods can be called by other threads \b without holding
+ the global FLTK lock (Fl::lock()). The changes are staged in a queue of
+ this tree and applied in order by the main thread before the next
+ Fl::flush(), followed by a single redraw(). Since items are created later
+ no Fl_Tree_Item pointer is returned, use find_item() in the main thread.
+
+ As for all multithreaded FLTK programs the main thread must have called
+ Fl::lock() once to enable thread support.
+
+ \param[in] path The path to the item, e.g. "Flintstone/Fred".
+ \see add(const char*, Fl_Tree_Item*)
+ \version 1.5.0
+*/
+void Fl_Tree::post_add(const char *path) {
+  Fl_Update_Queue::post(_update_queue, this, apply_posted_cb, Fl_Update_Queue::ADD, 0, 0, 0.0, 0, path);
+}
+
+/// Removes the item given by menu style \p 'path' and all its children,
+/// can be called from any thread. Nothing happens if the item does not exist
+/// when the change is applied.
+/// \see post_add(), remove()
+/// \version 1.5.0
+///
+void Fl_Tree::post_remove(const char *path) {
+  Fl_Update_Queue::post(_update_queue, this, apply_posted_cb, Fl_Update_Queue::REMOVE, 0, 0, 0.0, 0, path);
+}
+
+/// Clears the entire tree, can be called from any thread.
+/// \see post_add(), clear()
+/// \version 1.5.0
+///
+void Fl_Tree::post_clear() {
+  Fl_Update_Queue::post(_update_queue, this, apply_posted_cb, Fl_Update_Queue::CLEAR);
+}
+
+/// Returns the number of posted changes that have not yet been taken over
+/// by the main thread. Can be called from any thread.
+/// \version 1.5.0
+///
+int Fl_Tree::posted() const {
+  return Fl_Update_Queue::pending(_update_queue);
+}
+
+/// Applies all posted changes immediately. Must be called by the main thread.
+/// \version 1.5.0
+///
+void Fl_Tree::apply_posted() {
+  Fl_Update_Queue::flush(_update_queue);
+}
+
 /**
  Find the item, given a menu style path, e.g. "/Parent/Child/item".
  There is both a const and non-const version of this method.
@@ -1059,6 +1180,8 @@ int Fl_Tree::item_pathname(char *pathname, int pathnamelen, const Fl_Tree_Item *
 ///
 const Fl_Tree_Item* Fl_Tree::find_clicked(int yonly) const {
   if ( ! _root ) return(NULL);
+  if ( _tree_w == -1 )                          // item positions depend on the tree's sizes
+    const_cast<Fl_Tree*>(this)->calc_tree();
   return(_root->find_clicked(_prefs, yonly));
 }
 
@@ -2361,7 +2484,30 @@ void Fl_Tree::item_draw_mode(int mode) {
 int Fl_Tree::displayed(Fl_Tree_Item *item) {
   item = item ? item : first();
   if (!item) return(0);
-  return( (item->y() >= y()) && (item->y() <= (y()+h()-item->h())) ? 1 : 0);
+  int Y = item_y(item);
+  return( (Y >= y()) && (Y <= (y()+h()-item_h(item))) ? 1 : 0);
+}
+
+// Internal: Returns the y position of \p 'item' relative to the window.
+//    Computed from the cached sizes of the items, because items scrolled
+//    out of view are not drawn and their y() is outdated.
+//
+int Fl_Tree::item_y(Fl_Tree_Item *item) {
+  if ( _tree_w == -1 ) calc_tree();
+  if ( !item->is_visible_r() ) return(item->y());       // not in the tree's layout
+  int Y = _tiy + _prefs.margintop() - (int)_vscroll->value();
+  for ( Fl_Tree_Item *p = item; p->parent(); p = p->parent() ) {
+    Fl_Tree_Item *parent = p->parent();
+    Y += p->_child_y;                                   // offset within parent's children
+    if ( !parent->is_root() || _prefs.showroot() )
+      Y += parent->calc_item_height(_prefs) + _prefs.linespacing();
+  }
+  return(Y);
+}
+
+// Internal: Returns the height of \p 'item', even if it was not drawn yet.
+int Fl_Tree::item_h(Fl_Tree_Item *item) {
+  return(item->calc_item_height(_prefs));
 }
 
 /// Adjust the vertical scrollbar so that \p 'item' is visible
@@ -2381,7 +2527,7 @@ int Fl_Tree::displayed(Fl_Tree_Item *item) {
 void Fl_Tree::show_item(Fl_Tree_Item *item, int yoff) {
   item = item ? item : first();
   if (!item) return;
-  int newval = item->y() - y() - yoff + (int)_vscroll->value();
+  int newval = item_y(item) - y() - yoff + (int)_vscroll->value();
   if ( newval < _vscroll->minimum() ) newval = (int)_vscroll->minimum();
   if ( newval > _vscroll->maximum() ) newval = (int)_vscroll->maximum();
   _vscroll->value(newval);
@@ -2418,7 +2564,7 @@ void Fl_Tree::show_item_top(Fl_Tree_Item *item) {
 ///
 void Fl_Tree::show_item_middle(Fl_Tree_Item *item) {
   item = item ? item : first();
-  if (item) show_item(item, (_tih/2)-(item->h()/2));
+  if (item) show_item(item, (_tih/2)-(item_h(item)/2));
 }
 
 /// Adjust the vertical scrollbar so that \p 'item' is at the bottom of the display.
@@ -2427,7 +2573,7 @@ void Fl_Tree::show_item_middle(Fl_Tree_Item *item) {
 ///
 void Fl_Tree::show_item_bottom(Fl_Tree_Item *item) {
   item = item ? item : first();
-  if (item) show_item(item, _tih-item->h());
+  if (item) show_item(item, _tih-item_h(item));
 }
 
 /// Displays \p 'item', scrolling the tree as necessary.
@@ -2438,6 +2584,63 @@ void Fl_Tree::display(Fl_Tree_Item *item) {
   if (item) show_item_middle(item);
 }
 
+/// Shows only the items whose label contains \p 'text', and their parents.
+///
+/// All other items are hidden (see Fl_Tree_Item::visible()). The root
+/// is always shown. Items are not opened or closed, so a matching item
+/// may still be inside a close()ed parent. filter() uses its own flag, so
+/// items that were hidden otherwise stay hidden, also after filter("").
+///
+/// The tree keeps an index of the labels of all items, so calling filter()
+/// for each character the user types is fast: when \p 'text' grows, only
+/// the items that matched before are searched, the previous results are
+/// reused when it shrinks again, and only the items whose result changed
+/// and their parents are updated. Items added or relabeled later are
+/// shown until filter() is called again.
+///
+/// \param[in] text The text to search for, NULL or "" shows all items
+/// \param[in] caseinsensitive Non-zero to ignore the case of letters
+/// \returns The number of items whose label contains \p 'text', not counting the root
+///
+int Fl_Tree::filter(const char *text, int caseinsensitive) {
+  if ( !_root ) return(0);
+  int rebuilt = 0;
+  if ( !_filter || !_filter->valid() ||
+       _filter->caseinsensitive() != (caseinsensitive != 0) ) {
+    delete _filter;
+    _filter = new Fl_Filter_Index(caseinsensitive != 0);
+    for ( Fl_Tree_Item *item = _root->next(); item; item = item->next() ) {
+      _filter->add(item, item->label());
+      item->_filter_count = 0;                  // counted again below
+      item->_flags |= Fl_Tree_Item::FILTERED;
+    }
+    rebuilt = 1;
+  }
+  std::vector<int> changed;
+  int count = _filter->match(text, changed);
+  if ( changed.empty() ) return(count);
+  // An item is shown if its label or one in its subtree matches, so each
+  // item counts the matching items of its subtree. Only the items whose
+  // match changed and their parents are updated.
+  for ( size_t k=0; k<changed.size(); k++ ) {
+    int matched = _filter->matched(changed[k]);
+    if ( rebuilt && !matched ) continue;        // all counts start at 0
+    int delta = matched ? 1 : -1;
+    for ( Fl_Tree_Item *p = (Fl_Tree_Item*)_filter->item(changed[k]);
+          p && p != _root; p = p->_parent ) {
+      p->_filter_count += delta;
+      if ( p->_filter_count > 0 ) p->_flags &= ~Fl_Tree_Item::FILTERED;
+      else                        p->_flags |= Fl_Tree_Item::FILTERED;
+      p->_subtree_h = -1;                       // see Fl_Tree_Item::recalc_tree()
+    }
+  }
+  _root->_subtree_h = -1;
+  _tree_w = _tree_h = -1;
+  vposition(0);
+  redraw();
+  return(count);
+}
+
 /// Returns the vertical scroll position as a pixel offset.
 /// The position returned is how many pixels of the tree are scrolled off the top edge
 /// of the screen.
@@ -2623,6 +2826,58 @@ Fl_Tree_Reason Fl_Tree::callback_reason() const {
   return(_callback_reason);
 }
 
+/**
+ Sets the callback that adds the children of items on demand.
+
+ When an item with Fl_Tree_Item::lazy_children() set is opened the first
+ time, \p 'cb' is called with the item and \p 'data' before the item is
+ opened. The callback should add the item's children, e.g. with
+ add_children(). If it adds none, the item is shown open without children.
+
+ This allows to show very large hierarchies where only the items the
+ user actually opens are created, e.g. a file system:
+ \par
+ \code
+ static void populate_cb(Fl_Tree_Item *item, void *data) {
+   Fl_Tree *tree = (Fl_Tree*)data;
+   char path[FL_PATH_MAX];
+   tree->item_pathname(path, sizeof(path), item);
+   // ..read the directory 'path' into 'names' and 'count'..
+   Fl_Tree_Item **items = new Fl_Tree_Item*[count];
+   tree->add_children(item, names, count, items);
+   for (int i = 0; i < count; i++)
+     if (is_dir(names[i])) items[i]->lazy_children(1);  // populate when opened
+   delete[] items;
+ }
+ :
+ tree->populate_callback(populate_cb, tree);
+ tree->add("home")->lazy_children(1);
+ \endcode
+ \param[in] cb The callback, or NULL to disable it.
+ \param[in] data User data passed to the callback.
+ \see Fl_Tree_Item::lazy_children(int)
+ \version 1.5.0
+*/
+void Fl_Tree::populate_callback(Fl_Tree_Populate_Callback *cb, void *data) {
+  _populate_cb   = cb;
+  _populate_data = data;
+}
+
+/// Gets the callback that adds the children of items on demand.
+/// \see populate_callback(Fl_Tree_Populate_Callback*, void*)
+/// \version 1.5.0
+///
+Fl_Tree_Populate_Callback *Fl_Tree::populate_callback() const {
+  return(_populate_cb);
+}
+
+/// Gets the user data passed to populate_callback().
+/// \version 1.5.0
+///
+void *Fl_Tree::populate_user_data() const {
+  return(_populate_data);
+}
+
 /**
  Read a preferences database into the tree widget.
  A preferences database is a hierarchical collection of data which can be
@@ -2690,4 +2945,5 @@ void Fl_Tree::fix_scrollbar_order() {
 ///
 void Fl_Tree::recalc_tree() {
   _tree_w = _tree_h = -1;
+  _recalc_all = 1;
 }
@@ -8,6 +8,9 @@
 #include <FL/Fl_Tree.H>
 #include <FL/fl_string_functions.h>
 #include "Fl_System_Driver.H"
+#include "Fl_Filter_Index.H"
+
+#include <algorithm>
 
 //////////////////////
 // Fl_Tree_Item.cxx
@@ -72,6 +75,10 @@ void Fl_Tree_Item::_Init(const Fl_Tree_Prefs &prefs, Fl_Tree *tree) {
   _children.manage_item_destroy(1);     // let array's dtor manage destroying Fl_Tree_Items
   _prev_sibling     = 0;
   _next_sibling     = 0;
+  _subtree_h        = -1;
+  _subtree_w        = 0;
+  _child_y          = 0;
+  _filter_count     = 0;
 }
 
 /// Constructor.
@@ -113,7 +120,7 @@ Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _labelfgcolor = o->labelfgcolor();
   _labelbgcolor = o->labelbgcolor();
   _widget       = o->widget();
-  _flags        = o->_flags;
+  _flags        = o->_flags & ~FILTERED;  // not in the tree's filter index
   _xywh[0]      = o->_xywh[0];
   _xywh[1]      = o->_xywh[1];
   _xywh[2]      = o->_xywh[2];
@@ -131,6 +138,10 @@ Fl_Tree_Item::Fl_Tree_Item(const Fl_Tree_Item *o) {
   _parent           = o->_parent;
   _prev_sibling     = 0;                // do not copy ptrs! use update_prev_next()
   _next_sibling     = 0;                // do not copy ptrs! use update_prev_next()
+  _subtree_h        = -1;               // sizes are calculated when drawn
+  _subtree_w        = 0;
+  _child_y          = 0;
+  _filter_count     = 0;
 }
 
 /// Print the tree as 'ascii art' to stdout.
@@ -157,9 +168,12 @@ void Fl_Tree_Item::show_self(const char *indent) const {
 /// Makes and manages an internal copy of \p 'name'.
 ///
 void Fl_Tree_Item::label(const char *name) {
+  if ( _parent ) _parent->_children.index_remove(this); // parent's index refers to _label
   if ( _label ) { free((void*)_label); _label = 0; }
   _label = name ? fl_strdup(name) : 0;
+  if ( _parent ) _parent->_children.index_add(this, -1);
   recalc_tree();                // may change label geometry
+  invalidate_filter();
 }
 
 /// Return the label.
@@ -176,6 +190,7 @@ const Fl_Tree_Item *Fl_Tree_Item::child(int index) const {
 void Fl_Tree_Item::clear_children() {
   _children.clear();
   recalc_tree();                // may change tree geometry
+  invalidate_filter();
 }
 
 /// Return the index of the immediate child of this item
@@ -185,11 +200,11 @@ void Fl_Tree_Item::clear_children() {
 /// \version 1.3.0 release
 ///
 int Fl_Tree_Item::find_child(const char *name) {
-  if ( name ) {
+  const Fl_Tree_Item *item = _children.find(name);
+  if ( item ) {
     for ( int t=0; t<children(); t++ )
-      if ( child(t)->label() )
-        if ( strcmp(child(t)->label(), name) == 0 )
-          return(t);
+      if ( child(t) == item )
+        return(t);
   }
   return(-1);
 }
@@ -201,12 +216,7 @@ int Fl_Tree_Item::find_child(const char *name) {
 /// \version 1.3.3
 ///
 const Fl_Tree_Item* Fl_Tree_Item::find_child_item(const char *name) const {
-  if ( name )
-    for ( int t=0; t<children(); t++ )
-      if ( child(t)->label() )
-        if ( strcmp(child(t)->label(), name) == 0 )
-          return(child(t));
-  return(0);
+  return(_children.find(name));
 }
 
 /// Non-const version of Fl_Tree_Item::find_child_item(const char *name) const.
@@ -224,18 +234,10 @@ Fl_Tree_Item* Fl_Tree_Item::find_child_item(const char *name) {
 /// \version 1.3.0 release
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_child_item(char **arr) const {
-  for ( int t=0; t<children(); t++ ) {
-    if ( child(t)->label() ) {
-      if ( strcmp(child(t)->label(), *arr) == 0 ) {     // match?
-        if ( *(arr+1) ) {                               // more in arr? descend
-          return(_children[t]->find_child_item(arr+1));
-        } else {                                        // end of arr? done
-          return(_children[t]);
-        }
-      }
-    }
-  }
-  return(0);
+  const Fl_Tree_Item *item = _children.find(*arr);
+  if ( item && *(arr+1) )                               // more in arr? descend
+    return(item->find_child_item(arr+1));
+  return(item);                                         // end of arr? done
 }
 
 /// Non-const version of Fl_Tree_Item::find_child_item(char **arr) const.
@@ -308,6 +310,7 @@ Fl_Tree_Item *Fl_Tree_Item::add(const Fl_Tree_Prefs &prefs,
   if ( !item )
     { item = new Fl_Tree_Item(_tree); item->label(new_label); }
   recalc_tree();                // may change tree geometry
+  invalidate_filter();
   item->_parent = this;
   switch ( prefs.sortorder() ) {
     case FL_TREE_SORT_NONE: {
@@ -340,6 +343,80 @@ Fl_Tree_Item *Fl_Tree_Item::add(const Fl_Tree_Prefs &prefs,
   return(item);
 }
 
+// Orders labels for add_children(): NULL labels go last
+struct Fl_Tree_Label_Less {
+  int dir;                              // 1: ascending, -1: descending
+  bool operator()(const char *a, const char *b) const {
+    if ( !a || !b ) return(a && !b);
+    return(strcmp(a, b) * dir < 0);
+  }
+};
+
+/**
+  Add \p 'count' new children with the labels \p 'labels' and defaults
+  from \p 'prefs'.
+
+  The result is the same as calling add(prefs, labels[i]) for each label,
+  but the labels are sorted once (if prefs.sortorder() requires it) and
+  merged with the existing children in a single pass, and the array of
+  children is enlarged only once. So adding n children takes O(n log n)
+  time, or O(n) if the labels are already sorted, instead of O(n^2).
+
+  \param[in] prefs The tree's preferences.
+  \param[in] labels The labels of the new items, internal copies are made.
+  \param[in] count The number of labels.
+  \param[out] items If not NULL, receives the new items in the order of \p 'labels'.
+  \returns The number of items added.
+  \see Fl_Tree::add_children()
+  \version 1.5.0
+*/
+int Fl_Tree_Item::add_children(const Fl_Tree_Prefs &prefs,
+                               const char * const *labels, int count,
+                               Fl_Tree_Item **items) {
+  if ( count <= 0 ) return(0);
+  Fl_Tree_Item **newitems = new Fl_Tree_Item*[count];
+  int *pos = 0;
+  for ( int i=0; i<count; i++ ) {
+    newitems[i] = new Fl_Tree_Item(_tree);
+    newitems[i]->label(labels[i]);
+    newitems[i]->_parent = this;
+    if ( items ) items[i] = newitems[i];
+  }
+  if ( prefs.sortorder() != FL_TREE_SORT_NONE ) {
+    Fl_Tree_Label_Less less;
+    less.dir = (prefs.sortorder() == FL_TREE_SORT_ASCENDING) ? 1 : -1;
+    int sorted = 1;
+    for ( int i=1; i<count && sorted; i++ )
+      if ( less(newitems[i]->label(), newitems[i-1]->label()) ) sorted = 0;
+    if ( !sorted ) {
+      std::stable_sort(newitems, newitems+count,
+                       [&less](const Fl_Tree_Item *a, const Fl_Tree_Item *b) {
+                         return less(a->label(), b->label());
+                       });
+    }
+    // Like add(): insert each item before the first child whose label
+    // sorts after it. These positions only grow with the sorted labels.
+    pos = new int[count];
+    int t = 0;
+    for ( int i=0; i<count; i++ ) {
+      const char *l = newitems[i]->label();
+      if ( !l ) t = _children.total();
+      while ( t < _children.total() ) {
+        const char *c = _children[t]->label();
+        if ( c && less(l, c) ) break;
+        t++;
+      }
+      pos[i] = t;
+    }
+  }
+  _children.insert(pos, newitems, count);
+  delete[] pos;
+  delete[] newitems;
+  recalc_tree();                // may change tree geometry
+  invalidate_filter();
+  return(count);
+}
+
 /// Descend into the path specified by \p 'arr', and add a new child there.
 /// Should be used only by Fl_Tree's internals.
 /// Adds the item based on the value of prefs.sortorder().
@@ -407,6 +484,7 @@ Fl_Tree_Item *Fl_Tree_Item::insert(const Fl_Tree_Prefs &prefs, const char *new_l
   item->_parent = this;
   _children.insert(pos, item);
   recalc_tree();                // may change tree geometry
+  invalidate_filter();
   return(item);
 }
 
@@ -442,6 +520,8 @@ Fl_Tree_Item *Fl_Tree_Item::insert_above(const Fl_Tree_Prefs &prefs, const char
 Fl_Tree_Item* Fl_Tree_Item::deparent(int pos) {
   Fl_Tree_Item *orphan = _children[pos];
   if ( _children.deparent(pos) < 0 ) return NULL;
+  recalc_tree();                // may change tree geometry
+  invalidate_filter();
   return orphan;
 }
 
@@ -457,6 +537,8 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
   int ret;
   if ( (ret = _children.reparent(newchild, this, pos)) < 0 ) return ret;
   newchild->parent(this);               // take custody
+  recalc_tree();                        // may change tree geometry
+  invalidate_filter();
   return 0;
 }
 
@@ -470,7 +552,9 @@ int Fl_Tree_Item::reparent(Fl_Tree_Item *newchild, int pos) {
 /// \see move_above(), move_below(), move_into(), move(Fl_Tree_Item*,int,int)
 ///
 int Fl_Tree_Item::move(int to, int from) {
-  return _children.move(to, from);
+  int ret = _children.move(to, from);
+  if ( ret == 0 ) recalc_tree();        // moves the children's positions
+  return ret;
 }
 
 /// Move the current item above/below/into the specified \p 'item',
@@ -635,6 +719,7 @@ Fl_Tree_Item *Fl_Tree_Item::replace_child(Fl_Tree_Item *olditem,
   // replace in array (handles stitching neighboring items)
   _children.replace(pos, newitem);
   recalc_tree();                        // newitem may have changed tree geometry
+  invalidate_filter();
   return newitem;
 }
 
@@ -647,6 +732,7 @@ int Fl_Tree_Item::remove_child(Fl_Tree_Item *item) {
       item->clear_children();
       _children.remove(t);
       recalc_tree();            // may change tree geometry
+      invalidate_filter();
       return(0);
     }
   }
@@ -666,6 +752,7 @@ int Fl_Tree_Item::remove_child(const char *name) {
       if ( strcmp(child(t)->label(), name) == 0 ) {
         _children.remove(t);
         recalc_tree();          // may change tree geometry
+        invalidate_filter();
         return(0);
       }
     }
@@ -681,6 +768,7 @@ int Fl_Tree_Item::remove_child(const char *name) {
 ///
 void Fl_Tree_Item::swap_children(int ax, int bx) {
   _children.swap(ax, bx);
+  recalc_tree();                // moves the children's positions
 }
 
 /// Swap two of our immediate children, given item pointers.
@@ -771,6 +859,8 @@ void Fl_Tree_Item::draw_vertical_connector(int x, int y1, int y2, const Fl_Tree_
 ///
 const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) const {
   if ( ! is_visible() ) return(0);
+  if ( _subtree_h >= 0 )                        // cached sizes valid? only walk down to the event
+    return(find_clicked_at(prefs, yonly, _xywh[1]));
   if ( is_root() && !prefs.showroot() ) {
     // skip event check if we're root but root not being shown
   } else {
@@ -796,6 +886,42 @@ const Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int y
   return(0);
 }
 
+// Internal: find_clicked() using the cached sizes, with this item at position Y.
+//    Only the items containing the event's y position are visited, which
+//    avoids walking large trees and ignores the outdated positions of items
+//    that were not drawn because they were scrolled out of view.
+//
+const Fl_Tree_Item *Fl_Tree_Item::find_clicked_at(const Fl_Tree_Prefs &prefs, int yonly, int Y) const {
+  int ey = Fl::event_y();
+  if ( is_root() && !prefs.showroot() ) {
+    // skip event check if we're root but root not being shown
+  } else {
+    int H = calc_item_height(prefs);
+    if ( yonly ) {
+      if ( ey >= Y && ey <= Y+H ) return(this);
+    } else {
+      if ( Fl::event_inside(_xywh[0], Y, _xywh[2], H) ) return(this);
+    }
+    Y += H + prefs.linespacing();
+  }
+  if ( !is_open() ) return(0);
+  // Binary search for the first child that ends at or below the event
+  int lo = 0, hi = children();
+  while ( lo < hi ) {
+    int mid = (lo + hi) / 2;
+    if ( Y + _children[mid]->_child_y + _children[mid]->_subtree_h < ey ) lo = mid + 1;
+    else hi = mid;
+  }
+  for ( int t=lo; t<children(); t++ ) {
+    const Fl_Tree_Item *c = _children[t];
+    if ( Y + c->_child_y > ey ) break;          // below the event
+    if ( !c->is_visible() ) continue;
+    const Fl_Tree_Item *item = c->find_clicked_at(prefs, yonly, Y + c->_child_y);
+    if ( item ) return(item);
+  }
+  return(0);
+}
+
 /// Non-const version of Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs&,int) const
 Fl_Tree_Item *Fl_Tree_Item::find_clicked(const Fl_Tree_Prefs &prefs, int yonly) {
   // "Effective C++, 3rd Ed", p.23. Sola fide, Amen.
@@ -824,7 +950,7 @@ int Fl_Tree_Item::calc_item_height(const Fl_Tree_Prefs &prefs) const {
        H < widget()->h()) {
     H = widget()->h();
   }
-  if ( has_children() && H < prefs.openicon_h() )
+  if ( has_collapse_icon() && H < prefs.openicon_h() )
     H = prefs.openicon_h();
   if ( usericon() && H<usericon()->h() )
     H = usericon()->h();
@@ -977,7 +1103,14 @@ int Fl_Tree_Item::draw_item_content(int render) {
 void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
                         int &tree_item_xmax, int lastchild, int render) {
   Fl_Tree_Prefs &prefs = _tree->_prefs;
-  if ( !is_visible() ) return;
+  if ( !is_visible() ) {
+    if ( !render ) {                    // hidden items take no space
+      _subtree_h = _subtree_w = 0;
+      _flags &= ~SUBTREE_WIDGETS;
+    }
+    return;
+  }
+  int item_top = Y;
   int tree_top = tree()->_tiy;
   int tree_bot = tree_top + tree()->_tih;
   int H = calc_item_height(prefs);      // height of item
@@ -1079,7 +1212,7 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
           }
         }
         // Draw collapse icon
-        if ( render && has_children() && prefs.showcollapse() ) {
+        if ( render && has_collapse_icon() && prefs.showcollapse() ) {
           // Draw icon image
           if ( is_open() ) {
             if ( prefs.closeicon() ) {
@@ -1131,18 +1264,58 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
     }                   // end drawthis
   }                     // end clipped
   if ( drawthis ) Y += H2;                                      // adjust Y (even if clipped)
-  // Manage tree_item_xmax
-  if ( xmax > tree_item_xmax )
-    tree_item_xmax = xmax;
+  char widgets = widget() ? 1 : 0;      // item or open children have widgets?
   // Draw child items (if any)
   if ( has_children() && is_open() ) {
     int child_x = drawthis ? (hconn_x_center - (icon_w/2) + 1)  // offset children to right,
                            : X;                                 // unless didn't drawthis
     int child_w = W - (child_x-X);
     int child_y_start = Y;
-    for ( int t=0; t<children(); t++ ) {
+    // If our cached sizes are valid, the children's positions are known
+    // without walking them: only draw the children inside the viewport.
+    // Children with widgets are always walked to keep the widgets' positions
+    // up to date.
+    char cull = (render && _subtree_h >= 0) ? 1 : 0;
+    int t = 0;
+    if ( cull && !is_flag(SUBTREE_WIDGETS) ) {
+      // Binary search for the first child that ends inside the viewport
+      int lo = 0, hi = children();
+      while ( lo < hi ) {
+        int mid = (lo + hi) / 2;
+        const Fl_Tree_Item *c = _children[mid];
+        if ( child_y_start + c->_child_y + c->_subtree_h < tree_top ) lo = mid + 1;
+        else hi = mid;
+      }
+      t = lo;
+    }
+    for ( ; t<children(); t++ ) {
+      Fl_Tree_Item *c = _children[t];
       int is_lastchild = ((t+1)==children()) ? 1 : 0;
-      _children[t]->draw(child_x, Y, child_w, itemfocus, tree_item_xmax, is_lastchild, render);
+      if ( cull ) {
+        Y = child_y_start + c->_child_y;
+        if ( !c->is_flag(SUBTREE_WIDGETS) ) {
+          if ( Y + c->_subtree_h < tree_top ) continue;         // above viewport
+          if ( Y > tree_bot ) {                                 // below viewport
+            if ( is_flag(SUBTREE_WIDGETS) ) continue;           // widgets may follow
+            break;
+          }
+        }
+      } else if ( !render && c->_subtree_h >= 0 ) {
+        // Calculating sizes and child's sizes are still valid: skip it
+        c->_child_y = Y - child_y_start;
+        Y += c->_subtree_h;
+        if ( c->_subtree_w > 0 && child_x + c->_subtree_w > xmax )
+          xmax = child_x + c->_subtree_w;
+        if ( c->is_flag(SUBTREE_WIDGETS) ) widgets = 1;
+        continue;
+      }
+      if ( !render ) c->_child_y = Y - child_y_start;
+      c->draw(child_x, Y, child_w, itemfocus, xmax, is_lastchild, render);
+      if ( c->is_flag(SUBTREE_WIDGETS) ) widgets = 1;
+    }
+    if ( cull ) {                       // skip the children below the viewport
+      const Fl_Tree_Item *c = _children[children()-1];
+      Y = child_y_start + c->_child_y + c->_subtree_h;
     }
     if ( has_children() && is_open() ) {
       Y += prefs.openchild_marginbottom();              // offset below open child tree
@@ -1178,13 +1351,23 @@ void Fl_Tree_Item::draw(int X, int &Y, int W, Fl_Tree_Item *itemfocus,
       }
     }
   }
+  // Manage tree_item_xmax
+  if ( xmax > tree_item_xmax )
+    tree_item_xmax = xmax;
+  // Cache our size for the next calculation and for drawing
+  if ( !render ) {
+    _subtree_h = Y - item_top;
+    _subtree_w = xmax > X ? xmax - X : 0;
+    if ( widgets ) _flags |= SUBTREE_WIDGETS;
+    else           _flags &= ~SUBTREE_WIDGETS;
+  }
 }
 
 
 /// Was the event on the 'collapse' button of this item?
 ///
 int Fl_Tree_Item::event_on_collapse_icon(const Fl_Tree_Prefs &prefs) const {
-  if ( is_visible() && is_active() && has_children() && prefs.showcollapse() ) {
+  if ( is_visible() && is_active() && has_collapse_icon() && prefs.showcollapse() ) {
     return(event_inside(_collapse_xywh) ? 1 : 0);
   } else {
     return(0);
@@ -1255,7 +1438,16 @@ void Fl_Tree_Item::hide_widgets() {
 }
 
 /// Open this item and all its children.
+///
+/// If lazy_children() is set, it is cleared and the tree's
+/// Fl_Tree::populate_callback() is called to add the children first.
+///
 void Fl_Tree_Item::open() {
+  if ( is_flag(LAZY_CHILDREN) ) {
+    set_flag(LAZY_CHILDREN,0);          // populate only once
+    if ( _tree && _tree->populate_callback() )
+      _tree->populate_callback()(this, _tree->populate_user_data());
+  }
   set_flag(OPEN,1);
   // Tell children to show() their widgets
   for ( int t=0; t<_children.total(); t++ ) {
@@ -1264,6 +1456,26 @@ void Fl_Tree_Item::open() {
   recalc_tree();                // may change tree geometry
 }
 
+/// Mark this item's children to be added when it is opened the first time.
+///
+/// If \p 'val' is non-zero, the item is closed and shows the open icon
+/// even if it has no children yet. When it is opened with open() (e.g. by
+/// the user clicking on the icon), the flag is cleared and the tree's
+/// Fl_Tree::populate_callback() is called, which should add the children,
+/// e.g. with add_children() or Fl_Tree::add_children().
+///
+/// This way trees that show large hierarchies (file systems, databases)
+/// only create the items the user actually looks at.
+///
+/// \see Fl_Tree::populate_callback(), lazy_children()
+/// \version 1.5.0
+///
+void Fl_Tree_Item::lazy_children(int val) {
+  set_flag(LAZY_CHILDREN, val);
+  if ( val ) set_flag(OPEN,0);
+  recalc_tree();                // may change the collapse icon
+}
+
 /// Close this item and all its children.
 void Fl_Tree_Item::close() {
   set_flag(OPEN,0);
@@ -1475,8 +1687,30 @@ int Fl_Tree_Item::is_visible_r() const {
 /// Call this when our geometry is changed. (Font size, label contents, etc)
 /// Schedules tree to recalculate itself, as changes to us may affect tree
 /// widget's scrollbar visibility and tab sizes.
+///
+/// Only the cached sizes of this item and its parents are invalidated,
+/// so the next calculation walks just the changed part of the tree.
 /// \version 1.3.3 ABI
 ///
 void Fl_Tree_Item::recalc_tree() {
-  _tree->recalc_tree();
+  for ( Fl_Tree_Item *p = this; p; p = p->_parent )
+    p->_subtree_h = -1;
+  if ( _tree ) _tree->_tree_w = _tree->_tree_h = -1;
+}
+
+/// Internal: Call this when labels or items of the tree were changed.
+/// The next Fl_Tree::filter() builds a new index of the labels.
+///
+void Fl_Tree_Item::invalidate_filter() {
+  if ( _tree && _tree->_filter ) _tree->_filter->invalidate();
+}
+
+/// Internal: Invalidates the cached sizes of this item and all its children,
+/// including closed ones. Used when the tree's preferences changed.
+///
+void Fl_Tree_Item::invalidate_sizes() {
+  _subtree_h = -1;
+  for ( int t=0; t<_children.total(); t++ ) {
+    _children[t]->invalidate_sizes();
+  }
 }
@@ -6,6 +6,7 @@
 
 #include <FL/Fl_Tree_Item_Array.H>
 #include <FL/Fl_Tree_Item.H>
+#include "Fl_Tree_Label_Index.H"
 
 //////////////////////
 // Fl_Tree_Item_Array.cxx
@@ -36,6 +37,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(int new_chunksize) {
   _size      = 0;
   _flags     = 0;
   _chunksize = new_chunksize;
+  _index     = 0;
 }
 
 /// Destructor. Calls each item's destructor, destroys internal _items array.
@@ -50,6 +52,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(const Fl_Tree_Item_Array* o) {
   _size      = o->_size;
   _chunksize = o->_chunksize;
   _flags     = o->_flags;
+  _index     = 0;
   for ( int t=0; t<o->_total; t++ ) {
     if ( _flags & MANAGE_ITEM ) {
       _items[t] = new Fl_Tree_Item(o->_items[t]);       // make new copy of item
@@ -68,6 +71,7 @@ Fl_Tree_Item_Array::Fl_Tree_Item_Array(const Fl_Tree_Item_Array* o) {
 ///     and the array will be cleared. total() will return 0.
 ///
 void Fl_Tree_Item_Array::clear() {
+  drop_index();
   if ( _items ) {
     for ( int t=0; t<_total; t++ ) {
       if ( _flags & MANAGE_ITEM )
@@ -84,6 +88,8 @@ void Fl_Tree_Item_Array::clear() {
 // Internal: Enlarge the items array.
 //
 //    Adjusts size/items memory allocation as needed.
+//    Grows by at least half the current size, so that adding n items
+//    one by one copies the array only O(log n) times.
 //    Does NOT change total.
 //
 void Fl_Tree_Item_Array::enlarge(int count) {
@@ -92,18 +98,26 @@ void Fl_Tree_Item_Array::enlarge(int count) {
     if ( (newtotal/150) > _chunksize ) _chunksize *= 10;
     // Increase size of array
     int newsize = _size + _chunksize;
-    Fl_Tree_Item **newitems = (Fl_Tree_Item**)malloc(newsize * sizeof(Fl_Tree_Item*));
-    if ( _items ) {
-      // Copy old array -> new, delete old
-      memmove(newitems, _items, _size * sizeof(Fl_Tree_Item*));
-      free((void*)_items); _items = 0;
-    }
-    // Adjust items/sizeitems
-    _items = newitems;
+    if ( newsize < _size + _size/2 ) newsize = _size + _size/2;
+    if ( newsize <= newtotal ) newsize = newtotal + 1;
+    _items = (Fl_Tree_Item**)realloc((void*)_items, newsize * sizeof(Fl_Tree_Item*));
     _size = newsize;
   }
 }
 
+/// Makes room for \p 'count' more items with a single allocation.
+///
+///     Use this before adding many items one by one.
+///     Does NOT change total.
+///
+void Fl_Tree_Item_Array::reserve(int count) {
+  int newtotal = _total + count;
+  if ( newtotal >= _size ) {
+    _items = (Fl_Tree_Item**)realloc((void*)_items, (newtotal+1) * sizeof(Fl_Tree_Item*));
+    _size = newtotal + 1;
+  }
+}
+
 /// Insert an item at index position \p pos.
 ///
 ///     Handles enlarging array if needed, total increased by 1.
@@ -127,6 +141,40 @@ void Fl_Tree_Item_Array::insert(int pos, Fl_Tree_Item *new_item) {
   {
     _items[pos]->update_prev_next(pos); // adjust item's prev/next and its neighbors
   }
+  index_add(new_item, pos);
+}
+
+/// Insert \p 'count' items at once.
+///
+///     Item \p new_items[k] is inserted before the item that was at
+///     index \p pos[k] before this call, or appended if \p pos[k] \>= total().
+///     The \p pos values must be in ascending order. If \p pos is NULL,
+///     all items are appended.
+///
+///     The array is enlarged at most once and each item is moved at most
+///     once, so this is much faster than inserting the items one by one.
+///
+void Fl_Tree_Item_Array::insert(const int *pos, Fl_Tree_Item **new_items, int count) {
+  if ( count <= 0 ) return;
+  reserve(count);
+  // Merge from the end, so that each existing item is moved only once
+  int src = _total;                     // items before src are not moved yet
+  int dst = _total + count;             // items from dst on are in place
+  int first = _total;                   // lowest index that changed
+  for ( int k=count-1; k>=0; k-- ) {
+    int p = pos ? pos[k] : _total;
+    if ( p < 0 ) p = 0;
+    while ( src > p ) _items[--dst] = _items[--src];
+    _items[--dst] = new_items[k];
+    first = dst;
+  }
+  _total += count;
+  if ( _flags & MANAGE_ITEM ) {
+    for ( int t=first; t<_total; t++ )
+      _items[t]->update_prev_next(t);
+  }
+  for ( int k=0; k<count && _index; k++ )
+    index_add(new_items[k], -1);
 }
 
 /// Add an item* to the end of the array.
@@ -145,6 +193,7 @@ void Fl_Tree_Item_Array::add(Fl_Tree_Item *val) {
 /// and the new item will take it's place, and stitched into the linked list.
 ///
 void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
+  if ( _items[index] ) index_remove(_items[index]);
   if ( _items[index] ) {                        // delete if non-zero
     if ( _flags & MANAGE_ITEM )
       // Destroy old item
@@ -156,6 +205,7 @@ void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
     // Restitch into linked list
     _items[index]->update_prev_next(index);
   }
+  index_add(newitem, index);
 }
 
 /// Remove the item at \param[in] index from the array.
@@ -163,6 +213,7 @@ void Fl_Tree_Item_Array::replace(int index, Fl_Tree_Item *newitem) {
 ///     The item will be delete'd (if non-NULL), so its destructor will be called.
 ///
 void Fl_Tree_Item_Array::remove(int index) {
+  if ( _items[index] ) index_remove(_items[index]);
   if ( _items[index] ) {                        // delete if non-zero
     if ( _flags & MANAGE_ITEM )
       delete _items[index];
@@ -199,6 +250,8 @@ int Fl_Tree_Item_Array::remove(Fl_Tree_Item *item) {
 
 /// Swap the two items at index positions \p ax and \p bx.
 void Fl_Tree_Item_Array::swap(int ax, int bx) {
+  index_moved(_items[ax]);                      // first of equal labels may change
+  index_moved(_items[bx]);
   Fl_Tree_Item *asave = _items[ax];
   _items[ax] = _items[bx];
   _items[bx] = asave;
@@ -221,6 +274,7 @@ void Fl_Tree_Item_Array::swap(int ax, int bx) {
 int Fl_Tree_Item_Array::move(int to, int from) {
   if ( from == to ) return 0;    // nop
   if ( to<0 || to>=_total || from<0 || from>=_total ) return -1;
+  index_moved(_items[from]);                    // first of equal labels may change
   Fl_Tree_Item *item = _items[from];
   // Remove item..
   if ( from < to )
@@ -250,6 +304,7 @@ int Fl_Tree_Item_Array::deparent(int pos) {
   Fl_Tree_Item *item = _items[pos];
   Fl_Tree_Item *prev = item->prev_sibling();
   Fl_Tree_Item *next = item->next_sibling();
+  index_remove(item);
   // Remove from parent's list of children
   _total -= 1;
   for ( int t=pos; t<_total; t++ )
@@ -278,5 +333,82 @@ int Fl_Tree_Item_Array::reparent(Fl_Tree_Item *item, Fl_Tree_Item* newparent, in
   // Attach to new parent and siblings
   _items[pos]->parent(newparent);       // reparent (update_prev_next() needs this)
   _items[pos]->update_prev_next(pos);   // find new siblings
+  index_add(item, pos);
+  return 0;
+}
+
+/// Find the first item with the label \p 'label'.
+///
+///     Large arrays build a hash index of the labels on first use,
+///     so that this takes constant time instead of comparing all labels.
+///     The index is kept up to date when items are added or removed.
+///
+///     \returns the item, or NULL if not found (or if \p label is NULL)
+///
+const Fl_Tree_Item *Fl_Tree_Item_Array::find(const char *label) const {
+  if ( !label ) return 0;
+  if ( !_index && _total >= INDEX_MIN ) build_index();
+  if ( _index ) {
+    Fl_Tree_Label_Index::Entry *e = _index->find(label);
+    if ( !e ) return 0;
+    if ( e->first ) return e->first;
+    for ( int t=0; t<_total; t++ ) {            // first item not known: look it up
+      const char *l = _items[t]->label();
+      if ( l && strcmp(l, label) == 0 ) return e->first = _items[t];
+    }
+    return 0;
+  }
+  for ( int t=0; t<_total; t++ ) {
+    const char *l = _items[t]->label();
+    if ( l && strcmp(l, label) == 0 ) return _items[t];
+  }
   return 0;
 }
+
+// Internal: Build the label index of all items
+void Fl_Tree_Item_Array::build_index() const {
+  _index = new Fl_Tree_Label_Index;
+  _index->reserve(_total);
+  for ( int t=0; t<_total; t++ ) {
+    const char *label = _items[t]->label();
+    if ( !label ) continue;
+    Fl_Tree_Label_Index::Entry &e = _index->entry(label);
+    if ( !e.count++ ) e.first = _items[t];      // keep the first one
+  }
+}
+
+// Internal: Delete the label index, find() will build it again
+void Fl_Tree_Item_Array::drop_index() {
+  delete _index;
+  _index = 0;
+}
+
+// Internal: Add 'item' at index 'pos' (-1 if unknown) to the label index
+void Fl_Tree_Item_Array::index_add(Fl_Tree_Item *item, int pos) {
+  if ( !_index || !item->label() ) return;
+  Fl_Tree_Label_Index::Entry &e = _index->entry(item->label());
+  if ( e.first == item ) return;
+  if ( !e.count++ ) { e.first = item; return; }
+  // Another item has the same label: an item appended at the end can't be
+  // the first one, an item inserted at 0 is. Otherwise find() looks it up.
+  if ( pos == 0 ) e.first = item;
+  else if ( pos < 0 || pos < _total-1 ) e.first = 0;
+}
+
+// Internal: Remove 'item' from the label index.
+//    Must be called before the item is removed or its label is changed.
+//
+void Fl_Tree_Item_Array::index_remove(Fl_Tree_Item *item) {
+  if ( !_index || !item->label() ) return;
+  Fl_Tree_Label_Index::Entry *e = _index->find(item->label());
+  if ( !e ) return;
+  if ( --e->count <= 0 ) _index->erase(item->label());
+  else if ( e->first == item ) e->first = 0;    // next item with this label not known
+}
+
+// Internal: 'item' changes its position relative to the other items
+void Fl_Tree_Item_Array::index_moved(Fl_Tree_Item *item) {
+  if ( !_index || !item->label() ) return;
+  Fl_Tree_Label_Index::Entry *e = _index->find(item->label());
+  if ( e && e->count > 1 ) e->first = 0;
+}
@@ -0,0 +1,195 @@
+//
+// Thread-safe model update queue for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "Fl_Update_Queue.H"
+#include <FL/Fl.H>
+
+#include <stdlib.h>
+#include "flstring.h"
+
+/*
+  Global registry of queues with pending operations. It is allocated once
+  and never destroyed because worker threads may still post() while static
+  objects are destroyed at program exit, see also Fl_Task_Pool.cxx.
+
+  'dirty' is protected by 'mutex', 'applying' and 'current' are only used
+  by the main thread.
+*/
+struct Fl_Update_Registry {
+  std::mutex mutex;
+  std::vector<Fl_Update_Queue *> dirty;
+  std::vector<Fl_Update_Queue *> applying;
+  Fl_Update_Queue *current;
+  Fl_Update_Registry() : current(0) { }
+};
+
+static Fl_Update_Registry &registry = *new Fl_Update_Registry;
+
+static void remove_queue(std::vector<Fl_Update_Queue *> &v, Fl_Update_Queue *q) {
+  for (size_t i = 0; i < v.size(); i++) {
+    if (v[i] == q) {
+      v.erase(v.begin() + i);
+      return;
+    }
+  }
+}
+
+Fl_Update_Queue::~Fl_Update_Queue() {
+  free_ops(back_);
+  free_ops(front_);
+}
+
+void Fl_Update_Queue::free_ops(std::vector<Op> &ops) {
+  for (size_t i = 0; i < ops.size(); i++)
+    free(ops[i].str);
+  ops.clear();
+}
+
+/*
+  Deletes the queue stored in \p q and sets \p q to NULL.
+  Pending operations are discarded. Main thread only.
+*/
+void Fl_Update_Queue::destroy(Fl_Update_Queue *&q) {
+  Fl_Update_Queue *queue;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    queue = q;
+    if (!queue) return;
+    q = 0;
+    remove_queue(registry.dirty, queue);
+    for (size_t i = 0; i < registry.applying.size(); i++) {
+      if (registry.applying[i] == queue) registry.applying[i] = 0;
+    }
+  }
+  if (queue == registry.current) queue->destroyed_ = true; // deleted by apply_front()
+  else delete queue;
+}
+
+/*
+  Stages an operation in the queue stored in \p q, creates the queue for
+  \p target and \p apply if \p q is NULL. This can be called from any
+  thread.
+*/
+void Fl_Update_Queue::post(Fl_Update_Queue *&q, void *target, Apply apply, int code,
+                           int i1, int i2, double d, unsigned int u, const char *str) {
+  Op op;
+  op.code = code;
+  op.i1 = i1;
+  op.i2 = i2;
+  op.d = d;
+  op.u = u;
+  op.str = str ? strdup(str) : 0;
+  Fl_Update_Queue *queue;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (!q) q = new Fl_Update_Queue(target, apply);
+    queue = q;
+  }
+  queue->stage(op);
+}
+
+// Appends an operation to the back buffer and wakes up the main thread
+void Fl_Update_Queue::stage(const Op &op) {
+  bool was_empty;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    was_empty = back_.empty();
+    back_.push_back(op);
+  }
+  if (was_empty) {
+    {
+      std::lock_guard<std::mutex> lock(registry.mutex);
+      size_t i;
+      for (i = 0; i < registry.dirty.size(); i++) {
+        if (registry.dirty[i] == this) break;
+      }
+      if (i == registry.dirty.size()) registry.dirty.push_back(this);
+    }
+    Fl::awake_once(apply_all, 0);
+  }
+}
+
+// Moves all posted operations to the front buffer, called with registry.mutex locked
+void Fl_Update_Queue::swap_buffers() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (front_.empty()) {
+    front_.swap(back_);
+  } else {
+    front_.insert(front_.end(), back_.begin(), back_.end());
+    back_.clear();
+  }
+}
+
+// Applies the front buffer, main thread only
+void Fl_Update_Queue::apply_front() {
+  if (front_.empty()) return;
+  Fl_Update_Queue *previous = registry.current;
+  registry.current = this;
+  apply_(target_, &front_[0], (int)front_.size());
+  registry.current = previous;
+  free_ops(front_);
+  if (destroyed_) delete this;
+}
+
+// Awake handler: applies all dirty queues in the main thread
+void Fl_Update_Queue::apply_all(void *) {
+  if (!registry.applying.empty()) return; // called recursively
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.applying.swap(registry.dirty);
+    for (size_t i = 0; i < registry.applying.size(); i++)
+      registry.applying[i]->swap_buffers();
+  }
+  for (size_t i = 0; i < registry.applying.size(); i++) {
+    if (registry.applying[i]) registry.applying[i]->apply_front();
+  }
+  registry.applying.clear();
+  // queues posted to while we were applying (e.g. from a nested event loop)
+  bool again;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    again = !registry.dirty.empty();
+  }
+  if (again) Fl::awake_once(apply_all, 0);
+}
+
+/*
+  Applies all pending operations of the queue stored in \p q immediately.
+  Main thread only.
+*/
+void Fl_Update_Queue::flush(Fl_Update_Queue *&q) {
+  Fl_Update_Queue *queue;
+  {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    queue = q;
+    if (!queue || queue == registry.current) return;
+    remove_queue(registry.dirty, queue);
+    queue->swap_buffers();
+  }
+  queue->apply_front();
+}
+
+/*
+  Returns the number of operations posted to the queue stored in \p q that
+  have not yet been taken over by the main thread. This can be called from
+  any thread.
+*/
+int Fl_Update_Queue::pending(Fl_Update_Queue *const &q) {
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (!q) return 0;
+  std::lock_guard<std::mutex> queue_lock(q->mutex_);
+  return (int)q->back_.size();
+}
@@ -0,0 +1,372 @@
+//
+// Fl_Virtual_Browser implementation for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include <FL/Fl_Virtual_Browser.H>
+#include <FL/Fl_Image.H>
+#include <FL/fl_draw.H>
+#include <FL/platform_types.h>
+
+#include <algorithm>
+#include <limits.h>
+
+// Items are the row indices + 1, so that row 0 is not a NULL pointer
+
+static inline void *to_item(int index) {
+  return (void *)(fl_intptr_t)(index + 1);
+}
+
+static inline int to_index(const void *item) {
+  return (int)(fl_intptr_t)item - 1;
+}
+
+/**
+  The constructor makes an empty browser.
+  \param[in] X,Y,W,H position and size.
+  \param[in] L label string, may be NULL.
+*/
+Fl_Virtual_Browser::Fl_Virtual_Browser(int X, int Y, int W, int H, const char *L)
+  : Fl_Browser_(X, Y, W, H, L) {
+  size_ = 0;
+  row_height_ = 0;
+  full_height_ = -1;
+  text_cb_ = 0;
+  text_data_ = 0;
+  height_cb_ = 0;
+  height_data_ = 0;
+  icon_cb_ = 0;
+  icon_data_ = 0;
+}
+
+/**
+  Sets the number of rows.
+
+  Call this whenever the number of rows changes. Selected rows beyond the
+  new size are deselected. The scroll position is kept if possible.
+  \param[in] n The new number of rows
+*/
+void Fl_Virtual_Browser::size(int n) {
+  if (n < 0) n = 0;
+  int old_size = size_;
+  size_ = n;
+  full_height_ = -1;
+  if (n < old_size) {
+    // drop the selection beyond the last row
+    std::vector<int>::iterator it = std::lower_bound(ranges_.begin(), ranges_.end(), n);
+    size_t count = it - ranges_.begin();
+    ranges_.erase(it, ranges_.end());
+    if (count & 1) ranges_.push_back(n);
+    // Fl_Browser_ may still refer to rows that no longer exist (the top row,
+    // the widest row, rows to be redrawn): forget all of them, but keep the
+    // current row and the scroll position
+    void *s = selection();
+    if (s && to_index(s) >= n) s = 0;
+    int p = vposition(), hp = hposition();
+    new_list();
+    if (s) Fl_Browser_::select(s, item_selected(s), 0);
+    vposition(p);
+    hposition(hp);
+  }
+  redraw();
+}
+
+/**
+  Sets the function that returns the height of a row in pixels.
+
+  Without a height callback all rows have the height row_height().
+  Note that the total height of the list is computed by calling \p cb
+  for every row, which is slow for very large lists.
+  \param[in] cb the height function or NULL
+  \param[in] data user data passed to \p cb
+*/
+void Fl_Virtual_Browser::height_callback(Fl_Virtual_Browser_Height_Cb cb, void *data) {
+  height_cb_ = cb;
+  height_data_ = data;
+  full_height_ = -1;
+  redraw();
+}
+
+/**
+  Sets the height of all rows in pixels (not including linespacing()).
+
+  The default (0) uses the height of textfont() and textsize().
+  This is ignored if a height callback is set.
+  \see height_callback()
+*/
+void Fl_Virtual_Browser::row_height(int h) {
+  row_height_ = h > 0 ? h : 0;
+  redraw();
+}
+
+/**
+  Returns the height of all rows in pixels (not including linespacing()).
+*/
+int Fl_Virtual_Browser::row_height() const {
+  if (row_height_ > 0) return row_height_;
+  return fl_height(textfont(), textsize());
+}
+
+// Returns the height of each row including linespacing() if all rows
+// have the same height, or 0 otherwise
+int Fl_Virtual_Browser::uniform_height() const {
+  if (height_cb_) return 0;
+  return row_height() + linespacing();
+}
+
+void *Fl_Virtual_Browser::item_first() const {
+  return size_ > 0 ? to_item(0) : 0;
+}
+
+void *Fl_Virtual_Browser::item_next(void *item) const {
+  int i = to_index(item) + 1;
+  return i < size_ ? to_item(i) : 0;
+}
+
+void *Fl_Virtual_Browser::item_prev(void *item) const {
+  int i = to_index(item) - 1;
+  if (i >= size_) i = size_ - 1;
+  return i >= 0 ? to_item(i) : 0;
+}
+
+void *Fl_Virtual_Browser::item_last() const {
+  return size_ > 0 ? to_item(size_ - 1) : 0;
+}
+
+void *Fl_Virtual_Browser::item_at(int index) const {
+  return (index >= 0 && index < size_) ? to_item(index) : 0;
+}
+
+int Fl_Virtual_Browser::item_height(void *item) const {
+  if (height_cb_)
+    return height_cb_((Fl_Virtual_Browser *)this, to_index(item), height_data_);
+  return row_height();
+}
+
+const char *Fl_Virtual_Browser::item_text(void *item) const {
+  if (!text_cb_) return 0;
+  return text_cb_((Fl_Virtual_Browser *)this, to_index(item), text_data_);
+}
+
+int Fl_Virtual_Browser::item_width(void *item) const {
+  int ww = 6; // 3 pixels left and right
+  if (icon_cb_) {
+    Fl_Image *icon = icon_cb_((Fl_Virtual_Browser *)this, to_index(item), icon_data_);
+    if (icon) ww += icon->w() + 2;
+  }
+  const char *str = item_text(item);
+  if (str && *str) {
+    fl_font(textfont(), textsize());
+    ww += (int)fl_width(str);
+  }
+  return ww;
+}
+
+void Fl_Virtual_Browser::item_draw(void *item, int X, int Y, int W, int H) const {
+  int index = to_index(item);
+  if (icon_cb_) {
+    Fl_Image *icon = icon_cb_((Fl_Virtual_Browser *)this, index, icon_data_);
+    if (icon) {
+      fl_push_clip(X, Y, W, H);
+      icon->draw(X+2, Y+1); // leave 2px left, 1px above
+      fl_pop_clip();
+      int iconw = icon->w()+2;
+      X += iconw; W -= iconw;
+    }
+  }
+  const char *str = item_text(item);
+  if (!str || !*str) return;
+  Fl_Color lcol = textcolor();
+  if (item_selected(item))
+    lcol = fl_contrast(lcol, selection_color());
+  if (!active_r()) lcol = fl_inactive(lcol);
+  fl_font(textfont(), textsize());
+  fl_color(lcol);
+  fl_draw(str, X+3, Y, W-6, H, FL_ALIGN_LEFT, 0, 0);
+}
+
+/**
+  Returns the total height of all rows including linespacing().
+*/
+int Fl_Virtual_Browser::full_height() const {
+  int hh = uniform_height();
+  if (hh) {
+    long long t = (long long)size_ * hh;
+    return t > INT_MAX ? INT_MAX : (int)t;
+  }
+  if (full_height_ < 0) {
+    long long t = 0;
+    for (int i = 0; i < size_; i++)
+      t += height_cb_((Fl_Virtual_Browser *)this, i, height_data_) + linespacing();
+    full_height_ = t > INT_MAX ? INT_MAX : (int)t;
+  }
+  return full_height_;
+}
+
+int Fl_Virtual_Browser::incr_height() const {
+  int hh = uniform_height();
+  return hh ? hh : Fl_Browser_::incr_height();
+}
+
+void *Fl_Virtual_Browser::item_at_ypos(int ypos, int &item_ypos) const {
+  int hh = uniform_height();
+  if (!hh || !size_) return 0; // traverse the list
+  int i = ypos > 0 ? ypos / hh : 0;
+  if (i >= size_) i = size_ - 1;
+  item_ypos = i * hh;
+  return to_item(i);
+}
+
+int Fl_Virtual_Browser::item_ypos(void *item) const {
+  int hh = uniform_height();
+  if (!hh || !item) return -1;
+  long long y = (long long)to_index(item) * hh;
+  return y > INT_MAX ? -1 : (int)y;
+}
+
+// Returns the number of range boundaries <= index, odd if index is selected
+int Fl_Virtual_Browser::find_range(int index) const {
+  return (int)(std::upper_bound(ranges_.begin(), ranges_.end(), index) - ranges_.begin());
+}
+
+int Fl_Virtual_Browser::item_selected(void *item) const {
+  return find_range(to_index(item)) & 1;
+}
+
+void Fl_Virtual_Browser::item_select(void *item, int val) {
+  int index = to_index(item);
+  select_range(index, index, val);
+}
+
+int Fl_Virtual_Browser::item_deselect_all(void *keep) {
+  if (keep && item_selected(keep)) {
+    int index = to_index(keep);
+    if (ranges_.size() == 2 && ranges_[0] == index && ranges_[1] == index + 1)
+      return 0;
+    ranges_.assign(1, index);
+    ranges_.push_back(index + 1);
+    return 1;
+  }
+  if (ranges_.empty()) return 0;
+  ranges_.clear();
+  return 1;
+}
+
+/**
+  Sets the selection state of the row \p index.
+  \param[in] index The row to be changed (0 based)
+  \param[in] val The new selection state (1=select, 0=de-select)
+  \returns 1 if the state changed, 0 if not.
+  \see select_range(), selected(), value()
+*/
+int Fl_Virtual_Browser::select(int index, int val) {
+  if (index < 0 || index >= size_) return 0;
+  return Fl_Browser_::select(to_item(index), val);
+}
+
+/**
+  Sets the selection state of all rows from \p from to \p to (inclusive).
+
+  The time needed does not depend on the number of rows in the range.
+  This does not do callbacks and does not change the current item.
+  It is meant for multi browsers, e.g. to select all rows with
+  select_range(0, size()-1).
+
+  \param[in] from,to The first and last row to be changed (0 based)
+  \param[in] val The new selection state (1=select, 0=de-select)
+  \returns 1 if the state of any row changed, 0 if not.
+*/
+int Fl_Virtual_Browser::select_range(int from, int to, int val) {
+  if (from < 0) from = 0;
+  if (to >= size_) to = size_ - 1;
+  if (from > to) return 0;
+  val = val ? 1 : 0;
+  int end = to + 1; // exclusive
+  // unchanged if all rows have the same state (no boundary inside the range)
+  // and this is already the new state:
+  std::vector<int>::iterator inside = std::upper_bound(ranges_.begin(), ranges_.end(), from);
+  if ((find_range(from) & 1) == val && (inside == ranges_.end() || *inside >= end))
+    return 0;
+  // replace all boundaries in [from, end] by the new ones:
+  std::vector<int>::iterator first = std::lower_bound(ranges_.begin(), ranges_.end(), from);
+  std::vector<int>::iterator last = std::upper_bound(first, ranges_.end(), end);
+  int before = (int)(first - ranges_.begin()) & 1;  // state of row from-1
+  int after = (int)(last - ranges_.begin()) & 1;    // state of row 'end'
+  first = ranges_.erase(first, last);
+  if (after != val) first = ranges_.insert(first, end);
+  if (before != val) ranges_.insert(first, from);
+  redraw_lines();
+  return 1;
+}
+
+/**
+  Returns 1 if the row \p index is selected, 0 if not.
+  \param[in] index The row to be checked (0 based)
+*/
+int Fl_Virtual_Browser::selected(int index) const {
+  if (index < 0 || index >= size_) return 0;
+  return find_range(index) & 1;
+}
+
+/**
+  Returns the first selected row after \p index, or -1 if there is none.
+
+  Use next_selected(-1) to get the first selected row.
+  This is fast even if many rows are selected or deselected.
+*/
+int Fl_Virtual_Browser::next_selected(int index) const {
+  int i = index < 0 ? 0 : index + 1;
+  int n = find_range(i);
+  if (!(n & 1)) {
+    if (n >= (int)ranges_.size()) return -1;
+    i = ranges_[n];
+  }
+  return i < size_ ? i : -1;
+}
+
+/**
+  Returns the number of selected rows.
+*/
+int Fl_Virtual_Browser::nselected() const {
+  int n = 0;
+  for (size_t i = 0; i + 1 < ranges_.size(); i += 2)
+    n += ranges_[i + 1] - ranges_[i];
+  return n;
+}
+
+/**
+  Returns the selected row for FL_HOLD_BROWSER and FL_SELECT_BROWSER,
+  or the current row (with the focus box) for FL_MULTI_BROWSER.
+  \returns The row index (0 based), or -1 if there is none.
+*/
+int Fl_Virtual_Browser::value() const {
+  void *item = selection();
+  return item ? to_index(item) : -1;
+}
+
+/**
+  Scrolls the browser so that the row \p index is visible.
+*/
+void Fl_Virtual_Browser::display(int index) {
+  if (index < 0 || index >= size_) return;
+  Fl_Browser_::display(to_item(index));
+}
+
+/**
+  Returns 1 if the row \p index is currently visible in the browser.
+*/
+int Fl_Virtual_Browser::displayed(int index) const {
+  if (index < 0 || index >= size_) return 0;
+  return Fl_Browser_::displayed(to_item(index));
+}
@@ -18,10 +18,14 @@
 #include <FL/Fl_Widget.H>
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Tooltip.H>
+#include <FL/Fl_Task_Pool.H>
 #include <FL/fl_draw.H>
 #include <FL/fl_string_functions.h>
 #include <stdlib.h>
 #include "flstring.h"
+#include "Fl_Event_Stats_Scope.H"
+#include "Fl_Group_Index.H"
+#include "Fl_Retained_Cache.H"
 
 /*
  The Fl_Widget::type_ property is primarily used as a subtype field to further
@@ -223,11 +227,18 @@ Fl_Widget::Fl_Widget(int X, int Y, int W, int H, const char* L) {
   when_            = FL_WHEN_RELEASE;
 
   parent_ = nullptr;
+  index_hint_ = 0;
   if (Fl_Group::current()) Fl_Group::current()->add(this);
 }
 
 void Fl_Widget::resize(int X, int Y, int W, int H) {
   x_ = X; y_ = Y; w_ = W; h_ = H;
+  // parent_ is not always a group, see Fl_Value_Input
+  Fl_Group *g = parent_ ? ((Fl_Widget *)parent_)->as_group() : nullptr;
+  if (g) {
+    if (g->spatial_index_) g->spatial_index_->moved(this);
+    g->on_child_resize(this);
+  }
 }
 
 // this is useful for parent widgets to call to resize children:
@@ -260,6 +271,8 @@ Fl_Widget::~Fl_Widget() {
   Fl::Pen::unsubscribe(this);
 #endif
   Fl::clear_widget_pointer(this);
+  if (Fl_Task_Pool::owners_) Fl_Task_Pool::owner_deleted_(this);
+  if (flags() & RETAINED) Fl_Retained_Cache::remove(this);
   if (flags() & COPIED_LABEL) free((void *)(label_.value));
   if (flags() & COPIED_TOOLTIP) free((void *)(tooltip_));
   image(NULL);
@@ -279,6 +292,38 @@ Fl_Widget::~Fl_Widget() {
     delete (Fl_Callback_User_Data*)user_data_;
 }
 
+/**
+  Sets whether the widget is drawn from an offscreen cache.
+
+  A retained widget keeps its pixels in offscreen tiles. When the window or
+  the parent group is redrawn, the widget's pixels are copied from the tiles
+  instead of calling draw(). This helps with widgets that are expensive to
+  draw and don't change often, like complex dashboards, Fl_Help_View pages
+  or charts, and works in single and double buffered windows.
+
+  The cache is only drawn again if the widget itself is damaged, i.e. after
+  redraw() or damage() of the widget or one of its children. Widgets that
+  change their appearance without that, or that depend on the pixels
+  of their parent, must not use this. Areas that the widget doesn't draw
+  show the color() of the parent group.
+
+  Turning this off deletes the cache. The cache uses about 4 bytes per
+  pixel of the widget's visible area.
+
+  \param[in] v  non-zero to draw the widget from the cache
+  \see retained()
+  \since 1.5.0
+*/
+void Fl_Widget::retained(int v) {
+  if (v) {
+    set_flag(RETAINED);
+  } else if (flags() & RETAINED) {
+    clear_flag(RETAINED);
+    Fl_Retained_Cache::remove(this);
+  }
+  redraw();
+}
+
 /**
   Draws a focus box for the widget at the given position and size.
 
@@ -475,7 +520,10 @@ void Fl_Widget::do_callback(Fl_Widget *widget, void *arg, Fl_Callback_Reason rea
   Fl::callback_reason_ = reason;
   if (!callback_) return;
   Fl_Widget_Tracker wp(this);
-  callback_(widget, arg);
+  {
+    FL_EVENT_STATS_SCOPE(WIDGET_CALLBACK, callback_);
+    callback_(widget, arg);
+  }
   if (wp.deleted()) return;
   if (callback_ != default_callback)
     clear_changed();
@@ -31,6 +31,7 @@
 #include <FL/fl_string_functions.h>
 #include <stdlib.h>
 #include "flstring.h"
+#include <FL/Fl_Event_Stats.H>
 
 
 char *Fl_Window::default_xclass_ = 0L;
@@ -93,6 +94,9 @@ Fl_Window::~Fl_Window() {
   }
   free_icons();
   delete pWindowDriver;
+#if FLTK_HAVE_EVENT_STATS
+  Fl_Event_Stats::forget_window_(this);
+#endif
 }
 
 
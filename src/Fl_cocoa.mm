@@ -24,6 +24,7 @@ extern "C" {
 #include "Fl_Window_Driver.H"
 #include "Fl_Screen_Driver.H"
 #include "Fl_Timeout.h"
+#include "Fl_Event_Stats_Scope.H"
 #include <FL/Fl_Window.H>
 #include <FL/Fl_Tooltip.H>
 #include <FL/Fl_Image_Surface.H>
@@ -375,6 +376,7 @@ void DataReady::HandleData(fd_set& r, fd_set& w, fd_set& x)
     if (FD_ISSET(f, &x)) revents |= POLLERR;
     if (fds[i].events & revents) {
       DEBUGMSG("DOING CALLBACK: ");
+      FL_EVENT_STATS_SCOPE(FD_CALLBACK, fds[i].cb);
       fds[i].cb(f, fds[i].arg);
       DEBUGMSG("DONE\n");
     }
@@ -794,10 +796,15 @@ static int do_queued_events( double time = 0.0 )
 
   fl_unlock_function();
   NSEvent *event;
-  while ( (event = [NSApp nextEventMatchingMask:NSEventMaskAny
-                                      untilDate:[NSDate dateWithTimeIntervalSinceNow:time]
-                                         inMode:NSDefaultRunLoopMode
-                                        dequeue:YES]) != nil ) {
+  for (;;) {
+    {
+      FL_EVENT_STATS_SCOPE(WAIT, 0);
+      event = [NSApp nextEventMatchingMask:NSEventMaskAny
+                                 untilDate:[NSDate dateWithTimeIntervalSinceNow:time]
+                                    inMode:NSDefaultRunLoopMode
+                                   dequeue:YES];
+    }
+    if (!event) break;
     got_events = 1;
     [FLApplication sendEvent:event]; // will then call [NSApplication sendevent:]
     time = 0;
@@ -59,6 +59,7 @@ void fl_cleanup_dc_list(void);
 #include "Fl_Window_Driver.H"
 #include "Fl_Screen_Driver.H"
 #include "Fl_Timeout.h"
+#include "Fl_Event_Stats_Scope.H"
 #include "print_button.h"
 #include <FL/Fl_Graphics_Driver.H> // for fl_graphics_driver
 #include "drivers/WinAPI/Fl_WinAPI_Pen_Events.H"
@@ -360,6 +361,7 @@ static void process_awake_handler_requests(void) {
   Fl_Awake_Handler func;
   void *data;
   while (Fl_WinAPI_System_Driver::pop_awake_handler(func, data) == 0) {
+    FL_EVENT_STATS_SCOPE(AWAKE, func);
     func(data);
   }
 }
@@ -394,8 +396,10 @@ double Fl_WinAPI_System_Driver::wait(double time_to_wait) {
           revents |= FL_WRITE;
         if (FD_ISSET(f, &fdt[2]))
           revents |= FL_EXCEPT;
-        if (fd[i].events & revents)
+        if (fd[i].events & revents) {
+          FL_EVENT_STATS_SCOPE(FD_CALLBACK, fd[i].cb);
           fd[i].cb(f, fd[i].arg);
+        }
       }
       time_to_wait = 0.0; // just peek for any messages
     } else {
@@ -420,7 +424,10 @@ double Fl_WinAPI_System_Driver::wait(double time_to_wait) {
   time_to_wait = Fl_Timeout::time_to_wait(time_to_wait);
 
   int t_msec = (int)(time_to_wait * 1000.0 + 0.5);
-  MsgWaitForMultipleObjects(0, NULL, FALSE, t_msec, QS_ALLINPUT);
+  {
+    FL_EVENT_STATS_SCOPE(WAIT, 0);
+    MsgWaitForMultipleObjects(0, NULL, FALSE, t_msec, QS_ALLINPUT);
+  }
 
   fl_lock_function();
 
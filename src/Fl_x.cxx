@@ -146,6 +146,32 @@ int Fl_X11_Screen_Driver::poll_or_select() {
   return Fl_Unix_Screen_Driver::poll_or_select();
 }
 
+// XCheckIfEvent() predicate: notes keyboard and mouse events but never
+// selects an event, so that the queue is not changed
+static Bool is_user_input(Display *, XEvent *ev, XPointer arg) {
+  switch (ev->type) {
+    case KeyPress:
+    case KeyRelease:
+    case ButtonPress:
+    case ButtonRelease:
+    case MotionNotify:
+      *(int *)arg = 1;
+      break;
+  }
+  return False;
+}
+
+// reads pending data from the X server connection without blocking and
+// looks for keyboard and mouse events, other events (Expose, property and
+// client messages...) don't interrupt idle jobs
+int Fl_X11_Screen_Driver::input_pending() {
+  if (!fl_display || XEventsQueued(fl_display, QueuedAfterReading) <= 0) return 0;
+  int found = 0;
+  XEvent ev;
+  XCheckIfEvent(fl_display, &ev, is_user_input, (XPointer)&found);
+  return found;
+}
+
 // replace \r\n by \n
 static void convert_crlf(unsigned char *string, long& len) {
   unsigned char *a, *b;
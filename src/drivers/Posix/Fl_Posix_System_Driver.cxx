@@ -17,6 +17,7 @@
 #include <config.h>
 #include "Fl_Posix_System_Driver.H"
 #include "../../flstring.h"
+#include "../../Fl_Event_Stats_Scope.H"
 #include <FL/Fl_File_Icon.H>
 #include <FL/filename.H>
 #include <FL/fl_string_functions.h>
@@ -323,9 +324,15 @@ int Fl_Posix_System_Driver::close_fd(int fd) { return close(fd); }
 #  include <pthread.h>
 #  include <sys/ioctl.h>
 #  include <mutex> // for std::mutex (since C++11)
+#  ifdef HAVE_SYS_EVENTFD_H
+#    include <sys/eventfd.h>
+#    include <stdint.h>
+#  endif
 
 // Pipe for thread messaging via Fl::awake()...
+// If an eventfd is used instead both elements are the same file descriptor.
 static int thread_filedes[2];
+static bool use_eventfd = false;
 
 // Mutex and state information for Fl::lock() and Fl::unlock()...
 static pthread_mutex_t fltk_mutex;
@@ -376,6 +383,14 @@ static std::mutex pipe_mutex;
 
 void Fl_Posix_System_Driver::awake(void* msg) {
   thread_message_ = msg;
+#  ifdef HAVE_SYS_EVENTFD_H
+  if (use_eventfd) {
+    // The kernel adds up the counts, no need to check for pending data
+    uint64_t one = 1;
+    if (write(thread_filedes[1], &one, sizeof(one)) < 0) { /* ignore */ }
+    return;
+  }
+#  endif
   if (thread_filedes[1]) {
     pipe_mutex.lock();
     int avail = 0;
@@ -396,6 +411,13 @@ void* Fl_Posix_System_Driver::thread_message() {
 }
 
 static void thread_awake_cb(int fd, void*) {
+#  ifdef HAVE_SYS_EVENTFD_H
+  if (use_eventfd) {
+    // reset the counter, all pending handlers are called below
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0) { /* EAGAIN: nothing to read */ }
+  } else
+#  endif
   if (thread_filedes[1]) {
     pipe_mutex.lock();
     char dummy = 0;
@@ -405,6 +427,7 @@ static void thread_awake_cb(int fd, void*) {
   Fl_Awake_Handler func;
   void *data;
   while (Fl_System_Driver::pop_awake_handler(func, data)==0) {
+    FL_EVENT_STATS_SCOPE(AWAKE, func);
     (*func)(data);
   }
 }
@@ -415,7 +438,16 @@ extern void (*fl_lock_function)();
 extern void (*fl_unlock_function)();
 
 int Fl_Posix_System_Driver::lock() {
-  if (!thread_filedes[1]) {
+  if (!thread_filedes[1] && !use_eventfd) {
+#  ifdef HAVE_SYS_EVENTFD_H
+    // Use an eventfd if possible: a single file descriptor with a counter
+    // instead of a pipe buffer that can fill up
+    int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd >= 0) {
+      thread_filedes[0] = thread_filedes[1] = efd;
+      use_eventfd = true;
+    } else {
+#  endif
     // Initialize thread communication pipe to let threads awake FLTK
     // from Fl::wait()
     if (pipe(thread_filedes)==-1) {
@@ -426,6 +458,9 @@ int Fl_Posix_System_Driver::lock() {
     // conditions (STR #1537)
     fcntl(thread_filedes[1], F_SETFL,
           fcntl(thread_filedes[1], F_GETFL) | O_NONBLOCK);
+#  ifdef HAVE_SYS_EVENTFD_H
+    }
+#  endif
 
     // Monitor the read side of the pipe so that messages sent via
     // Fl::awake() from a thread will "wake up" the main thread in
@@ -456,6 +491,13 @@ void Fl_Posix_System_Driver::unlock() {
   fl_unlock_function();
 }
 
+int Fl_Posix_System_Driver::create_thread(void *(*func)(void *), void *arg) {
+  pthread_t t;
+  if (pthread_create(&t, NULL, func, arg)) return -1;
+  pthread_detach(t);
+  return 0;
+}
+
 // Mutex code for the awake ring buffer
 static pthread_mutex_t *ring_mutex;
 
@@ -477,6 +519,7 @@ void Fl_Posix_System_Driver::awake(void*) {}
 int Fl_Posix_System_Driver::lock() { return 1; }
 void Fl_Posix_System_Driver::unlock() {}
 void* Fl_Posix_System_Driver::thread_message() { return NULL; }
+int Fl_Posix_System_Driver::create_thread(void *(*)(void *), void *) { return -1; }
 
 //void lock_ring() {}
 //void unlock_ring() {}
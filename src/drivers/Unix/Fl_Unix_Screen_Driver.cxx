@@ -17,6 +17,7 @@
 #include <config.h>
 #include <sys/time.h>
 #include "Fl_Unix_Screen_Driver.H"
+#include "../../Fl_Event_Stats_Scope.H"
 
 #if USE_POLL
 pollfd *Fl_Unix_Screen_Driver::pollfds = NULL;
@@ -47,21 +48,29 @@ int Fl_Unix_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
 
   fl_unlock_function();
 
-  if (time_to_wait < 2147483.648) {
-#  if USE_POLL
-    n = ::poll(pollfds, nfds, int(time_to_wait*1000 + .5));
+  {
+    FL_EVENT_STATS_SCOPE(WAIT, 0);
+    if (time_to_wait < 2147483.648) {
+#  if USE_POLL && HAVE_PPOLL
+      timespec t;
+      t.tv_sec = int(time_to_wait);
+      t.tv_nsec = long(1e9 * (time_to_wait - t.tv_sec));
+      n = ::ppoll(pollfds, nfds, &t, NULL);
+#  elif USE_POLL
+      n = ::poll(pollfds, nfds, int(time_to_wait*1000 + .5));
 #  else
-    timeval t;
-    t.tv_sec = int(time_to_wait);
-    t.tv_usec = int(1000000 * (time_to_wait-t.tv_sec));
-    n = ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],&t);
+      timeval t;
+      t.tv_sec = int(time_to_wait);
+      t.tv_usec = int(1000000 * (time_to_wait-t.tv_sec));
+      n = ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],&t);
 #  endif
-  } else {
+    } else {
 #  if USE_POLL
-    n = ::poll(pollfds, nfds, -1);
+      n = ::poll(pollfds, nfds, -1);
 #  else
-    n = ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],0);
+      n = ::select(maxfd+1,&fdt[0],&fdt[1],&fdt[2],0);
 #  endif
+    }
   }
 
   fl_lock_function();
@@ -69,14 +78,20 @@ int Fl_Unix_Screen_Driver::poll_or_select_with_delay(double time_to_wait) {
   if (n > 0) {
     for (int i=0; i<nfds; i++) {
 #  if USE_POLL
-      if (pollfds[i].revents) fd[i].cb(pollfds[i].fd, fd[i].arg);
+      if (pollfds[i].revents) {
+        FL_EVENT_STATS_SCOPE(FD_CALLBACK, fd[i].cb);
+        fd[i].cb(pollfds[i].fd, fd[i].arg);
+      }
 #  else
       int f = fd[i].fd;
       short revents = 0;
       if (FD_ISSET(f,&fdt[0])) revents |= POLLIN;
       if (FD_ISSET(f,&fdt[1])) revents |= POLLOUT;
       if (FD_ISSET(f,&fdt[2])) revents |= POLLERR;
-      if (fd[i].events & revents) fd[i].cb(f, fd[i].arg);
+      if (fd[i].events & revents) {
+        FL_EVENT_STATS_SCOPE(FD_CALLBACK, fd[i].cb);
+        fd[i].cb(f, fd[i].arg);
+      }
 #  endif
     }
   }
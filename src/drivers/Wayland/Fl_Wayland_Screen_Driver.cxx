@@ -2181,6 +2181,20 @@ int Fl_Wayland_Screen_Driver::poll_or_select() {
 }
 
 
+// returns 1 if events are queued or the Wayland socket is readable
+int Fl_Wayland_Screen_Driver::input_pending() {
+  if (!wl_display) return 0;
+  if (wl_display_prepare_read(wl_display) != 0) return 1; // events are queued
+  struct pollfd pfd;
+  pfd.fd = wl_display_get_fd(wl_display);
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  int n = ::poll(&pfd, 1, 0);
+  wl_display_cancel_read(wl_display);
+  return n > 0;
+}
+
+
 int Fl_Wayland_Screen_Driver::event_key(int k) {
   if (k >= 'A' && k <= 'Z') k += 32;
   return (search_int_vector(key_vector, k) >= 0);
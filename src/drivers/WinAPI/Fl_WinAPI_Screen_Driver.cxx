@@ -501,3 +501,9 @@ int Fl_WinAPI_Screen_Driver::screen_num_unscaled(int x, int y)
 float Fl_WinAPI_Screen_Driver::base_scale(int numscreen) {
   return float(dpi[numscreen][0] / 96.);
 }
+
+
+// returns non-zero if keyboard or mouse input is in the message queue
+int Fl_WinAPI_Screen_Driver::input_pending() {
+  return HIWORD(GetQueueStatus(QS_INPUT)) != 0;
+}
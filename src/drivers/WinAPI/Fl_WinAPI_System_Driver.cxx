@@ -1129,6 +1129,31 @@ void Fl_WinAPI_System_Driver::awake(void* msg) {
   PostThreadMessage( main_thread, fl_wake_msg, (WPARAM)msg, 0);
 }
 
+struct thread_start_data {
+  void *(*func)(void *);
+  void *arg;
+};
+
+static DWORD WINAPI thread_start(LPVOID p) {
+  thread_start_data d = *(thread_start_data *)p;
+  delete (thread_start_data *)p;
+  d.func(d.arg);
+  return 0;
+}
+
+int Fl_WinAPI_System_Driver::create_thread(void *(*func)(void *), void *arg) {
+  thread_start_data *d = new thread_start_data;
+  d->func = func;
+  d->arg = arg;
+  HANDLE h = CreateThread(NULL, 0, thread_start, d, 0, NULL);
+  if (!h) {
+    delete d;
+    return -1;
+  }
+  CloseHandle(h);
+  return 0;
+}
+
 int Fl_WinAPI_System_Driver::close_fd(int fd) {
   return _close(fd);
 }
@@ -0,0 +1,145 @@
+//
+// Nested Fl_Flex and Fl_Grid resize benchmark for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+// This program builds 5 levels of nested Fl_Flex and Fl_Grid widgets with
+// about 2,000 widgets and measures how long it takes to resize the window
+// and to change the layouts, each followed by Fl::flush().
+// Run it with "-b" to print the times and exit.
+
+#include <FL/Fl.H>
+#include <FL/Fl_Double_Window.H>
+#include <FL/Fl_Flex.H>
+#include <FL/Fl_Grid.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Button.H>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static Fl_Double_Window *window = 0;
+static Fl_Box *status = 0;
+static std::vector<Fl_Flex *> leaf_flexes;     // innermost layouts
+static int num_widgets = 0;
+static bool batch_mode = false;
+
+static const int LEVELS = 5;
+
+// Creates the layout of 'level' and its children, returns the new widget
+static Fl_Widget *make_level(int level) {
+  if (level == LEVELS) {
+    static const Fl_Color colors[] = { FL_RED, FL_GREEN, FL_BLUE, FL_YELLOW, FL_CYAN };
+    Fl_Box *b = new Fl_Box(0, 0, 10, 10);
+    b->box(FL_FLAT_BOX);
+    b->color(colors[num_widgets % 5]);
+    num_widgets++;
+    return b;
+  }
+  Fl_Group *g;
+  if (level % 2 == 0) {                 // Fl_Flex with 3 (outermost) to 10 children
+    int n = level == 0 ? 3 : (level == LEVELS - 1 ? 10 : 4);
+    Fl_Flex *flex = new Fl_Flex(0, 0, 10, 10, (level / 2) % 2 ? Fl_Flex::HORIZONTAL : Fl_Flex::VERTICAL);
+    flex->gap(1);
+    for (int i = 0; i < n; i++)
+      make_level(level + 1);
+    if (level == LEVELS - 1) leaf_flexes.push_back(flex);
+    g = flex;
+  } else {                              // Fl_Grid with 2 x 2 cells
+    Fl_Grid *grid = new Fl_Grid(0, 0, 10, 10);
+    grid->layout(2, 2, 1, 1);
+    for (int i = 0; i < 4; i++)
+      grid->widget(make_level(level + 1), i / 2, i % 2);
+    g = grid;
+  }
+  g->end();
+  num_widgets++;
+  return g;
+}
+
+// Resizes the window 'n' times, returns the average time in milliseconds
+static double resize_window(int n) {
+  int W = window->w(), H = window->h();
+  Fl_Timestamp start = Fl::now();
+  for (int i = 0; i < n; i++) {
+    window->size(W + (i % 20) * 5 - 50, H + (i % 10) * 5 - 25);
+    Fl::flush();
+  }
+  window->size(W, H);
+  Fl::flush();
+  return Fl::seconds_since(start) * 1000.0 / n;
+}
+
+// Changes the fixed size of the first child of 'n' innermost layouts
+// before each flush, returns the average time of a flush in milliseconds
+static double change_layouts(int rounds, int n) {
+  Fl_Timestamp start = Fl::now();
+  for (int r = 0; r < rounds; r++) {
+    for (int i = 0; i < n; i++) {
+      Fl_Flex *flex = leaf_flexes[(r * n + i) % leaf_flexes.size()];
+      flex->fixed(flex->child(0), 3 + (r % 2) * 3);
+    }
+    Fl::flush();
+  }
+  return Fl::seconds_since(start) * 1000.0 / rounds;
+}
+
+static void run_cb(Fl_Widget *, void *) {
+  static char text[200];
+  double t1 = resize_window(100);
+  double t2 = change_layouts(100, 1);
+  double t3 = change_layouts(100, 50);
+  snprintf(text, sizeof(text),
+           "%d widgets: resize %.2f ms, 1 change %.2f ms, 50 changes %.2f ms",
+           num_widgets, t1, t2, t3);
+  status->label(text);
+  printf("%s\n", text);
+  if (batch_mode) window->hide();
+}
+
+static void start_cb(void *) {
+  run_cb(0, 0);
+}
+
+static int arg(int, char **argv, int &i) {
+  if (strcmp(argv[i], "-b") == 0) {
+    batch_mode = true;
+    i++;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int i = 1;
+  if (Fl::args(argc, argv, i, arg) < argc)
+    Fl::fatal("error: unknown option: %s\n"
+              "usage: %s [options]\n"
+              " -b     print the times and exit\n"
+              " plus standard fltk options\n",
+              argv[i], argv[0]);
+
+  window = new Fl_Double_Window(800, 600, "Nested layout resize");
+  Fl_Widget *root = make_level(0);
+  root->resize(0, 0, 800, 565);
+  Fl_Button *run = new Fl_Button(5, 570, 60, 25, "Run");
+  run->callback(run_cb);
+  status = new Fl_Box(70, 570, 725, 25);
+  status->align(FL_ALIGN_INSIDE | FL_ALIGN_LEFT);
+  window->end();
+  window->resizable(root);
+  window->show(argc, argv);
+  Fl::add_timeout(0.5, start_cb);
+  return Fl::run();
+}
@@ -0,0 +1,1545 @@
+//
+// Unit tests for the Fast Light Tool Kit (FLTK).
+//
+// Copyright 2026 by Bill Spitzak and others.
+//
+// This library is free software. Distribution and use rights are outlined in
+// the file "COPYING" which should have been included with this file.  If this
+// file is missing or damaged, see the license at:
+//
+//     https://www.fltk.org/COPYING.php
+//
+// Please see the following page on how to report bugs and issues:
+//
+//     https://www.fltk.org/bugs.php
+//
+
+#include "unittests.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+//------- test the internal data structures of widgets ----------
+//
+// These tests don't draw, they are run with the core tests (--core).
+// The internal classes are not exported from the FLTK DLL.
+//
+
+#if !defined(FL_DLL)
+
+#include "../src/Fl_Browser_Index.H"
+#include "../src/Fl_Browser_Store.H"
+#include "../src/Fl_Chart_Stream.H"
+#include "../src/Fl_Filter_Index.H"
+#include "../src/Fl_Group_Index.H"
+#include "../src/Fl_Retained_Cache.H"
+#include "../src/Fl_Table_Sizes.H"
+#include "../src/Fl_Update_Queue.H"
+#include <FL/Fl_Group.H>
+#include <FL/Fl_Box.H>
+#include <FL/Fl_Value_Input.H>
+#include <FL/Fl_Menu_Button.H>
+#include <FL/Fl_Table.H>
+#include <FL/Fl_Table_Row.H>
+#include <FL/Fl_Event_Stats.H>
+#include <FL/Fl_Idle_Scheduler.H>
+#include <FL/Fl_Task_Pool.H>
+#include <FL/Fl_Text_Buffer.H>
+#include <FL/Fl_Text_Display.H>
+#include <FL/Fl_Browser_.H>
+#include <FL/Fl_Tree.H>
+
+// Small deterministic random number generator, so failures can be reproduced
+static unsigned int ut_seed = 1;
+static int ut_random(int n) {
+  ut_seed = ut_seed * 1103515245u + 12345u;
+  return (int)((ut_seed >> 8) % (unsigned int)n);
+}
+
+struct Ut_Browser_Item {
+  Fl_Browser_Index::Chunk *chunk;
+};
+
+static void ut_set_chunk(void *item, Fl_Browser_Index::Chunk *chunk) {
+  ((Ut_Browser_Item *)item)->chunk = chunk;
+}
+
+// Compares the index with a plain list of items and heights
+static bool ut_check_browser_index(const Fl_Browser_Index &index,
+                                   const std::vector<Ut_Browser_Item *> &items,
+                                   const std::vector<int> &heights) {
+  EXPECT_EQ(index.size(), (int)items.size());
+  int y = 0;
+  for (size_t i = 0; i < items.size(); i++) {
+    EXPECT_TRUE(index.item((int)i) == items[i]);
+    EXPECT_EQ(index.index(items[i], items[i]->chunk), (int)i);
+    EXPECT_EQ(index.height((int)i), heights[i]);
+    EXPECT_EQ(index.ypos((int)i), y);
+    y += heights[i];
+  }
+  EXPECT_EQ(index.total_height(), y);
+  // find() returns the first item whose bottom is below ypos
+  for (int ypos = 0; ypos < y; ypos += 1 + ut_random(7)) {
+    size_t i = 0;
+    int top = 0;
+    while (top + heights[i] <= ypos) top += heights[i++];
+    int item_y = -1;
+    EXPECT_EQ(index.find(ypos, item_y), (int)i);
+    EXPECT_EQ(item_y, top);
+  }
+  return true;
+}
+
+/* Fenwick trees of the Fl_Browser line index. */
+TEST(Fl_Browser_Index, InsertRemoveHeight) {
+  const int N = 5000;
+  std::vector<Ut_Browser_Item> pool(N);
+  std::vector<Ut_Browser_Item *> items;
+  std::vector<int> heights;
+  Fl_Browser_Index index(ut_set_chunk);
+  ut_seed = 1;
+
+  // bulk append, then many single inserts to split chunks
+  std::vector<void *> bulk;
+  for (int i = 0; i < 1500; i++) {
+    items.push_back(&pool[i]);
+    heights.push_back(1 + ut_random(20));
+    bulk.push_back(&pool[i]);
+  }
+  index.append(&bulk[0], &heights[0], (int)bulk.size());
+  for (int i = 1500; i < N; i++) {
+    int pos = ut_random((int)items.size() + 1);
+    int h = ut_random(4) ? 1 + ut_random(20) : 0;    // some hidden lines
+    items.insert(items.begin() + pos, &pool[i]);
+    heights.insert(heights.begin() + pos, h);
+    index.insert(pos, &pool[i], h);
+  }
+  bool ok = ut_check_browser_index(index, items, heights);
+  EXPECT_TRUE(ok);
+
+  // change heights
+  for (int k = 0; k < 1000; k++) {
+    int pos = ut_random((int)items.size());
+    int h = ut_random(30);
+    heights[pos] = h;
+    index.height(pos, h);
+  }
+  ok = ut_check_browser_index(index, items, heights);
+  EXPECT_TRUE(ok);
+
+  // swap and remove most items to merge chunks
+  for (int k = 0; k < 500; k++) {
+    int a = ut_random((int)items.size()), b = ut_random((int)items.size());
+    std::swap(items[a], items[b]);
+    std::swap(heights[a], heights[b]);
+    index.swap(a, b);
+  }
+  while (items.size() > 100) {
+    int pos = ut_random((int)items.size());
+    EXPECT_TRUE(index.remove(pos) == items[pos]);
+    items.erase(items.begin() + pos);
+    heights.erase(heights.begin() + pos);
+  }
+  ok = ut_check_browser_index(index, items, heights);
+  EXPECT_TRUE(ok);
+
+  // positions beyond the end return the last item
+  int item_y = -1;
+  EXPECT_EQ(index.find(index.total_height() + 10, item_y), (int)items.size() - 1);
+
+  index.clear();
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_EQ(index.total_height(), 0);
+  EXPECT_EQ(index.find(0, item_y), -1);
+  return true;
+}
+
+// Compares range() with the minimum and maximum of the values first to last-1
+static bool ut_check_chart_range(const Fl_Chart_Stream &stream,
+                                 const std::deque<float> &values,
+                                 int first, int last) {
+  float min = 0, max = 0;
+  if (first >= last) {
+    EXPECT_TRUE(!stream.range(first, last, min, max));
+    return true;
+  }
+  float mn = values[first], mx = mn;
+  for (int i = first + 1; i < last; i++) {
+    if (values[i] < mn) mn = values[i];
+    if (values[i] > mx) mx = values[i];
+  }
+  EXPECT_TRUE(stream.range(first, last, min, max));
+  EXPECT_EQ(min, mn);
+  EXPECT_EQ(max, mx);
+  return true;
+}
+
+// Checks all values and ranges that start and end at and next to the
+// blocks of each level (16, 256, 4096 values), and random ranges
+static bool ut_check_chart_stream(const Fl_Chart_Stream &stream,
+                                  const std::deque<float> &values,
+                                  long long total) {
+  int n = (int)values.size();
+  EXPECT_EQ(stream.count(), n);
+  for (int i = 0; i < n; i++) {
+    EXPECT_EQ(stream.value(i), values[i]);
+  }
+  bool ok = ut_check_chart_range(stream, values, 0, n);
+  EXPECT_TRUE(ok);
+  int oldest = (int)((total - n) % 4096);  // blocks are aligned to the values added
+  for (int s = 16; s <= 4096; s *= 16) {
+    int first = (s - oldest % s) % s;     // first block of this level
+    for (int k = 0; k < 3; k++, first += s * (1 + ut_random(3))) {
+      for (int d = -1; d <= 1; d++) {
+        int a = first + d, b = first + d + s;
+        if (a < 0 || a > n) continue;
+        ok = ut_check_chart_range(stream, values, a, b < n ? b : n);
+        EXPECT_TRUE(ok);
+        b = first + d + 2 * s + 1 + ut_random(3 * s);
+        ok = ut_check_chart_range(stream, values, a, b < n ? b : n);
+        EXPECT_TRUE(ok);
+      }
+    }
+  }
+  for (int k = 0; k < 50; k++) {
+    int a = ut_random(n + 1), b = ut_random(n + 1);
+    ok = ut_check_chart_range(stream, values, a < b ? a : b, a < b ? b : a);
+    EXPECT_TRUE(ok);
+  }
+  return true;
+}
+
+/* Ring buffer and min/max pyramid of Fl_Chart in stream mode. */
+TEST(Fl_Chart_Stream, WraparoundRange) {
+  const int N = 70000;                  // levels of 16, 256 and 4096 values
+  Fl_Chart_Stream stream(N);
+  std::deque<float> values;
+  long long total = 0;
+  ut_seed = 1;
+  EXPECT_EQ(stream.capacity(), N);
+
+  // partly filled, then wrapped around several times at odd positions
+  int steps[] = { 5000, N - 5000 - 123, 500, 2 * N + 77, 4096 * 3 + 5 };
+  for (int step = 0; step < 5; step++) {
+    for (int i = 0; i < steps[step]; i++) {
+      float v = (float)(ut_random(20001) - 10000) / 8;
+      stream.add(v);
+      values.push_back(v);
+      if ((int)values.size() > N) values.pop_front();
+      total++;
+    }
+    bool ok = ut_check_chart_stream(stream, values, total);
+    EXPECT_TRUE(ok);
+  }
+
+  // change values, extremes must be found and removed again in all levels
+  for (int k = 0; k < 300; k++) {
+    int i = ut_random(N);
+    float v = k % 3 == 0 ? 100000.0f : k % 3 == 1 ? -100000.0f : (float)ut_random(100);
+    stream.value(i, v);
+    values[i] = v;
+  }
+  bool ok = ut_check_chart_stream(stream, values, total);
+  EXPECT_TRUE(ok);
+  for (int i = 0; i < N; i++) {
+    if (values[i] < -1000 || values[i] > 1000) {
+      values[i] = 0.5f;
+      stream.value(i, 0.5f);
+    }
+  }
+  ok = ut_check_chart_stream(stream, values, total);
+  EXPECT_TRUE(ok);
+
+  // a new stream after clear() starts its blocks at 0 again
+  stream.clear();
+  values.clear();
+  total = 0;
+  float min, max;
+  EXPECT_EQ(stream.count(), 0);
+  EXPECT_TRUE(!stream.range(0, 0, min, max));
+  for (int i = 0; i < N + 4096 + 3; i++) {
+    float v = (float)ut_random(1000);
+    stream.add(v);
+    values.push_back(v);
+    if ((int)values.size() > N) values.pop_front();
+    total++;
+  }
+  ok = ut_check_chart_stream(stream, values, total);
+  EXPECT_TRUE(ok);
+  return true;
+}
+
+// Compares find() with all children that intersect the rectangle. Children
+// of 1000 pixels or more span too many cells and are always found.
+static bool ut_check_group_find(Fl_Group_Index &index, const Fl_Group &g,
+                                int X, int Y, int W, int H) {
+  std::vector<int> found, expected;
+  index.find(X, Y, W, H, found);
+  for (int i = 0; i < g.children(); i++) {
+    const Fl_Widget *o = g.child(i);
+    if (o->w() >= 1000 ||
+        (W > 0 && H > 0 && o->x() < X + W && o->x() + o->w() > X &&
+         o->y() < Y + H && o->y() + o->h() > Y))
+      expected.push_back(i);
+  }
+  EXPECT_EQ((int)found.size(), (int)expected.size());
+  EXPECT_TRUE(found == expected);
+  return true;
+}
+
+static bool ut_check_group_index(Fl_Group_Index &index, const Fl_Group &g) {
+  for (int k = 0; k < 100; k++) {
+    int X = ut_random(2400) - 200, Y = ut_random(2400) - 200;
+    bool ok = ut_check_group_find(index, g, X, Y, ut_random(k % 10 ? 100 : 800), ut_random(100));
+    EXPECT_TRUE(ok);
+  }
+  return true;
+}
+
+static Fl_Box *ut_random_box() {
+  return new Fl_Box(ut_random(2200) - 100, ut_random(2200) - 100,
+                    1 + ut_random(80), 1 + ut_random(80));
+}
+
+/* Grid of the children of a group, see Fl_Group::spatial_index(). */
+TEST(Fl_Group_Index, FindMovedInvalidate) {
+  Fl_Group g(0, 0, 2000, 2000);
+  ut_seed = 1;
+  for (int i = 0; i < 2000; i++) {
+    if (i % 400 == 7)
+      new Fl_Box(ut_random(1000), ut_random(1000), 1000, 1000);
+    else
+      ut_random_box();
+  }
+  g.end();
+  Fl_Group_Index index(&g);
+  bool ok = ut_check_group_index(index, g);
+  EXPECT_TRUE(ok);
+  ok = ut_check_group_find(index, g, 0, 0, 0, 0);         // empty: big children only
+  EXPECT_TRUE(ok);
+
+  // children resized on their own, also outside the grid
+  for (int k = 0; k < 300; k++) {
+    Fl_Widget *o = g.child(ut_random(g.children()));
+    if (o->w() >= 1000) continue;
+    o->resize(ut_random(3000) - 500, ut_random(3000) - 500, 1 + ut_random(80), 1 + ut_random(80));
+    index.moved(o);
+  }
+  Fl_Box other(10, 10, 10, 10);                           // not a child: ignored
+  index.moved(&other);
+  ok = ut_check_group_index(index, g);
+  EXPECT_TRUE(ok);
+
+  // children added, removed and reordered
+  g.begin();
+  for (int k = 0; k < 200; k++) ut_random_box();
+  g.end();
+  for (int k = 0; k < 100; k++) {
+    Fl_Widget *o = g.child(ut_random(g.children()));
+    g.remove(o);
+    delete o;
+  }
+  g.insert(*g.child(g.children() - 1), 0);
+  index.invalidate();
+  ok = ut_check_group_index(index, g);
+  EXPECT_TRUE(ok);
+  return true;
+}
+
+/* Resizing a child whose parent() is not a group (Fl_Value_Input's input)
+   must not call the Fl_Group methods that notify the parent. */
+TEST(Fl_Group_Index, NonGroupParent) {
+  Fl_Group g(0, 0, 200, 100);
+  Fl_Value_Input *vi = new Fl_Value_Input(10, 10, 80, 25);
+  g.end();
+  g.spatial_index(1);
+  vi->resize(20, 20, 100, 30);
+  g.resize(0, 0, 400, 200);
+  EXPECT_EQ(vi->w(), 200);
+  return true;
+}
+
+// Compares find() and the children of the group with the expected children
+static bool ut_check_group_children(const Fl_Group &g, const std::vector<Fl_Widget *> &expected) {
+  EXPECT_EQ(g.children(), (int)expected.size());
+  for (int i = 0; i < g.children(); i++) {
+    EXPECT_TRUE(g.child(i) == expected[i]);
+    EXPECT_EQ(g.find(expected[i]), i);
+  }
+  return true;
+}
+
+// Counts the children deleted by clear() and refuses to delete one child
+class Ut_Keep_Group : public Fl_Group {
+public:
+  Fl_Widget *keep;
+  int deleted;
+  Ut_Keep_Group(int X, int Y, int W, int H) : Fl_Group(X, Y, W, H), keep(0), deleted(0) { }
+  int delete_child(int n) override {
+    if (n >= 0 && n < children() && child(n) == keep)
+      return 2;
+    deleted++;
+    return Fl_Group::delete_child(n);
+  }
+};
+
+/* Index hints of the children, see Fl_Group::find(). */
+TEST(Fl_Group, IndexHint) {
+  Ut_Keep_Group g(0, 0, 100, 100);
+  g.end();
+  std::vector<Fl_Widget *> expected;
+  ut_seed = 1;
+  for (int k = 0; k < 2000; k++) {
+    int n = (int)expected.size();
+    int op = ut_random(6);
+    if (op == 0 || n < 10) {                  // insert anywhere
+      Fl_Widget *o = new Fl_Box(0, 0, 10, 10);
+      int i = ut_random(n + 1);
+      g.insert(*o, i);
+      expected.insert(expected.begin() + i, o);
+    } else if (op == 1) {                     // remove anywhere
+      int i = ut_random(n);
+      Fl_Widget *o = expected[i];
+      g.remove(*o);
+      expected.erase(expected.begin() + i);
+      delete o;
+    } else if (op == 2) {                     // remove a run at the same index
+      int i = ut_random(n - 5);
+      for (int j = 0; j < 5; j++) {
+        g.remove(i);
+        delete expected[i];
+        expected.erase(expected.begin() + i);
+      }
+    } else if (op == 3) {                     // insert a run at the front
+      for (int j = 0; j < 3; j++) {
+        Fl_Widget *o = new Fl_Box(0, 0, 10, 10);
+        g.insert(*o, 0);
+        expected.insert(expected.begin(), o);
+      }
+    } else if (op == 4) {                     // move within the group
+      int from = ut_random(n), to = ut_random(n + 1);
+      Fl_Widget *o = expected[from];
+      g.insert(*o, to);
+      expected.erase(expected.begin() + from);
+      expected.insert(expected.begin() + (to > from ? to - 1 : to), o);
+    } else {                                  // add many at the end
+      Fl_Widget *w[20];
+      for (int j = 0; j < 20; j++) {
+        w[j] = new Fl_Box(0, 0, 10, 10);
+        expected.push_back(w[j]);
+      }
+      g.add_children(w, 20);
+    }
+    if (k % 50 == 0) {
+      bool ok = ut_check_group_children(g, expected);
+      EXPECT_TRUE(ok);
+    }
+  }
+  bool ok = ut_check_group_children(g, expected);
+  EXPECT_TRUE(ok);
+  Fl_Box other(0, 0, 10, 10);                 // not a child
+  EXPECT_EQ(g.find(&other), g.children());
+
+  // clear() deletes the children with delete_child(), which may refuse
+  int n = g.children();
+  g.keep = expected[n / 2];
+  g.clear();
+  EXPECT_EQ(g.deleted, n - 1);
+  expected.assign(1, g.keep);
+  ok = ut_check_group_children(g, expected);
+  EXPECT_TRUE(ok);
+  Fl_Widget *o = new Fl_Box(0, 0, 10, 10);
+  g.insert(*o, 0);
+  expected.insert(expected.begin(), o);
+  ok = ut_check_group_children(g, expected);
+  EXPECT_TRUE(ok);
+  g.keep = 0;
+  g.clear();
+  EXPECT_EQ(g.children(), 0);
+  return true;
+}
+
+static int ut_compare_rows(int a, int b, void *data) {
+  const std::vector<int> &values = *(const std::vector<int> *)data;
+  return values[a] - values[b];
+}
+
+// Checks that the selection follows the data and, unless 'sorted' is 0,
+// that the rows are sorted in ascending (1) or descending (-1) order
+static bool ut_check_table_rows(Fl_Table_Row &table, const std::vector<int> &values,
+                                const std::vector<bool> &selected, int sorted) {
+  int n = table.rows();
+  EXPECT_EQ(n, (int)values.size());
+  std::vector<bool> shown(n, false);
+  for (int r = 0; r < n; r++) {
+    int i = table.row_index(r);
+    EXPECT_TRUE(i >= 0 && i < n && !shown[i]);
+    shown[i] = true;
+    EXPECT_EQ(table.row_selected(r), (int)selected[i]);
+    if (sorted && r > 0) {
+      int c = values[table.row_index(r - 1)] - values[i];
+      EXPECT_TRUE(sorted > 0 ? c <= 0 : c >= 0);
+    }
+  }
+  return true;
+}
+
+/* Sorted rows of Fl_Table_Row, see Fl_Table_Row::sort_rows(). */
+TEST(Fl_Table_Row, SortSelection) {
+  Fl_Table_Row table(0, 0, 200, 200);
+  table.end();
+  std::vector<int> values;
+  std::vector<bool> selected;
+  ut_seed = 1;
+  table.rows(500);
+  for (int i = 0; i < 500; i++) {
+    values.push_back(ut_random(100));
+    selected.push_back(ut_random(3) == 0);
+    if (selected[i]) table.select_row(i);
+  }
+  for (int r = 0; r < 500; r++) {
+    EXPECT_EQ(table.row_index(r), r);
+  }
+  bool ok = ut_check_table_rows(table, values, selected, 0);
+  EXPECT_TRUE(ok);
+  table.sort_rows(ut_compare_rows, &values);
+  ok = ut_check_table_rows(table, values, selected, 1);
+  EXPECT_TRUE(ok);
+
+  // select some sorted rows, stored with their data
+  for (int r = 0; r < 500; r += 7) {
+    int sel = ut_random(2);
+    table.select_row(r, sel);
+    selected[table.row_index(r)] = sel != 0;
+  }
+  table.sort_rows(ut_compare_rows, &values, 1);
+  ok = ut_check_table_rows(table, values, selected, -1);
+  EXPECT_TRUE(ok);
+
+  // grow: new data rows are shown at the end, not selected
+  std::vector<int> order;
+  for (int r = 0; r < 500; r++) order.push_back(table.row_index(r));
+  table.rows(600);
+  for (int i = 500; i < 600; i++) {
+    values.push_back(ut_random(100));
+    selected.push_back(false);
+  }
+  for (int r = 0; r < 600; r++) {
+    EXPECT_EQ(table.row_index(r), r < 500 ? order[r] : r);
+  }
+  ok = ut_check_table_rows(table, values, selected, 0);
+  EXPECT_TRUE(ok);
+  table.sort_rows(ut_compare_rows, &values);
+  ok = ut_check_table_rows(table, values, selected, 1);
+  EXPECT_TRUE(ok);
+
+  // shrink: the data rows >= 300 are removed, the others keep their order
+  order.clear();
+  for (int r = 0; r < 600; r++)
+    if (table.row_index(r) < 300) order.push_back(table.row_index(r));
+  table.rows(300);
+  values.resize(300);
+  selected.resize(300);
+  EXPECT_EQ((int)order.size(), 300);
+  for (int r = 0; r < 300; r++) {
+    EXPECT_EQ(table.row_index(r), order[r]);
+  }
+  ok = ut_check_table_rows(table, values, selected, 1);
+  EXPECT_TRUE(ok);
+
+  // unsort: the data order again, the selection stays with the data
+  table.unsort_rows();
+  for (int r = 0; r < 300; r++) {
+    EXPECT_EQ(table.row_index(r), r);
+  }
+  ok = ut_check_table_rows(table, values, selected, 0);
+  EXPECT_TRUE(ok);
+  return true;
+}
+
+// Returns the label or text in lower case if the search is case insensitive
+static std::string ut_fold(const std::string &s, bool caseinsensitive) {
+  std::string out(s);
+  if (caseinsensitive)
+    for (size_t i = 0; i < out.size(); i++)
+      if (out[i] >= 'A' && out[i] <= 'Z') out[i] = char(out[i] - 'A' + 'a');
+  return out;
+}
+
+// Compares match() with a search of all labels, 'state' is the
+// matched() state of the previous call or empty before the first call
+static bool ut_check_filter(Fl_Filter_Index &index, const std::vector<std::string> &labels,
+                            const std::string &text, std::vector<char> &state) {
+  std::vector<int> changed, expected;
+  int count = index.match(text.c_str(), changed);
+  std::string t = ut_fold(text, index.caseinsensitive());
+  int n = 0;
+  bool first = state.empty();
+  state.resize(labels.size());
+  for (int i = 0; i < (int)labels.size(); i++) {
+    char m = ut_fold(labels[i], index.caseinsensitive()).find(t) != std::string::npos;
+    n += m;
+    EXPECT_EQ(index.matched(i), (int)m);
+    if (first || state[i] != m) expected.push_back(i);
+    state[i] = m;
+  }
+  EXPECT_EQ(count, n);
+  EXPECT_TRUE(changed == expected);
+  return true;
+}
+
+/* Search of the labels of Fl_Browser::filter() and Fl_Tree::filter(). */
+TEST(Fl_Filter_Index, NarrowWiden) {
+  static const char *queries[] = {
+    "a", "ab", "abA", "abAc", "abA", "ab", "b", "bc", "", "c", "ca", "cab", "ba", "Cab", "x", ""
+  };
+  ut_seed = 1;
+  std::vector<std::string> labels;
+  for (int i = 0; i < 1000; i++) {
+    std::string label;
+    int len = ut_random(13);
+    for (int j = 0; j < len; j++)
+      label += "abcABC "[ut_random(7)];
+    labels.push_back(label);
+  }
+  for (int ci = 0; ci < 2; ci++) {
+    Fl_Filter_Index index(ci != 0);
+    for (int i = 0; i < (int)labels.size(); i++)
+      index.add((void *)&labels[i], labels[i].c_str());
+    EXPECT_EQ(index.size(), (int)labels.size());
+    EXPECT_TRUE(index.item(7) == &labels[7]);
+    std::vector<char> state;
+    for (int k = 0; k < (int)(sizeof(queries) / sizeof(queries[0])); k++) {
+      bool ok = ut_check_filter(index, labels, queries[k], state);
+      EXPECT_TRUE(ok);
+    }
+    // typing and deleting random texts
+    std::string text;
+    for (int k = 0; k < 300; k++) {
+      if (text.empty() || (text.size() < 6 && ut_random(2)))
+        text += "abcABC "[ut_random(7)];
+      else
+        text.erase(text.size() - 1);
+      bool ok = ut_check_filter(index, labels, text, state);
+      EXPECT_TRUE(ok);
+    }
+    // NULL matches all items
+    std::vector<int> changed;
+    EXPECT_EQ(index.match(0, changed), (int)labels.size());
+  }
+  return true;
+}
+
+// Compares percentile() with the sorted values: the result is the upper
+// limit of the bucket of the exact percentile, at most 1/8 larger
+static bool ut_check_percentiles(const Fl_Event_Stats::Histogram &h, std::vector<long long> values) {
+  std::sort(values.begin(), values.end());
+  int n = (int)values.size();
+  for (int k = 0; k <= 100; k++) {
+    int rank = (int)ceil(k / 100.0 * n);
+    long long exact = values[rank < 1 ? 0 : rank - 1];
+    long long p = h.percentile(k);
+    EXPECT_TRUE(p >= exact);
+    EXPECT_TRUE(p <= exact + exact / 8);
+    EXPECT_TRUE(p >= h.min() && p <= h.max());
+  }
+  return true;
+}
+
+/* Histogram buckets of the event loop statistics. */
+TEST(Fl_Event_Stats, HistogramBuckets) {
+  Fl_Event_Stats::Histogram h;
+  EXPECT_EQ((int)h.count(), 0);
+  EXPECT_TRUE(h.percentile(50.0) == 0);
+
+  // values below 16 are exact, larger values are at most 1/8 too large
+  std::vector<long long> values;
+  for (long long v = 0; v < 16; v++) {
+    h.clear();
+    h.record(v);
+    h.record(1000000);
+    EXPECT_TRUE(h.percentile(50.0) == v);
+  }
+  for (long long v = 16; v < 100000000000LL; v += 1 + v / 5) {
+    h.clear();
+    h.record(v);
+    h.record(v * 4);
+    long long p = h.percentile(50.0);
+    EXPECT_TRUE(p >= v && p <= v + v / 8);
+  }
+  // 8 buckets per power of two: the last value of a bucket and the next one
+  for (int e = 4; e < 40; e++) {
+    long long width = 1LL << (e - 3);
+    for (int sub = 0; sub < 8; sub++) {
+      long long last = (sub + 9) * width - 1;
+      h.clear();
+      h.record(last);
+      h.record(last * 4);
+      EXPECT_TRUE(h.percentile(50.0) == last);
+      h.clear();
+      h.record(last + 1);
+      h.record(last * 4);
+      EXPECT_TRUE(h.percentile(50.0) == last + (sub < 7 ? width : 2 * width));
+    }
+  }
+
+  // negative values count as 0, huge values in the last bucket
+  h.clear();
+  h.record(-5);
+  h.record(1LL << 62);
+  EXPECT_TRUE(h.min() == 0);
+  EXPECT_TRUE(h.percentile(50.0) == 0);
+  EXPECT_TRUE(h.percentile(100.0) == 1LL << 62);
+
+  // random durations
+  h.clear();
+  ut_seed = 1;
+  for (int i = 0; i < 5000; i++) {
+    long long v = (long long)ut_random(1000) << ut_random(30);
+    values.push_back(v);
+    h.record(v);
+  }
+  EXPECT_EQ((int)h.count(), 5000);
+  EXPECT_TRUE(h.min() == *std::min_element(values.begin(), values.end()));
+  EXPECT_TRUE(h.max() == *std::max_element(values.begin(), values.end()));
+  bool ok = ut_check_percentiles(h, values);
+  EXPECT_TRUE(ok);
+  return true;
+}
+
+// State of the tasks of the Fl_Task_Pool tests
+struct Ut_Task {
+  std::atomic<int> started, finished, cancelled;
+  int done;                             // main thread only
+  Ut_Task() : started(0), finished(0), cancelled(0), done(0) { }
+};
+
+static std::atomic<int> ut_running(0);
+static std::atomic<bool> ut_release(false);
+
+// Returns after 'n' tasks ran at the same time, or after 2 seconds
+static void ut_parallel_work(void *data) {
+  Ut_Task *task = (Ut_Task *)data;
+  task->started++;
+  ut_running++;
+  for (int i = 0; i < 200 && ut_running < 4; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  if (ut_running >= 4) task->finished++;
+}
+
+// Returns when the task is cancelled or released
+static void ut_blocking_work(void *data) {
+  Ut_Task *task = (Ut_Task *)data;
+  task->started++;
+  for (int i = 0; i < 500 && !ut_release && !Fl_Task_Pool::cancelled(); i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  if (Fl_Task_Pool::cancelled()) task->cancelled++;
+  task->finished++;
+}
+
+static void ut_work(void *data) {
+  ((Ut_Task *)data)->started++;
+  ((Ut_Task *)data)->finished++;
+}
+
+static void ut_done(void *data) {
+  ((Ut_Task *)data)->done++;
+}
+
+// Runs the event loop until 'count' reaches 'n' or 5 seconds passed
+static bool ut_wait_for(const int &count, int n) {
+  Fl_Timestamp start = Fl::now();
+  while (count < n && Fl::seconds_since(start) < 5.0)
+    Fl::wait(0.01);
+  return count >= n;
+}
+
+static bool ut_wait_for(const std::atomic<int> &count, int n) {
+  Fl_Timestamp start = Fl::now();
+  while (count < n && Fl::seconds_since(start) < 5.0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return count >= n;
+}
+
+/* Tasks queued at once run in parallel, also if a worker is idle. */
+TEST(Fl_Task_Pool, Burst) {
+  Fl_Task_Pool::shutdown();
+  Fl_Task_Pool::threads(4);
+  Ut_Task first;                        // leaves an idle worker
+  EXPECT_TRUE(Fl::run_async(ut_work, &first, ut_done) != 0);
+  bool ok = ut_wait_for(first.done, 1);
+  EXPECT_TRUE(ok);
+  Ut_Task tasks[4];
+  ut_running = 0;
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(Fl::run_async(ut_parallel_work, &tasks[i], ut_done) != 0);
+  }
+  for (int i = 0; i < 4; i++) {
+    ok = ut_wait_for(tasks[i].done, 1);
+    EXPECT_TRUE(ok);
+    EXPECT_EQ((int)tasks[i].finished, 1);
+  }
+  Fl_Task_Pool::shutdown();
+  return true;
+}
+
+/* Cancelled tasks, see Fl_Task_Pool::cancel(). */
+TEST(Fl_Task_Pool, Cancel) {
+  Fl_Task_Pool::shutdown();
+  Fl_Task_Pool::threads(1);
+  ut_release = false;
+
+  // a running and a queued task
+  Ut_Task running, queued, last;
+  unsigned int id1 = Fl::run_async(ut_blocking_work, &running, ut_done);
+  unsigned int id2 = Fl::run_async(ut_work, &queued, ut_done);
+  EXPECT_TRUE(id1 != 0 && id2 != 0 && id1 != id2);
+  bool ok = ut_wait_for(running.started, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(Fl_Task_Pool::pending(), 1);
+  EXPECT_EQ(Fl_Task_Pool::cancel(id2), 1);
+  EXPECT_EQ(Fl_Task_Pool::pending(), 0);
+  EXPECT_EQ(Fl_Task_Pool::cancel(id2), 0);
+  EXPECT_EQ(Fl_Task_Pool::cancel(id1), 1);
+  EXPECT_EQ(Fl_Task_Pool::cancel(id1), 0);      // already cancelled
+  EXPECT_TRUE(Fl::run_async(ut_work, &last, ut_done) != 0);
+  ok = ut_wait_for(last.done, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ((int)running.cancelled, 1);
+  EXPECT_EQ(running.done, 0);
+  EXPECT_EQ((int)queued.started, 0);
+  EXPECT_EQ(queued.done, 0);
+
+  // tasks of an owner that is deleted, and of one that is not
+  Fl_Box *owner = new Fl_Box(0, 0, 10, 10);
+  Fl_Box other(0, 0, 10, 10);
+  Ut_Task owned1, owned2, owned3, kept;
+  EXPECT_TRUE(Fl::run_async(ut_blocking_work, &owned1, ut_done, owner) != 0);
+  ok = ut_wait_for(owned1.started, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_TRUE(Fl::run_async(ut_work, &owned2, ut_done, owner) != 0);
+  EXPECT_TRUE(Fl::run_async(ut_work, &kept, ut_done, &other) != 0);
+  EXPECT_TRUE(Fl::run_async(ut_work, &owned3, ut_done, owner, Fl_Task_Pool::HIGH) != 0);
+  EXPECT_EQ(Fl_Task_Pool::pending(Fl_Task_Pool::HIGH), 1);
+  EXPECT_EQ(Fl_Task_Pool::pending(), 3);
+  delete owner;
+  EXPECT_EQ(Fl_Task_Pool::pending(), 1);
+  ok = ut_wait_for(kept.done, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ((int)owned1.cancelled, 1);
+  EXPECT_EQ(owned1.done + owned2.done + owned3.done, 0);
+  EXPECT_EQ((int)owned2.started + (int)owned3.started, 0);
+  EXPECT_EQ(Fl_Task_Pool::cancel(&other), 0);
+
+  // cancel(owner) of a running task
+  Ut_Task owned4;
+  EXPECT_TRUE(Fl::run_async(ut_blocking_work, &owned4, ut_done, &other) != 0);
+  ok = ut_wait_for(owned4.started, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ(Fl_Task_Pool::cancel(&other), 1);
+  ok = ut_wait_for(owned4.finished, 1);
+  EXPECT_TRUE(ok);
+  EXPECT_EQ((int)owned4.cancelled, 1);
+  Fl_Task_Pool::shutdown();
+  EXPECT_EQ(owned4.done, 0);
+  Fl_Task_Pool::threads(4);
+  return true;
+}
+
+// Operations applied by the main thread
+struct Ut_Applied {
+  int calls;
+  std::vector<Fl_Update_Queue::Op> ops;
+  std::vector<std::string> strs;
+  Ut_Applied() : calls(0) { }
+};
+
+static void ut_apply(void *target, const Fl_Update_Queue::Op *ops, int n) {
+  Ut_Applied *applied = (Ut_Applied *)target;
+  applied->calls++;
+  for (int i = 0; i < n; i++) {
+    applied->ops.push_back(ops[i]);
+    applied->strs.push_back(ops[i].str ? ops[i].str : "");
+  }
+}
+
+// Posts 500 operations from a thread, some with a string
+static void ut_post_ops(Fl_Update_Queue **q, Ut_Applied *applied, int thread) {
+  for (int i = 0; i < 500; i++) {
+    char str[20];
+    snprintf(str, sizeof(str), "%d-%d", thread, i);
+    Fl_Update_Queue::post(*q, applied, ut_apply, Fl_Update_Queue::ADD,
+                          thread, i, 0.5, 0, i % 3 ? 0 : str);
+  }
+}
+
+static void ut_count_modify(int, int, int, int, const char *, void *data) {
+  (*(int *)data)++;
+}
+
+/* Model updates posted by other threads, see Fl_Text_Buffer::post_text(). */
+TEST(Fl_Update_Queue, OrderCoalesce) {
+  Fl_Update_Queue *q = 0;
+  Ut_Applied applied;
+  EXPECT_EQ(Fl_Update_Queue::pending(q), 0);
+  Fl_Update_Queue::flush(q);                    // no queue yet
+
+  // all operations of all threads are applied at once, in posting order
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+    threads.push_back(std::thread(ut_post_ops, &q, &applied, t));
+  for (int t = 0; t < 4; t++)
+    threads[t].join();
+  EXPECT_TRUE(q != 0);
+  EXPECT_EQ(Fl_Update_Queue::pending(q), 2000);
+  EXPECT_EQ(applied.calls, 0);
+  Fl_Update_Queue::flush(q);
+  EXPECT_EQ(Fl_Update_Queue::pending(q), 0);
+  EXPECT_EQ(applied.calls, 1);
+  EXPECT_EQ((int)applied.ops.size(), 2000);
+  int next[4] = { 0, 0, 0, 0 };
+  for (size_t i = 0; i < applied.ops.size(); i++) {
+    const Fl_Update_Queue::Op &op = applied.ops[i];
+    EXPECT_TRUE(op.i1 >= 0 && op.i1 < 4);
+    EXPECT_EQ(op.i2, next[op.i1]);
+    next[op.i1]++;
+    char str[20];
+    snprintf(str, sizeof(str), "%d-%d", op.i1, op.i2);
+    EXPECT_TRUE(applied.strs[i] == (op.i2 % 3 ? "" : str));
+  }
+  Fl_Update_Queue::flush(q);                    // nothing pending
+  EXPECT_EQ(applied.calls, 1);
+
+  // pending operations are discarded with the queue
+  Fl_Update_Queue::post(q, &applied, ut_apply, Fl_Update_Queue::CLEAR);
+  Fl_Update_Queue::destroy(q);
+  EXPECT_TRUE(q == 0);
+  EXPECT_EQ(applied.calls, 1);
+
+  // consecutive appends of a text buffer are inserted at once
+  Fl_Text_Buffer buf;
+  int modified = 0;
+  buf.add_modify_callback(ut_count_modify, &modified);
+  buf.post_text("world");
+  buf.post_insert(0, "hello ");
+  for (int i = 0; i < 10; i++)
+    buf.post_append(i % 2 ? "b" : "a");
+  buf.post_remove(0, 6);
+  buf.post_append("!");
+  buf.post_append("!");
+  EXPECT_EQ(buf.posted(), 15);
+  EXPECT_EQ(buf.length(), 0);
+  buf.apply_posted();
+  EXPECT_EQ(buf.posted(), 0);
+  char *text = buf.text();
+  std::string result(text);
+  free(text);
+  EXPECT_TRUE(result == "worldababababab!!");
+  EXPECT_EQ(modified, 5);
+  return true;
+}
+
+// Idle jobs of the Fl_Idle_Scheduler test append their name to 'ut_job_log'
+static std::string ut_job_log;
+static unsigned int ut_job_c = 0;           // lowered by job 'A' when set
+
+static int ut_idle_job(void *data) {
+  char name = (char)(fl_intptr_t)data;
+  ut_job_log += name;
+  if (name == 'A' && ut_job_c) {
+    Fl_Idle_Scheduler::priority(ut_job_c, -1);
+    ut_job_c = 0;
+  }
+  return 1;
+}
+
+static unsigned int ut_add_job(char name, int priority) {
+  return Fl_Idle_Scheduler::add(ut_idle_job, (void *)(fl_intptr_t)name, priority, 0.0);
+}
+
+// Runs 'n' event loop iterations, returns the names of the jobs that ran
+static std::string ut_run_jobs(int n) {
+  ut_job_log.clear();
+  for (int i = 0; i < n; i++)
+    Fl::wait(0.0);
+  return ut_job_log;
+}
+
+/* Priorities and round-robin order of idle jobs. */
+TEST(Fl_Idle_Scheduler, PriorityRoundRobin) {
+  double total = Fl_Idle_Scheduler::total_budget();
+  Fl_Idle_Scheduler::total_budget(1.0);
+  unsigned int a = ut_add_job('A', 0);
+  unsigned int b = ut_add_job('B', 0);
+  unsigned int c = ut_add_job('C', 0);
+  unsigned int h = ut_add_job('H', 5);
+  EXPECT_EQ(Fl_Idle_Scheduler::count(), 4);
+  EXPECT_TRUE(ut_run_jobs(1) == "HABC");    // all jobs, higher priority first
+
+  // one job per iteration: the highest priority, then round-robin
+  Fl_Idle_Scheduler::total_budget(0.0);
+  EXPECT_TRUE(ut_run_jobs(3) == "HHH");
+  EXPECT_EQ(Fl_Idle_Scheduler::remove(h), 1);
+  EXPECT_EQ(Fl_Idle_Scheduler::remove(h), 0);
+  EXPECT_TRUE(ut_run_jobs(6) == "ABCABC");
+  unsigned int d = ut_add_job('D', 0);      // behind the jobs of its priority
+  EXPECT_TRUE(ut_run_jobs(4) == "ABCD");
+  Fl_Idle_Scheduler::priority(d, 1);
+  EXPECT_EQ(Fl_Idle_Scheduler::priority(d), 1);
+  EXPECT_TRUE(ut_run_jobs(2) == "DD");
+  Fl_Idle_Scheduler::priority(d, 0);        // keeps its place in the order
+  EXPECT_TRUE(ut_run_jobs(5) == "DABCD");
+
+  // a priority changed by a running job keeps the round-robin order
+  ut_job_c = c;
+  EXPECT_TRUE(ut_run_jobs(1) == "A");
+  EXPECT_EQ(Fl_Idle_Scheduler::priority(c), -1);
+  EXPECT_TRUE(ut_run_jobs(4) == "BDAB");
+  Fl_Idle_Scheduler::total_budget(1.0);
+  EXPECT_TRUE(ut_run_jobs(1) == "DABC");
+
+  Fl_Idle_Scheduler::remove(a);
+  Fl_Idle_Scheduler::remove(b);
+  Fl_Idle_Scheduler::remove(c);
+  Fl_Idle_Scheduler::remove(d);
+  EXPECT_EQ(Fl_Idle_Scheduler::count(), 0);
+  EXPECT_TRUE(ut_run_jobs(1) == "");
+  Fl_Idle_Scheduler::total_budget(total);
+  return true;
+}
+
+// Compares the sizes, positions and find() with the expected sizes
+static bool ut_check_table_sizes(const Fl_Table_Sizes &sizes, const std::vector<int> &expected) {
+  int n = (int)expected.size();
+  EXPECT_EQ(sizes.count(), n);
+  std::vector<long> pos(n + 1, 0);
+  for (int i = 0; i < n; i++)
+    pos[i + 1] = pos[i] + expected[i];
+  EXPECT_TRUE(sizes.total() == pos[n]);
+  for (int i = 0; i <= n; i++) {
+    if (i < n) {
+      EXPECT_EQ(sizes.size(i), expected[i]);
+    }
+    EXPECT_TRUE(sizes.position(i) == pos[i]);
+  }
+  // find(): the first entry whose end is greater than the position
+  for (int k = 0; k < 200 && pos[n] > 0; k++) {
+    long p = k < 100 ? pos[ut_random(n + 1)] + ut_random(3) - 1 : (long)ut_random((int)pos[n] + 2) - 1;
+    int i = 0;
+    if (p < 0) i = 0;
+    else while (i < n && pos[i + 1] <= p) i++;
+    EXPECT_EQ(sizes.find(p), i);
+  }
+  return true;
+}
+
+// Fl_Table with access to the virtual table size
+class Ut_Table : public Fl_Table {
+public:
+  Ut_Table(int X, int Y, int W, int H) : Fl_Table(X, Y, W, H) { }
+  using Fl_Table::row_scroll_position;
+  using Fl_Table::col_scroll_position;
+  int virtual_h() const { return table_h; }
+  int virtual_w() const { return table_w; }
+  void vscroll(int v) { vscrollbar->value(v); vscrollbar->do_callback(); }
+};
+
+/* Row heights of Fl_Table, stored sparsely or in a dense array. */
+TEST(Fl_Table_Sizes, SparseDense) {
+  Fl_Table_Sizes sizes;
+  std::vector<int> expected;
+  ut_seed = 1;
+  bool ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+  sizes.resize(3000, 25);
+  expected.assign(3000, 25);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // a few different sizes (sparse), some of them 0, and back to the default
+  for (int k = 0; k < 60; k++) {
+    int i = ut_random(3000), v = ut_random(4) ? ut_random(60) : 0;
+    sizes.size(i, v);
+    expected[i] = v;
+    ok = ut_check_table_sizes(sizes, expected);
+    EXPECT_TRUE(ok);
+  }
+  for (int i = 0; i < 3000; i += 2) {
+    sizes.size(i, 25);
+    expected[i] = 25;
+  }
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // grow with another size, shrink
+  sizes.resize(3500, 40);
+  expected.resize(3500, 40);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+  sizes.resize(2000, 40);
+  expected.resize(2000);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // many different sizes (dense)
+  for (int k = 0; k < 1000; k++) {
+    int i = ut_random(2000), v = ut_random(60);
+    sizes.size(i, v);
+    expected[i] = v;
+    if (k % 100 == 0) {
+      ok = ut_check_table_sizes(sizes, expected);
+      EXPECT_TRUE(ok);
+    }
+  }
+  sizes.resize(2500, 10);
+  expected.resize(2500, 10);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+  sizes.resize(1200, 10);
+  expected.resize(1200);
+  sizes.size(5, 0);
+  expected[5] = 0;
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // fill() goes back to sparse storage
+  sizes.fill(30);
+  expected.assign(1200, 30);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+  sizes.size(1199, 1);
+  expected[1199] = 1;
+  sizes.resize(0, 0);
+  expected.clear();
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // a single entry changes the default, adding many different ones at once
+  sizes.resize(1, 20);
+  sizes.size(0, 15);
+  sizes.resize(500, 7);
+  expected.assign(1, 15);
+  expected.resize(500, 7);
+  ok = ut_check_table_sizes(sizes, expected);
+  EXPECT_TRUE(ok);
+
+  // the table size is calculated once by end_update()
+  Ut_Table table(0, 0, 200, 200);
+  table.end();
+  table.begin_update();
+  table.rows(1000);
+  table.row_height_all(20);
+  table.begin_update();
+  table.row_height(5, 100);
+  table.end_update();
+  EXPECT_EQ(table.virtual_h(), 0);
+  EXPECT_TRUE(table.updating() != 0);
+  table.end_update();
+  EXPECT_TRUE(table.updating() == 0);
+  EXPECT_EQ(table.virtual_h(), 999 * 20 + 100);
+  return true;
+}
+
+/* Scroll positions of the rows and columns of Fl_Table. */
+TEST(Fl_Table, ScrollPositions) {
+  Ut_Table table(0, 0, 200, 200);
+  table.end();
+  table.rows(1000000);
+  table.row_height_all(17);
+  table.cols(300);
+  table.col_width_all(80);
+  EXPECT_TRUE(table.row_scroll_position(999999) == 999999L * 17);
+  EXPECT_EQ(table.virtual_h(), 1000000 * 17);
+  EXPECT_EQ(table.virtual_w(), 300 * 80);
+
+  // different sizes
+  std::vector<int> heights(1000000, 17), widths(300, 80);
+  ut_seed = 1;
+  for (int k = 0; k < 2000; k++) {
+    int r = ut_random(1000000), h = ut_random(50);
+    table.row_height(r, h);
+    heights[r] = h;
+    int c = ut_random(300), w = ut_random(200);
+    table.col_width(c, w);
+    widths[c] = w;
+  }
+  long pos = 0;
+  for (int r = 0; r < 1000000; r++) {
+    if (r % 997 == 0 || heights[r] != 17) {
+      EXPECT_TRUE(table.row_scroll_position(r) == pos);
+      EXPECT_EQ(table.row_height(r), heights[r]);
+    }
+    pos += heights[r];
+  }
+  EXPECT_EQ(table.virtual_h(), (int)pos);
+  pos = 0;
+  for (int c = 0; c < 300; c++) {
+    EXPECT_TRUE(table.col_scroll_position(c) == pos);
+    EXPECT_EQ(table.col_width(c), widths[c]);
+    pos += widths[c];
+  }
+  EXPECT_EQ(table.virtual_w(), (int)pos);
+
+  // the height of a row beyond the last row is stored for later
+  table.rows(10);
+  table.row_height(20, 50);
+  EXPECT_EQ(table.row_height(20), 50);
+  EXPECT_EQ(table.row_height(9), heights[9]);
+  table.rows(30);
+  EXPECT_EQ(table.row_height(20), 50);
+  return true;
+}
+
+/* Path index of Fl_Menu_::find_index(const char*). */
+TEST(Fl_Menu_, FindPath) {
+  Fl_Menu_Item items[] = {              // not copied: labels can be changed
+    { "File", 0, 0, 0, FL_SUBMENU },
+      { "Open" },
+      { "Save" },
+      { "Recent", 0, 0, 0, FL_SUBMENU },
+        { "a.txt" },
+        { 0 },
+      { 0 },
+    { "Edit", 0, 0, 0, FL_SUBMENU },
+      { "Copy" },
+      { 0 },
+    { "Quit" },
+    { 0 }
+  };
+  Fl_Menu_Button menu(0, 0, 100, 25);
+  menu.menu(items);
+  const Fl_Menu_Item *save = menu.find_item("File/Save");
+  EXPECT_TRUE(save != 0 && !strcmp(save->label(), "Save"));
+  EXPECT_TRUE(menu.find_item("File/Recent") != 0);
+  EXPECT_TRUE(menu.find_item("File/Recent/a.txt") != 0);
+  EXPECT_EQ(menu.find_index("Quit"), menu.find_index(menu.find_item("Quit")));
+  EXPECT_EQ(menu.find_index("Edit/Paste"), -1);
+  EXPECT_EQ(menu.find_index("Save"), -1);
+
+  // renamed items are found by their new pathname only
+  ((Fl_Menu_Item *)save)->label("Save As");
+  EXPECT_TRUE(menu.find_item("File/Save As") == save);
+  EXPECT_TRUE(menu.find_item("File/Save") == 0);
+  ((Fl_Menu_Item *)menu.find_item("File/Recent/a.txt"))->label("b.txt");
+  EXPECT_TRUE(menu.find_item("File/Recent/a.txt") == 0);
+  EXPECT_TRUE(menu.find_item("File/Recent/b.txt") != 0);
+
+  // changed with the API
+  menu.replace(menu.find_index("Edit/Copy"), "Cut");
+  EXPECT_EQ(menu.find_index("Edit/Copy"), -1);
+  EXPECT_TRUE(menu.find_item("Edit/Cut") != 0);
+  menu.add("Edit/Copy");
+  EXPECT_EQ(menu.find_index("Edit/Copy"), menu.find_index("Edit/Cut") + 1);
+  menu.clear();
+  EXPECT_EQ(menu.find_index("Edit/Copy"), -1);
+  return true;
+}
+
+// Count the valid tiles of a retained widget
+static int ut_valid_tiles(Fl_Retained_Tiles &tiles) {
+  int n = 0;
+  for (int r = 0; r < tiles.rows; r++)
+    for (int c = 0; c < tiles.cols; c++)
+      if (tiles.tile(r, c).valid) n++;
+  return n;
+}
+
+// Tile invalidation and damage merging of Fl_Retained_Cache
+TEST(Fl_Retained_Cache, TileDamage) {
+  const int T = Fl_Retained_Tiles::TILE_SIZE;
+  Fl_Retained_Tiles tiles;
+  EXPECT_EQ(tiles.resize(3 * T, 2 * T + 10, 1.0f), 1);
+  EXPECT_EQ(tiles.cols, 3);
+  EXPECT_EQ(tiles.rows, 3);
+  EXPECT_EQ(tiles.resize(3 * T, 2 * T + 10, 1.0f), 0);
+
+  // one tile visible: the damage bits of the widget are kept
+  uchar d = tiles.damage(FL_DAMAGE_EXPOSE, 10, 10, 100, 100);
+  EXPECT_EQ(d, FL_DAMAGE_EXPOSE);
+  EXPECT_EQ(tiles.c0, 0);
+  EXPECT_EQ(tiles.c1, 0);
+  EXPECT_EQ(tiles.r1, 0);
+  for (int r = 0; r < tiles.rows; r++)
+    for (int c = 0; c < tiles.cols; c++)
+      tiles.tile(r, c).valid = true;
+
+  // no damage: the visible tiles are copied, hidden tiles stay valid
+  d = tiles.damage(0, T - 10, 0, 20, 20);
+  EXPECT_EQ(d, 0);
+  EXPECT_EQ(tiles.c0, 0);
+  EXPECT_EQ(tiles.c1, 1);
+  EXPECT_EQ(ut_valid_tiles(tiles), 9);
+
+  // damage in one tile invalidates all hidden tiles
+  d = tiles.damage(FL_DAMAGE_CHILD, T + 1, T + 1, 10, 10);
+  EXPECT_EQ(d, FL_DAMAGE_CHILD);
+  EXPECT_EQ(ut_valid_tiles(tiles), 1);
+  EXPECT_TRUE(tiles.tile(1, 1).valid);
+  EXPECT_TRUE(tiles.visible(1, 1) && !tiles.visible(0, 1) && !tiles.visible(1, 2));
+
+  // damage across tiles and scrolling draw everything
+  d = tiles.damage(FL_DAMAGE_EXPOSE, T - 1, T - 1, 2, 2);
+  EXPECT_EQ(d, FL_DAMAGE_ALL);
+  EXPECT_EQ(tiles.r0, 0);
+  EXPECT_EQ(tiles.r1, 1);
+  d = tiles.damage(FL_DAMAGE_SCROLL, 0, 0, 10, 10);
+  EXPECT_EQ(d, FL_DAMAGE_ALL);
+  d = tiles.damage(FL_DAMAGE_USER1, 0, 2 * T, 3 * T, 10);
+  EXPECT_EQ(d, FL_DAMAGE_ALL);
+  EXPECT_EQ(tiles.c1, 2);
+  EXPECT_EQ(tiles.r0, 2);
+
+  // nothing visible
+  d = tiles.damage(FL_DAMAGE_ALL, 0, 0, 0, 0);
+  EXPECT_TRUE(tiles.c1 < tiles.c0 && tiles.r1 < tiles.r0);
+  EXPECT_EQ(ut_valid_tiles(tiles), 0);
+
+  // a new size or scale deletes the tiles
+  tiles.tile(0, 0).valid = true;
+  EXPECT_EQ(tiles.resize(3 * T, 2 * T + 10, 2.0f), 1);
+  EXPECT_EQ(ut_valid_tiles(tiles), 0);
+  EXPECT_EQ(tiles.resize(T, T, 2.0f), 1);
+  EXPECT_EQ(tiles.cols * tiles.rows, 1);
+  tiles.clear();
+  EXPECT_EQ(tiles.resize(T, T, 2.0f), 1);
+  return true;
+}
+
+// A browser with n lines of height 10 that draws nothing
+class Ut_Browser : public Fl_Browser_ {
+public:
+  long n;
+  Ut_Browser(int X, int Y, int W, int H, long N) : Fl_Browser_(X, Y, W, H), n(N) { }
+  void *item_first() const FL_OVERRIDE { return n ? (void *)1 : 0; }
+  void *item_next(void *p) const FL_OVERRIDE { return (long)p < n ? (void *)((long)p + 1) : 0; }
+  void *item_prev(void *p) const FL_OVERRIDE { return (long)p > 1 ? (void *)((long)p - 1) : 0; }
+  int item_height(void *) const FL_OVERRIDE { return 10; }
+  int item_width(void *) const FL_OVERRIDE { return 500; }
+  void item_draw(void *, int, int, int, int) const FL_OVERRIDE { }
+  using Fl_Browser_::redraw_line;
+  using Fl_Browser_::redraw_lines;
+};
+
+class Ut_Text_Display : public Fl_Text_Display {
+public:
+  Ut_Text_Display(int X, int Y, int W, int H) : Fl_Text_Display(X, Y, W, H) { }
+  bool drawn_valid() const { return mDrawnValid; }
+  void drawn_valid(bool v) { mDrawnValid = v; }
+};
+
+// Damage bits set by scrolling, draw() moves the pixels for FL_DAMAGE_SCROLL
+// (Fl_Browser_, Fl_Table) or FL_DAMAGE_EXPOSE with a valid last draw
+// (Fl_Text_Display) instead of drawing everything
+TEST(Fl_Browser_, ScrollDamage) {
+  Ut_Browser browser(0, 0, 100, 100, 100);
+  browser.clear_damage();
+  browser.vposition(30);
+  EXPECT_EQ(browser.damage(), FL_DAMAGE_SCROLL);
+  browser.clear_damage();
+  browser.hposition(20);
+  EXPECT_EQ(browser.damage(), FL_DAMAGE_SCROLL);
+  browser.clear_damage();
+  browser.vposition(30);
+  EXPECT_EQ(browser.damage(), 0);
+
+  // up to two changed lines are drawn alone, more redraw all lines
+  browser.clear_damage();
+  browser.redraw_line((void *)4);
+  browser.redraw_line((void *)5);
+  EXPECT_EQ(browser.damage(), FL_DAMAGE_EXPOSE);
+  browser.redraw_line((void *)6);
+  EXPECT_EQ(browser.damage(), FL_DAMAGE_EXPOSE | FL_DAMAGE_SCROLL);
+
+  // scrolling doesn't reduce pending damage
+  browser.clear_damage();
+  browser.redraw();
+  browser.vposition(50);
+  EXPECT_TRUE((browser.damage() & FL_DAMAGE_ALL) != 0);
+  return true;
+}
+
+TEST(Fl_Table, ScrollDamage) {
+  Ut_Table table(0, 0, 200, 200);
+  table.rows(1000);
+  table.cols(100);
+  table.row_height_all(20);
+  table.col_width_all(50);
+  table.clear_damage();
+  table.row_position(100);
+  EXPECT_EQ(table.damage() & ~FL_DAMAGE_CHILD, FL_DAMAGE_SCROLL);
+  EXPECT_EQ(table.row_position(), 100);
+  table.clear_damage();
+  table.col_position(10);
+  EXPECT_EQ(table.damage() & ~FL_DAMAGE_CHILD, FL_DAMAGE_SCROLL);
+  table.clear_damage();
+  table.vscroll(4000);
+  EXPECT_EQ(table.damage() & ~FL_DAMAGE_CHILD, FL_DAMAGE_SCROLL);
+  EXPECT_EQ(table.row_position(), 200);
+  table.redraw();
+  EXPECT_TRUE((table.damage() & FL_DAMAGE_ALL) != 0);
+  return true;
+}
+
+TEST(Fl_Text_Display, ScrollDamage) {
+  Fl_Text_Buffer *buffer = new Fl_Text_Buffer;
+  buffer->text("one\ntwo\nthree\nfour\n");
+  Ut_Text_Display display(0, 0, 300, 200);
+  display.buffer(buffer);
+
+  // changes within a line or new lines are drawn as a damage range after
+  // the text was moved, the last draw stays valid
+  display.drawn_valid(true);
+  buffer->insert(1, "x");
+  EXPECT_TRUE(display.drawn_valid());
+  buffer->insert(5, "a\nb\nc\n");
+  EXPECT_TRUE(display.drawn_valid());
+
+  // replaced lines or new styles: draw everything
+  buffer->replace(5, 11, "1\n2\n3\n");
+  EXPECT_TRUE(!display.drawn_valid());
+  display.drawn_valid(true);
+  Fl_Text_Buffer *style = new Fl_Text_Buffer;
+  static const Fl_Text_Display::Style_Table_Entry styles[] = {
+    { FL_BLACK, FL_COURIER, 12, 0, 0 }
+  };
+  display.highlight_data(style, styles, 1, 'A', 0, 0);
+  EXPECT_TRUE(!display.drawn_valid());
+
+  display.highlight_data(0, 0, 0, 'A', 0, 0);
+  display.buffer(0);
+  delete style;
+  delete buffer;
+  return true;
+}
+
+// Line allocation and cached measurements of Fl_Browser
+TEST(Fl_Browser_Store, AllocRelease) {
+  Fl_Browser_Store store;
+  EXPECT_EQ((int)Fl_Browser_Store::round(1), 8);
+  EXPECT_EQ((int)Fl_Browser_Store::round(8), 8);
+  EXPECT_EQ((int)Fl_Browser_Store::round(21), 24);
+
+  // lines are aligned for pointers, don't overlap, and keep their contents
+  std::vector<char *> lines;
+  std::vector<int> sizes;
+  ut_seed = 5;
+  for (int i = 0; i < 20000; i++) {
+    int size = 1 + ut_random(i % 50 ? 100 : 2000);
+    char *p = (char *)store.alloc(size);
+    EXPECT_EQ((int)((size_t)p % sizeof(void *)), 0);
+    memset(p, i & 0xff, size);
+    lines.push_back(p);
+    sizes.push_back(size);
+  }
+  bool ok = true;
+  for (size_t i = 0; i < lines.size(); i++)
+    for (int j = 0; j < sizes[i]; j++)
+      if (lines[i][j] != (char)(i & 0xff)) ok = false;
+  EXPECT_TRUE(ok);
+
+  // released lines are reused for lines of the same rounded size
+  char *p = lines[100];
+  int size = sizes[100];
+  store.release(p, size);
+  EXPECT_TRUE(store.alloc(Fl_Browser_Store::round(size)) == p);
+  char *large = (char *)store.alloc(1000);
+  store.release(large, 1000);
+  for (size_t i = 0; i < lines.size(); i++)
+    if (i != 100) store.release(lines[i], sizes[i]);
+  store.clear();
+  p = (char *)store.alloc(600);
+  memset(p, 1, 600);
+  store.release(p, 600);
+  p = (char *)store.alloc(16);
+  EXPECT_TRUE(p != 0);
+
+  // the generation changes with the settings, also the column widths
+  static int widths[] = { 100, 50, 0 };
+  unsigned short g = store.generation(FL_HELVETICA, 14, '@', '\t', widths);
+  EXPECT_TRUE(g != 0);
+  EXPECT_EQ(store.generation(FL_HELVETICA, 14, '@', '\t', widths), g);
+  unsigned short g2 = store.generation(FL_HELVETICA, 16, '@', '\t', widths);
+  EXPECT_TRUE(g2 != g);
+  widths[1] = 60;
+  unsigned short g3 = store.generation(FL_HELVETICA, 16, '@', '\t', widths);
+  EXPECT_TRUE(g3 != g2);
+  EXPECT_EQ(store.generation(FL_HELVETICA, 16, '@', '\t', widths), g3);
+  EXPECT_TRUE(store.generation(FL_HELVETICA, 16, 0, '\t', widths) != g3);
+
+  // never 0, also when the counter wraps around
+  bool nonzero = true;
+  for (int i = 0; i < 70000; i++)
+    if (!store.generation(FL_HELVETICA, 10 + (i & 1), '@', '\t', widths)) nonzero = false;
+  EXPECT_TRUE(nonzero);
+  return true;
+}
+
+class Ut_Tree_Item : public Fl_Tree_Item {
+public:
+  Ut_Tree_Item(Fl_Tree *tree) : Fl_Tree_Item(tree) { }
+  void hide() { set_flag(1<<1, 0); }           // Fl_Tree_Item::VISIBLE is private
+};
+
+// The items shown by Fl_Tree::filter(), "-" for hidden items
+static const char *ut_tree_visible(Fl_Tree &tree) {
+  static std::string s;
+  s.clear();
+  for (Fl_Tree_Item *item = tree.first()->next(); item; item = item->next()) {
+    s += item->visible() ? item->label() : "-";
+    s += ' ';
+  }
+  return s.c_str();
+}
+
+// Fl_Tree::filter() shows matching items and their parents
+TEST(Fl_Tree, Filter) {
+  Fl_Tree tree(0, 0, 200, 200);
+  tree.end();
+  tree.add("a/apple");
+  tree.add("a/banana");
+  tree.add("b/cherry");
+  tree.add("b/apricot");
+  Ut_Tree_Item *date = new Ut_Tree_Item(&tree);
+  date->label("date");
+  tree.add("c/date", date);
+  date->hide();                                 // hidden by the application
+  EXPECT_EQ(tree.filter("ap"), 2);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple - b - apricot - - ");
+  EXPECT_EQ(tree.filter("app"), 1);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple - - - - - - ");
+  EXPECT_EQ(tree.filter("a"), 5);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple banana b - apricot c - ");
+
+  // the filter doesn't change items hidden otherwise
+  EXPECT_EQ(tree.filter(""), 8);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple banana b cherry apricot c - ");
+  EXPECT_EQ(tree.filter("date"), 1);
+  EXPECT_STREQ(ut_tree_visible(tree), "- - - - - - c - ");
+
+  // opening and closing keeps the index, new labels and items are found
+  tree.close("a");
+  tree.open("a");
+  tree.find_item("a/banana")->label("apple pie");
+  EXPECT_EQ(tree.filter("app"), 2);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple apple pie - - - - - ");
+  tree.add("b/apple");
+  EXPECT_EQ(tree.filter("App", 1), 3);
+  EXPECT_STREQ(ut_tree_visible(tree), "a apple apple pie b - - apple - - ");
+  tree.remove(tree.find_item("a"));
+  EXPECT_EQ(tree.filter("app"), 1);
+  EXPECT_STREQ(ut_tree_visible(tree), "b - - apple - - ");
+  EXPECT_EQ(tree.filter(0), 6);
+  EXPECT_STREQ(ut_tree_visible(tree), "b cherry apricot apple c - ");
+  return true;
+}
+
+#endif // !FL_DLL